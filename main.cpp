@@ -1,12 +1,55 @@
 
 #include <iostream>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <iterator>
 #include <random>
 #include <algorithm>
 #include <type_traits>
 #include <chrono>
-#include <cassert>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <thread>
 
 #include "q_ary_search.hpp"
+#include "q_ary_search_simd.hpp"
+#include "q_ary_search_dispatch.hpp"
+#include "q_ary_interpolation_search.hpp"
+#include "q_ary_search_schedule.hpp"
+#include "q_ary_range_search.hpp"
+#include "q_ary_autotune.hpp"
+#include "q_ary_eytzinger_index.hpp"
+#include "q_ary_static_tree.hpp"
+#include "q_ary_key_column.hpp"
+#include "q_ary_compressed_blocks.hpp"
+#include "q_ary_string_index.hpp"
+#include "q_ary_numa_replicas.hpp"
+#include "q_ary_mmap_searcher.hpp"
+#include "q_ary_rcu.hpp"
+#include "q_ary_sorted_vector.hpp"
+#include "q_ary_learned_index.hpp"
+#include "q_ary_search_batch.hpp"
+#include "q_ary_search_parallel.hpp"
+#include "q_ary_instrumentation.hpp"
+#if defined( Q_ARY_SEARCH_HAVE_GPU )
+#include "q_ary_search_gpu.hpp"
+#endif
+
+
+/// Checks condition 'c' of a test, whether 'NDEBUG' is defined or not (so
+/// the tests run by the optimized builds too), and aborts, if it fails.
+/// Only reads state, so the test must not rely on its side effects.
+#define Q_ARY_CHECK( c ) \
+	( (c) ? (void)0 : q_ary_check_failed( #c, __FILE__, __LINE__ ) )
+
+[[noreturn]] void q_ary_check_failed( const char* condition, const char* file, int line )
+{
+	std::cerr << file << ":" << line << ": check failed: " << condition << std::endl;
+	std::abort();
+}
 
 
 /// Runs general tests on provided search function.
@@ -21,25 +64,25 @@ void test_search_on_sorted_int_array(
 		const int* result;
 		//
 		result = (*search_f)( a, a+n, 19 );
-		assert( result == a + 7 );
+		Q_ARY_CHECK( result == a + 7 );
 		//
 		result = (*search_f)( a, a+n, 36 );
-		assert( result == a + 12 );
+		Q_ARY_CHECK( result == a + 12 );
 		//
 		result = (*search_f)( a, a+n, 6 );
-		assert( result == a + 2 );
+		Q_ARY_CHECK( result == a + 2 );
 		//
 		result = (*search_f)( a, a+n, 20 );
-		assert( result == a + 8 );
+		Q_ARY_CHECK( result == a + 8 );
 		//
 		result = (*search_f)( a, a+n, 8 );
-		assert( result == a + 4 );
+		Q_ARY_CHECK( result == a + 4 );
 		//
 		result = (*search_f)( a, a+n, 1 );
-		assert( result == a );
+		Q_ARY_CHECK( result == a );
 		//
 		result = (*search_f)( a, a+n, 42 );
-		assert( result == a + n );
+		Q_ARY_CHECK( result == a + n );
 	}
 
 	// Test on fragmented sequence
@@ -49,19 +92,19 @@ void test_search_on_sorted_int_array(
 		const int* result;
 		//
 		result = (*search_f)( a, a+n, 7 );
-		assert( result == a + 3 );
+		Q_ARY_CHECK( result == a + 3 );
 		//
 		result = (*search_f)( a, a+n, 8 );
-		assert( result == a + 7 );
+		Q_ARY_CHECK( result == a + 7 );
 		//
 		result = (*search_f)( a, a+n, 2 );
-		assert( result == a );
+		Q_ARY_CHECK( result == a );
 		//
 		result = (*search_f)( a, a+n, 20 );
-		assert( result == a + n );
+		Q_ARY_CHECK( result == a + n );
 		//
 		result = (*search_f)( a, a+n, 15 );
-		assert( result == a + 9 );
+		Q_ARY_CHECK( result == a + 9 );
 	}
 
 	// Test on constant sequence
@@ -71,10 +114,10 @@ void test_search_on_sorted_int_array(
 		const int* result;
 		//
 		result = (*search_f)( a, a+n, 4 );
-		assert( result == a );
+		Q_ARY_CHECK( result == a );
 		//
 		result = (*search_f)( a, a+n, 5 );
-		assert( result == a + n );
+		Q_ARY_CHECK( result == a + n );
 	}
 
 	// Test on empty sequence
@@ -84,12 +127,882 @@ void test_search_on_sorted_int_array(
 		const int* result;
 		//
 		result = (*search_f)( a, a+n, 6 );
-		assert( result == a );
+		Q_ARY_CHECK( result == a );
 		//
 		result = (*search_f)( a, a+n, 12 );
-		assert( result == a );
+		Q_ARY_CHECK( result == a );
+	}
+
+}
+
+
+/// Runs tests on provided batch search function, by comparing its
+/// results with the ones of 'std::lower_bound()', on a random sorted array.
+/// Queries of the batch are sorted, if 'sorted_queries' is set.
+template< typename RanIt, typename ValueType >
+void test_batch_search_on_sorted_int_array(
+		RanIt* (*batch_search_f)( RanIt begin, RanIt end, 
+				const ValueType* queries_begin, const ValueType* queries_end, 
+				RanIt* out ), 
+		bool sorted_queries = false )
+{
+	std::default_random_engine gen;
+	std::uniform_int_distribution< int > dist( 0, 1000 );
+	std::vector< int > a( 777 );
+	for ( int& value : a )
+		value = dist( gen );
+	std::sort( a.begin(), a.end() );
+	std::vector< int > queries( 1000 );
+	for ( int& q : queries )
+		q = dist( gen ) - 10;
+	if ( sorted_queries )
+		std::sort( queries.begin(), queries.end() );
+	std::vector< const int* > results( queries.size() );
+	//
+	(*batch_search_f)( a.data(), a.data() + a.size(), 
+			queries.data(), queries.data() + queries.size(), 
+			results.data() );
+	for ( std::size_t i = 0; i < queries.size(); ++i )
+		Q_ARY_CHECK( results[ i ] == std::lower_bound( 
+				a.data(), a.data() + a.size(), queries[ i ] ) );
+	// Empty batch
+	(*batch_search_f)( a.data(), a.data() + a.size(), 
+			queries.data(), queries.data(), 
+			results.data() );
+}
+
+
+/// Runs tests of 'q_ary_simd_step' on a random sorted array of narrow
+/// integers 'V' (8-bit or 16-bit ones, whose compares pack many lanes into
+/// one vector), by comparing lower and upper bounds with the ones of
+/// 'std::lower_bound()' and 'std::upper_bound()', for every value of 'V'.
+template< unsigned Q, typename V >
+void test_simd_step_on_sorted_narrow_int_array()
+{
+	std::default_random_engine gen;
+	std::uniform_int_distribution< int > dist(
+			std::numeric_limits< V >::min(), std::numeric_limits< V >::max() );
+	for ( std::size_t n : { 0, 1, 5, 31, 33, 100, 777 } ) {
+		std::vector< V > a( n );
+		for ( V& value : a )
+			value = (V)dist( gen );
+		std::sort( a.begin(), a.end() );
+		const V* const begin = a.data();
+		const V* const end = a.data() + a.size();
+		const int step = (sizeof(V) == 1) ? 1 : 97;
+		for ( int q = std::numeric_limits< V >::min(); q <= std::numeric_limits< V >::max(); q += step ) {
+			Q_ARY_CHECK( (ml::algorithm::q_ary_lower_bound< Q, ml::algorithm::q_ary_simd_step >(
+					begin, end, (V)q ) == std::lower_bound( begin, end, (V)q )) );
+			Q_ARY_CHECK( (ml::algorithm::q_ary_upper_bound< Q, ml::algorithm::q_ary_simd_step >(
+					begin, end, (V)q ) == std::upper_bound( begin, end, (V)q )) );
+		}
+	}
+}
+
+
+/// Runs tests of the dispatched search kernels of every instruction set,
+/// which the processor supports, of values of type 'T', by comparing their
+/// results with the ones of 'std::lower_bound()' and 'std::upper_bound()',
+/// on random sorted arrays with repeated values.
+template< typename T >
+void test_dispatched_search_kernels()
+{
+	std::default_random_engine gen;
+	std::uniform_int_distribution< int > dist( -500, 500 );
+	for ( unsigned i = 0; i < ml::algorithm::q_ary_isa_count; ++i ) {
+		const ml::algorithm::q_ary_search_kernels* const kernels = 
+				ml::algorithm::q_ary_search_kernels_of( (ml::algorithm::q_ary_isa)i );
+		if ( kernels == nullptr )
+			continue;
+		const ml::algorithm::q_ary_search_kernel_set< T >& set = kernels->template of< T >();
+		for ( int n : { 0, 1, 7, 100, 1000 } ) {
+			std::vector< T > a( n );
+			for ( T& value : a )
+				value = (T)dist( gen );
+			std::sort( a.begin(), a.end() );
+			const T* const begin = a.data();
+			const T* const end = a.data() + a.size();
+			std::vector< T > queries( 300 );
+			for ( T& q : queries )
+				q = (T)(dist( gen ) + dist( gen ) / 400);
+			std::vector< const T* > lower( queries.size() ), upper( queries.size() );
+			set._lower_bound_batch( begin, end, 
+					queries.data(), queries.data() + queries.size(), lower.data() );
+			set._upper_bound_batch( begin, end, 
+					queries.data(), queries.data() + queries.size(), upper.data() );
+			for ( std::size_t j = 0; j < queries.size(); ++j ) {
+				Q_ARY_CHECK( set._lower_bound( begin, end, queries[ j ] ) 
+						== std::lower_bound( begin, end, queries[ j ] ) );
+				Q_ARY_CHECK( set._upper_bound( begin, end, queries[ j ] ) 
+						== std::upper_bound( begin, end, queries[ j ] ) );
+				Q_ARY_CHECK( lower[ j ] == std::lower_bound( begin, end, queries[ j ] ) );
+				Q_ARY_CHECK( upper[ j ] == std::upper_bound( begin, end, queries[ j ] ) );
+			}
+		}
 	}
+	// The best ones are of a supported instruction set
+	const ml::algorithm::q_ary_search_kernels& best = ml::algorithm::q_ary_best_search_kernels();
+	Q_ARY_CHECK( ml::algorithm::q_ary_search_kernels_of( best._isa ) == &best );
+}
+
+#if defined( Q_ARY_SEARCH_HAVE_GPU )
+/// Runs tests of 'q_ary_gpu_searcher< T >', by comparing its results with
+/// the ones of 'std::lower_bound()' and 'std::upper_bound()', on random
+/// sorted arrays with repeated values (of lengths around the ones of its
+/// nodes and levels), by short chunks, so every batch is pipelined over
+/// all the streams.
+template< typename T >
+void test_gpu_batch_search()
+{
+	std::default_random_engine gen;
+	std::uniform_int_distribution< int > dist( 0, 100'000 );
+	for ( int n : { 0, 1, 31, 32, 33, 1056, 1057, 100'000 } ) {
+		std::vector< T > a( n );
+		for ( T& value : a )
+			value = (T)(dist( gen ) % (2 * n + 1));
+		std::sort( a.begin(), a.end() );
+		std::vector< T > queries( 10'000 );
+		for ( T& q : queries )
+			q = (T)(dist( gen ) % (2 * n + 3));
+		ml::algorithm::q_ary_gpu_searcher< T > searcher;
+		const bool opened = searcher.open( a.data(), a.data() + a.size(), 0, 777 );
+		Q_ARY_CHECK( opened );
+		Q_ARY_CHECK( searcher.size() == a.size() );
+		std::vector< std::size_t > lower( queries.size() ), upper( queries.size() );
+		const bool searched = searcher.lower_bound_batch( 
+						queries.data(), queries.data() + queries.size(), lower.data() )
+				&& searcher.upper_bound_batch( 
+						queries.data(), queries.data() + queries.size(), upper.data() );
+		Q_ARY_CHECK( searched );
+		for ( std::size_t j = 0; j < queries.size(); ++j ) {
+			Q_ARY_CHECK( lower[ j ] == (std::size_t)(std::lower_bound( 
+					a.begin(), a.end(), queries[ j ] ) - a.begin()) );
+			Q_ARY_CHECK( upper[ j ] == (std::size_t)(std::upper_bound( 
+					a.begin(), a.end(), queries[ j ] ) - a.begin()) );
+		}
+	}
+}
+
+#endif // Q_ARY_SEARCH_HAVE_GPU
 
+/// Runs tests of 'q_ary_equal_range< Q, StepT >()' and 
+/// 'q_ary_range_count< Q, StepT >()', by comparing their results with the 
+/// ones of 'std::equal_range()', on random sorted arrays with many 
+/// repeated values (so the bounds diverge on every level).
+template< unsigned Q, typename StepT >
+void test_range_search_on_sorted_int_array()
+{
+	std::default_random_engine gen;
+	for ( int max_value : { 3, 40, 1000 } ) {
+		std::uniform_int_distribution< int > dist( 0, max_value );
+		for ( int n : { 0, 1, 2, 7, 100, 777 } ) {
+			std::vector< int > a( n );
+			for ( int& value : a )
+				value = dist( gen );
+			std::sort( a.begin(), a.end() );
+			const int* const begin = a.data();
+			const int* const end = a.data() + a.size();
+			for ( int i = 0; i < 200; ++i ) {
+				const int lo = dist( gen ) - 2, hi = dist( gen ) + 2;
+				Q_ARY_CHECK( (ml::algorithm::q_ary_equal_range< Q, StepT >( begin, end, lo ) 
+						== std::equal_range( begin, end, lo )) );
+				Q_ARY_CHECK( (ml::algorithm::q_ary_range_count< Q, StepT >( begin, end, lo, hi ) 
+						== (lo < hi ? std::lower_bound( begin, end, hi ) 
+								- std::lower_bound( begin, end, lo ) : 0)) );
+			}
+		}
+	}
+	// Empty query range
+	{
+		const int a[] = { 2, 4, 6, 7, 12, 13, 16 };
+		const int n = sizeof(a) / sizeof(a[0]);
+		Q_ARY_CHECK( (ml::algorithm::q_ary_range_count< Q, StepT >( a, a+n, 7, 7 )) == 0 );
+		Q_ARY_CHECK( (ml::algorithm::q_ary_range_count< Q, StepT >( a, a+n, 13, 4 )) == 0 );
+	}
+}
+
+
+/// Runs tests of interpolation search on arrays of doubles with infinite
+/// and extreme borders (so the estimated position is not a number), by
+/// comparing its results with the ones of 'std::lower_bound()'.
+template< unsigned Q, typename StepT >
+void test_interpolation_search_on_infinite_borders()
+{
+	const double inf = std::numeric_limits< double >::infinity();
+	const double max = std::numeric_limits< double >::max();
+	std::vector< double > a;
+	for ( int i = 0; i < 500; ++i )
+		a.push_back( i / 4 );
+	for ( const auto& borders : { std::make_pair( -inf, inf ), 
+			std::make_pair( -inf, 1000.0 ), std::make_pair( -max, max ) } ) {
+		a.front() = borders.first;
+		a.back() = borders.second;
+		const double* const begin = a.data();
+		const double* const end = a.data() + a.size();
+		for ( const double q : { -inf, -max, -1.0, 0.0, 7.0, 7.5, 124.0, 1000.0, max, inf } ) {
+			const double* const result = ml::algorithm::q_ary_interpolation_lower_bound< Q, StepT >( 
+					begin, end, q );
+			Q_ARY_CHECK( result == std::lower_bound( begin, end, q ) );
+		}
+	}
+}
+
+/// Record of a sorted array of records, searched by projection to its key.
+struct test_record {
+	std::int64_t _key;
+	std::int32_t _payload;
+};
+
+/// Record, wider than a cache line.
+struct test_wide_record {
+	std::int64_t _key;
+	std::int32_t _payload;
+	char _padding[ 116 ];
+};
+
+/// Runs tests of searches by projection with 'Q' and 'StepT', by comparing 
+/// their results with the ones of 'std::equal_range()' on the keys, on 
+/// random arrays of records of type 'RecordT', sorted by key.
+template< unsigned Q, typename StepT, typename RecordT = test_record >
+void test_projected_search_on_sorted_records()
+{
+	std::default_random_engine gen;
+	for ( int max_value : { 5, 1000 } ) {
+		std::uniform_int_distribution< int > dist( 0, max_value );
+		for ( int n : { 0, 1, 9, 100, 777 } ) {
+			std::vector< RecordT > a( n );
+			std::vector< std::int64_t > keys( n );
+			for ( int i = 0; i < n; ++i )
+				keys[ i ] = dist( gen );
+			std::sort( keys.begin(), keys.end() );
+			for ( int i = 0; i < n; ++i ) {
+				a[ i ]._key = keys[ i ];
+				a[ i ]._payload = i;
+			}
+			const RecordT* const begin = a.data();
+			const RecordT* const end = a.data() + a.size();
+			for ( int i = 0; i < 200; ++i ) {
+				const std::int64_t q = dist( gen ) - 2;
+				const auto expected = std::equal_range( keys.data(), keys.data() + n, q );
+				// By data member
+				Q_ARY_CHECK( (ml::algorithm::q_ary_lower_bound< Q, StepT >( begin, end, q, 
+						std::less< std::int64_t >(), &RecordT::_key ) - begin 
+						== expected.first - keys.data()) );
+				Q_ARY_CHECK( (ml::algorithm::q_ary_upper_bound< Q, StepT >( begin, end, q, 
+						std::less< std::int64_t >(), &RecordT::_key ) - begin 
+						== expected.second - keys.data()) );
+				// By function, to keys in descending order
+				const auto negated = []( const RecordT& r ) { return -r._key; };
+				Q_ARY_CHECK( (ml::algorithm::q_ary_lower_bound< Q, StepT >( begin, end, -q, 
+						std::greater< std::int64_t >(), negated ) - begin 
+						== expected.first - keys.data()) );
+				const auto range = ml::algorithm::q_ary_equal_range< Q, StepT >( begin, end, -q, 
+						std::greater< std::int64_t >(), negated );
+				Q_ARY_CHECK( range.first - begin == expected.first - keys.data() );
+				Q_ARY_CHECK( range.second - begin == expected.second - keys.data() );
+				Q_ARY_CHECK( (ml::algorithm::q_ary_range_count< Q, StepT >( begin, end, q, q + 3, 
+						std::less< std::int64_t >(), &RecordT::_key ) 
+						== std::lower_bound( keys.data(), keys.data() + n, q + 3 ) - expected.first) );
+			}
+		}
+	}
+}
+
+
+/// Runs tests of key column 'ColumnT' over random arrays of records, 
+/// sorted by key, which grow by appends of random lengths, by comparing 
+/// its results with the ones of 'std::equal_range()' on the keys.
+template< typename ColumnT >
+void test_key_column_on_sorted_records()
+{
+	std::default_random_engine gen;
+	std::uniform_int_distribution< int > dist( 0, 30 );
+	std::vector< test_record > a;
+	std::vector< std::int64_t > keys;
+	ColumnT column( a.data(), a.data(), &test_record::_key );
+	for ( int round = 0; round < 60; ++round ) {
+		// Append a few records, with keys not less than the last one
+		const std::size_t old_size = a.size();
+		const int count = dist( gen ) * (round % 7);
+		for ( int i = 0; i < count; ++i ) {
+			keys.push_back( (keys.empty() ? 0 : keys.back()) + dist( gen ) / 20 );
+			a.push_back( { keys.back(), (std::int32_t)a.size() } );
+		}
+		column.append( a.data() + old_size, a.data() + a.size(), &test_record::_key );
+		Q_ARY_CHECK( column.size() == a.size() );
+		for ( int i = 0; i < 50; ++i ) {
+			const std::int64_t q = dist( gen ) * ((keys.empty() ? 0 : keys.back()) + 2) / 30 - 1;
+			const auto expected = std::equal_range( keys.data(), keys.data() + keys.size(), q );
+			const auto range = column.equal_range( a.data(), q );
+			Q_ARY_CHECK( range.first - a.data() == expected.first - keys.data() );
+			Q_ARY_CHECK( range.second - a.data() == expected.second - keys.data() );
+			Q_ARY_CHECK( column.contains( q ) == (expected.first != expected.second) );
+		}
+	}
+}
+
+
+#if defined( ML__ALGORITHM__Q_ARY_MMAP_SEARCHER_ENABLED )
+
+/// Runs tests of 'q_ary_mmap_searcher' over temporary files of random 
+/// sorted keys, with various read units and pinned budgets, by comparing 
+/// its results with the ones of 'std::equal_range()'.
+void test_mmap_searcher_on_sorted_file()
+{
+	std::default_random_engine gen;
+	for ( int n : { 0, 1, 5, 100, 3000, 20000 } ) {
+		std::uniform_int_distribution< std::int64_t > dist( 0, n / 2 + 1 );
+		std::vector< std::int64_t > keys( n );
+		for ( std::int64_t& key : keys )
+			key = dist( gen );
+		std::sort( keys.begin(), keys.end() );
+		// Write the keys to a temporary file
+		char path[] = "/tmp/q_ary_mmap_searcher_XXXXXX";
+		const int fd = ::mkstemp( path );
+		Q_ARY_CHECK( fd >= 0 );
+		const ssize_t bytes = (ssize_t)(keys.size() * sizeof(std::int64_t));
+		const ssize_t written = ::write( fd, keys.data(), bytes );
+		Q_ARY_CHECK( written == bytes );
+		::close( fd );
+		for ( std::size_t read_unit : { std::size_t( 0 ), std::size_t( 8 ), std::size_t( 64 ) } )
+			for ( std::size_t pinned_bytes : { std::size_t( 0 ), std::size_t( 64 ), 
+					ml::algorithm::q_ary_mmap_pinned_bytes } ) {
+				ml::algorithm::q_ary_mmap_searcher< std::int64_t > searcher;
+				// With read hints, when few keys are pinned (so most steps are
+				// over the file)
+				const bool opened = searcher.open( path, read_unit, pinned_bytes, 5, 
+						pinned_bytes == 64 );
+				Q_ARY_CHECK( opened );
+				Q_ARY_CHECK( searcher.size() == keys.size() );
+				for ( int i = 0; i < 300; ++i ) {
+					const std::int64_t q = dist( gen ) - 1;
+					const auto expected = std::equal_range( keys.data(), keys.data() + n, q );
+					Q_ARY_CHECK( searcher.lower_bound( q ) == (std::size_t)(expected.first - keys.data()) );
+					Q_ARY_CHECK( searcher.upper_bound( q ) == (std::size_t)(expected.second - keys.data()) );
+				}
+			}
+		::unlink( path );
+	}
+	// Files, which can't be mapped
+	ml::algorithm::q_ary_mmap_searcher< std::int64_t > searcher;
+	const bool opened = searcher.open( "/nonexistent/q_ary_mmap_searcher" );
+	Q_ARY_CHECK( ! opened );
+	Q_ARY_CHECK( ! searcher.is_open() );
+}
+
+#endif // ML__ALGORITHM__Q_ARY_MMAP_SEARCHER_ENABLED
+
+
+/// Object, published by 'q_ary_rcu_pointer' in tests, which counts its 
+/// live instances.
+struct test_rcu_object {
+	static std::atomic< int > live_count;
+	int _value, _check;
+
+	explicit test_rcu_object( int value ) 
+		: _value( value ), _check( ~value ) 
+		{ ++live_count; }
+	~test_rcu_object()
+		{ _check = 0; --live_count; }
+};
+
+std::atomic< int > test_rcu_object::live_count( 0 );
+
+/// Runs tests of 'q_ary_rcu_pointer': readers, which hold snapshots while 
+/// new objects are published, must see them unchanged, and every replaced 
+/// object must be deleted once its readers have left.
+void test_rcu_pointer()
+{
+	{
+		ml::algorithm::q_ary_rcu_pointer< test_rcu_object, 4 > pointer( 
+				std::make_unique< test_rcu_object >( 0 ) );
+		std::atomic< bool > stop( false );
+		std::vector< std::thread > readers;
+		for ( int r = 0; r < 6; ++r )  // More readers than slots
+			readers.emplace_back( [&pointer, &stop]() {
+				int previous_value = 0;
+				while ( ! stop.load() ) {
+					const auto snapshot = pointer.snapshot();
+					const int value = snapshot->_value;
+					Q_ARY_CHECK( value >= previous_value );
+					previous_value = value;
+					std::this_thread::yield();
+					Q_ARY_CHECK( snapshot->_value == value && snapshot->_check == ~value );
+				} } );
+		for ( int i = 1; i <= 20000; ++i )
+			pointer.publish( std::make_unique< test_rcu_object >( i ) );
+		stop.store( true );
+		for ( std::thread& reader : readers )
+			reader.join();
+		Q_ARY_CHECK( pointer.get()->_value == 20000 );
+		std::size_t reclaimed = pointer.reclaim();
+		Q_ARY_CHECK( reclaimed == 0 );
+		Q_ARY_CHECK( test_rcu_object::live_count.load() == 1 );
+		// A held snapshot holds back reclamation
+		auto snapshot = pointer.snapshot();
+		pointer.publish( std::make_unique< test_rcu_object >( 1 ) );
+		reclaimed = pointer.reclaim();
+		Q_ARY_CHECK( reclaimed == 1 && snapshot->_value == 20000 );
+		snapshot.release();
+		reclaimed = pointer.reclaim();
+		Q_ARY_CHECK( reclaimed == 0 );
+	}
+	Q_ARY_CHECK( test_rcu_object::live_count.load() == 0 );
+}
+
+
+/// Runs tests of compressed index 'IndexT' over 64-bit keys, which are 
+/// dense in places and sparse in others (so blocks are full, or closed 
+/// early), comparing its results with the ones of 'std::equal_range()'.
+template< typename IndexT >
+void test_compressed_blocks_on_sorted_int64_array()
+{
+	std::default_random_engine gen( 24 );
+	std::uniform_int_distribution< std::int64_t > small_gap( 0, 20 );
+	std::uniform_int_distribution< std::int64_t > large_gap( 0, std::int64_t( 1 ) << 40 );
+	for ( std::size_t n : { 0, 1, 2, 31, 33, 1000, 20'000 } ) {
+		std::vector< std::int64_t > a( n );
+		std::int64_t key = std::numeric_limits< std::int64_t >::min() / 2;
+		for ( std::size_t i = 0; i < n; ++i ) {
+			key += (i / 100) % 3 == 2 ? large_gap( gen ) : small_gap( gen );
+			a[ i ] = key;
+		}
+		const IndexT index( a.data(), a.data() + n );
+		Q_ARY_CHECK( index.size() == n );
+		std::vector< std::int64_t > queries( a );
+		if ( n != 0 ) {
+			queries.push_back( a.front() - 1 );
+			queries.push_back( a.back() + 1 );
+			for ( std::size_t i = 0; i < n; i += 7 ) {
+				queries.push_back( a[ i ] + 1 );
+				queries.push_back( a[ i ] - 1 );
+			}
+		}
+		queries.push_back( std::numeric_limits< std::int64_t >::min() );
+		queries.push_back( std::numeric_limits< std::int64_t >::max() );
+		for ( std::int64_t q : queries ) {
+			const std::size_t lower = 
+					(std::size_t)(std::lower_bound( a.begin(), a.end(), q ) - a.begin());
+			const std::size_t upper = 
+					(std::size_t)(std::upper_bound( a.begin(), a.end(), q ) - a.begin());
+			Q_ARY_CHECK( index.lower_bound( q ) == lower );
+			Q_ARY_CHECK( index.upper_bound( q ) == upper );
+			Q_ARY_CHECK( index.contains( q ) == (lower != upper) );
+			// By a predicate, which is not compared by vectors
+			Q_ARY_CHECK( index.search( q, []( std::int64_t v, std::int64_t x ) { return v < x; } ) 
+					== lower );
+		}
+	}
+}
+
+/// Runs tests of 'q_ary_string_index', on strings of a small alphabet 
+/// (with zero bytes in it), which share long prefixes, comparing its 
+/// results with the ones of 'std::equal_range()'.
+template< typename IndexT >
+void test_string_index_on_sorted_strings()
+{
+	std::default_random_engine gen( 25 );
+	std::uniform_int_distribution< int > length_dist( 0, 20 );
+	std::uniform_int_distribution< int > char_dist( 0, 3 );
+	const char alphabet[] = { '\0', 'a', 'b', '\xff' };
+	const auto random_string = [&]() {
+		std::string s( (std::size_t)length_dist( gen ), 'a' );
+		for ( char& c : s )
+			c = alphabet[ char_dist( gen ) ];
+		return s;
+	};
+	for ( std::size_t n : { 0, 1, 2, 10, 1000 } ) {
+		std::vector< std::string > keys( n );
+		for ( std::string& key : keys )
+			key = random_string();
+		// Some duplicates, and some keys, which only differ past the prefix
+		for ( std::size_t i = 1; i < n; i += 3 )
+			keys[ i ] = keys[ i - 1 ] + (i % 2 ? std::string() : std::string( 1, 'b' ));
+		std::sort( keys.begin(), keys.end() );
+		const IndexT index( keys.begin(), keys.end() );
+		Q_ARY_CHECK( index.size() == n );
+		std::vector< std::string > queries( keys );
+		for ( int i = 0; i < 1000; ++i )
+			queries.push_back( random_string() );
+		queries.push_back( std::string() );
+		queries.push_back( std::string( 30, '\xff' ) );
+		for ( const std::string& q : queries ) {
+			const std::pair< std::vector< std::string >::iterator, 
+					std::vector< std::string >::iterator > range = 
+							std::equal_range( keys.begin(), keys.end(), q );
+			Q_ARY_CHECK( index.lower_bound( q ) == (std::size_t)(range.first - keys.begin()) );
+			Q_ARY_CHECK( index.upper_bound( q ) == (std::size_t)(range.second - keys.begin()) );
+			Q_ARY_CHECK( index.contains( q ) == (range.first != range.second) );
+		}
+	}
+}
+
+/// Runs tests of 'q_ary_counting_step': counted searches must find the 
+/// same results, and count one linear search per search, and the steps 
+/// down to it.
+void test_counting_step()
+{
+	static_assert( 
+#if defined( ML__ALGORITHM__Q_ARY_SEARCH_STATS )
+			std::is_same< ml::algorithm::q_ary_instrumented_step< ml::algorithm::q_ary_branchy_step >, 
+					ml::algorithm::q_ary_counting_step< ml::algorithm::q_ary_branchy_step > >::value,
+#else
+			std::is_same< ml::algorithm::q_ary_instrumented_step< ml::algorithm::q_ary_branchy_step >, 
+					ml::algorithm::q_ary_branchy_step >::value,
+#endif
+			"Instrumented step must be the plain one, when the stats are off." );
+	std::vector< int > a( 10'000 );
+	for ( std::size_t i = 0; i < a.size(); ++i )
+		a[ i ] = (int)(i * 2);
+	ml::algorithm::q_ary_search_stats& stats = ml::algorithm::q_ary_search_stats::local();
+	stats.reset();
+	const int search_count = 1000;
+	for ( int q = 0; q < search_count; ++q ) {
+		const int* const result = ml::algorithm::q_ary_lower_bound< 4, 
+				ml::algorithm::q_ary_counting_step< ml::algorithm::q_ary_branchy_step > >( 
+						a.data(), a.data() + a.size(), q * 17 );
+		Q_ARY_CHECK( result == std::lower_bound( a.data(), a.data() + a.size(), q * 17 ) );
+	}
+	Q_ARY_CHECK( stats._finishes == (std::uint64_t)search_count );
+	// Q-1 pivots per step, whether the branchy step compares them all or not
+	Q_ARY_CHECK( stats._step_pivots == stats._steps * 3 );
+	// 10'000 values, down to the default threshold of Q=4
+	Q_ARY_CHECK( stats.average_steps() >= 4.0 && stats.average_steps() <= 12.0 );
+	Q_ARY_CHECK( stats.average_tail_length() >= 1.0 
+			&& stats.average_tail_length() < ml::algorithm::q_ary_default_parameters< 4 >()
+					.to_linear_threshold() );
+	// Counted searches of other threads don't count here
+	std::thread( [&]() {
+		ml::algorithm::q_ary_lower_bound< 4, 
+				ml::algorithm::q_ary_counting_step< ml::algorithm::q_ary_branchless_step > >( 
+						a.data(), a.data() + a.size(), 5 );
+	} ).join();
+	Q_ARY_CHECK( stats._finishes == (std::uint64_t)search_count );
+}
+
+/// Runs tests of 'q_ary_perf_counters' (of the events, which are 
+/// available on this host, if any).
+void test_perf_counters()
+{
+	ml::algorithm::q_ary_perf_counters counters;
+	counters.start();
+	std::vector< int > a( 100'000 );
+	for ( std::size_t i = 0; i < a.size(); ++i )
+		a[ i ] = (int)i;
+	std::ptrdiff_t rank_sum = 0;
+	for ( int q = 0; q < 10'000; ++q )
+		rank_sum += ml::algorithm::q_ary_lower_bound< 4 >( a.data(), a.data() + a.size(), q * 7 ) 
+				- a.data();
+	counters.stop();
+	Q_ARY_CHECK( rank_sum == (std::ptrdiff_t)7 * (10'000 * 9'999 / 2) );
+	using ml::algorithm::q_ary_perf_event;
+	if ( counters.available( q_ary_perf_event::cycles ) )
+		Q_ARY_CHECK( counters.count( q_ary_perf_event::cycles ) > 0 );
+	if ( counters.available( q_ary_perf_event::instructions ) )
+		Q_ARY_CHECK( counters.count( q_ary_perf_event::instructions ) > 10'000 );
+	for ( unsigned e = 0; e < ml::algorithm::q_ary_perf_event_count; ++e )
+		if ( ! counters.available( (q_ary_perf_event)e ) )
+			Q_ARY_CHECK( counters.count( (q_ary_perf_event)e ) == 0 );
+}
+
+/// Runs tests of 'q_ary_huge_page_allocator': arrays shorter and longer 
+/// than a huge page must be usable, and indexes over them must agree 
+/// with 'std::lower_bound()'.
+void test_huge_page_allocator()
+{
+	typedef ml::algorithm::q_ary_huge_page_allocator< int > alloc_t;
+	for ( std::size_t n : { std::size_t( 1 ), std::size_t( 1000 ), 
+			ml::algorithm::q_ary_huge_page_size / sizeof(int), 
+			ml::algorithm::q_ary_huge_page_size * 3 / sizeof(int) + 7 } ) {
+		std::vector< int, alloc_t > a( n );
+		Q_ARY_CHECK( (std::uintptr_t)a.data() % ml::algorithm::q_ary_cache_line_size == 0 );
+#if defined( ML__ALGORITHM__Q_ARY_HUGE_PAGES_ENABLED )
+		if ( n * sizeof(int) >= ml::algorithm::q_ary_huge_page_size )
+			Q_ARY_CHECK( (std::uintptr_t)a.data() % ml::algorithm::q_ary_huge_page_size == 0 );
+#endif
+		for ( std::size_t i = 0; i < n; ++i )
+			a[ i ] = (int)(i * 2);
+		const ml::algorithm::q_ary_eytzinger_index< int, 16, 
+				ml::algorithm::q_ary_branchless_step, alloc_t > index( a.begin(), a.end() );
+		for ( int q = -1; q < (int)(n * 2) + 1; q += 1 + (int)(n / 500) )
+			Q_ARY_CHECK( index.lower_bound( q ) 
+					== (std::size_t)(std::lower_bound( a.begin(), a.end(), q ) - a.begin()) );
+	}
+}
+
+/// Runs tests of 'q_ary_numa_replicas': every replica must be a complete 
+/// index, and searches from other threads must agree with the ones of 
+/// the replicas.
+void test_numa_replicas()
+{
+	typedef ml::algorithm::q_ary_eytzinger_index< int, 16, 
+			ml::algorithm::q_ary_branchless_step, 
+			ml::algorithm::q_ary_huge_page_allocator< int > > index_t;
+	std::vector< int > a( 100'000 );
+	for ( std::size_t i = 0; i < a.size(); ++i )
+		a[ i ] = (int)(i * 3);
+	const ml::algorithm::q_ary_numa_replicas< index_t > replicas( a.data(), a.data() + a.size() );
+	Q_ARY_CHECK( replicas.replica_count() 
+			== ml::algorithm::q_ary_numa_topology::host().node_count() );
+	Q_ARY_CHECK( replicas.size() == a.size() );
+	for ( unsigned node = 0; node < replicas.replica_count(); ++node )
+		Q_ARY_CHECK( replicas.replica( node ).size() == a.size() );
+	std::vector< std::thread > searchers;
+	std::atomic< int > mismatches( 0 );
+	for ( int t = 0; t < 4; ++t )
+		searchers.emplace_back( [&, t]() {
+			for ( int q = t; q < (int)a.size() * 3; q += 7 )
+				if ( replicas.lower_bound( q ) 
+						!= (std::size_t)(std::lower_bound( a.begin(), a.end(), q ) - a.begin()) )
+					++mismatches;
+		} );
+	for ( std::thread& searcher : searchers )
+		searcher.join();
+	Q_ARY_CHECK( mismatches == 0 );
+}
+
+/// Runs tests of sorted container 'ContainerT', by inserting random values 
+/// into it, and comparing its results with the ones of 'std::equal_range()' 
+/// on a sorted copy of them; then by searching it from concurrent readers, 
+/// while values are inserted and the base is rebuilt.
+template< typename ContainerT >
+void test_sorted_vector( bool background )
+{
+	std::default_random_engine gen;
+	std::uniform_int_distribution< int > dist( 0, 2000 );
+	std::vector< int > values( 500 );
+	for ( int& value : values )
+		value = dist( gen );
+	ContainerT container( values.begin(), values.end(), 16, background );
+	std::sort( values.begin(), values.end() );
+	for ( int round = 0; round < 40; ++round ) {
+		const int count = dist( gen ) % 100;
+		for ( int i = 0; i < count; ++i ) {
+			values.push_back( dist( gen ) );
+			container.insert( values.back() );
+		}
+		container.flush();
+		container.wait();
+		std::sort( values.begin(), values.end() );
+		const typename ContainerT::snapshot_type snapshot = container.snapshot();
+		Q_ARY_CHECK( snapshot->size() == values.size() );
+		for ( int i = 0; i < 100; ++i ) {
+			const int q = dist( gen ) - 1;
+			const auto expected = std::equal_range( values.data(), values.data() + values.size(), q );
+			Q_ARY_CHECK( snapshot->lower_bound( q ) == (std::size_t)(expected.first - values.data()) );
+			Q_ARY_CHECK( snapshot->upper_bound( q ) == (std::size_t)(expected.second - values.data()) );
+		}
+	}
+	// Concurrent readers: every version holds all the values, inserted 
+	// before the readers started, and no fewer values than the previous one
+	std::atomic< bool > stop( false );
+	std::vector< std::thread > readers;
+	for ( int r = 0; r < 3; ++r )
+		readers.emplace_back( [&container, &values, &stop]() {
+			std::size_t previous_size = 0;
+			for ( std::size_t i = 0; ! stop.load(); ++i ) {
+				const typename ContainerT::snapshot_type snapshot = container.snapshot();
+				Q_ARY_CHECK( snapshot->size() >= previous_size );
+				previous_size = snapshot->size();
+				const int q = values[ i % values.size() ];
+				Q_ARY_CHECK( snapshot->contains( q ) );
+				Q_ARY_CHECK( snapshot->lower_bound( q ) < snapshot->upper_bound( q ) );
+				Q_ARY_CHECK( snapshot->upper_bound( q ) <= snapshot->size() );
+			} } );
+	for ( int i = 0; i < 20000; ++i )
+		container.insert( dist( gen ) );
+	container.flush();
+	container.wait();
+	stop.store( true );
+	for ( std::thread& reader : readers )
+		reader.join();
+	Q_ARY_CHECK( container.size() == values.size() + 20000 );
+}
+
+
+/// Random access iterator over a virtual sorted sequence, whose
+/// value at position 'i' is 'i / 4' (nothing is stored, so it can be 
+/// longer than memory).
+/// Used for testing searches on ranges longer than 4G values.
+class virtual_sequence_iterator
+{
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef long long value_type;
+	typedef long long difference_type;
+	typedef const long long* pointer;
+	typedef long long reference;
+
+	long long _i = 0;
+
+	virtual_sequence_iterator() = default;
+	explicit virtual_sequence_iterator( long long i ) 
+		: _i( i ) 
+		{}
+
+	long long operator*() const
+		{ return _i / 4; }
+	long long operator[]( long long n ) const
+		{ return (_i + n) / 4; }
+	virtual_sequence_iterator& operator++()
+		{ ++_i; return *this; }
+	virtual_sequence_iterator& operator--()
+		{ --_i; return *this; }
+	virtual_sequence_iterator operator++( int )
+		{ return virtual_sequence_iterator( _i++ ); }
+	virtual_sequence_iterator operator--( int )
+		{ return virtual_sequence_iterator( _i-- ); }
+	virtual_sequence_iterator& operator+=( long long n )
+		{ _i += n; return *this; }
+	virtual_sequence_iterator& operator-=( long long n )
+		{ _i -= n; return *this; }
+	friend virtual_sequence_iterator operator+( virtual_sequence_iterator it, long long n )
+		{ return it += n; }
+	friend virtual_sequence_iterator operator-( virtual_sequence_iterator it, long long n )
+		{ return it -= n; }
+	friend long long operator-( virtual_sequence_iterator a, virtual_sequence_iterator b )
+		{ return a._i - b._i; }
+	friend bool operator==( virtual_sequence_iterator a, virtual_sequence_iterator b )
+		{ return a._i == b._i; }
+	friend bool operator!=( virtual_sequence_iterator a, virtual_sequence_iterator b )
+		{ return a._i != b._i; }
+	friend bool operator<( virtual_sequence_iterator a, virtual_sequence_iterator b )
+		{ return a._i < b._i; }
+};
+
+
+/// Runs tests on provided search function, on a virtual sorted sequence
+/// of more than 4G values (so its length doesn't fit in 32 bits).
+void test_search_on_huge_virtual_sequence(
+		virtual_sequence_iterator (*search_f)( virtual_sequence_iterator begin, 
+				virtual_sequence_iterator end, const long long& q ) )
+{
+	const long long n = 4 * 1'500'000'001LL;
+	const virtual_sequence_iterator begin( 0 ), end( n );
+	for ( long long q : { -1LL, 0LL, 1LL, 77LL, 1'073'741'823LL, 1'073'741'824LL, 
+			1'200'000'000LL, 1'500'000'000LL, 1'500'000'001LL } ) {
+		const long long expected = q <= 0 ? 0 : (q < n / 4 ? q * 4 : n);
+		Q_ARY_CHECK( (*search_f)( begin, end, q ) - begin == expected );
+	}
+}
+
+
+/// Adapts dispatched search to the signature of search functions.
+template< typename ValueType >
+ValueType* dispatched_lower_bound( ValueType* begin, ValueType* end, const ValueType& q )
+{
+	return begin + (ml::algorithm::q_ary_dispatched_lower_bound< ValueType >( 
+			begin, end, q ) - begin);
+}
+
+
+/// Adapts dispatched batch search to the signature of batch search functions.
+template< typename ValueType >
+ValueType** dispatched_lower_bound_batch( ValueType* begin, ValueType* end, 
+		const ValueType* queries_begin, const ValueType* queries_end, 
+		ValueType** out )
+{
+	ml::algorithm::q_ary_dispatched_lower_bound_batch< ValueType >( begin, end, 
+			queries_begin, queries_end, const_cast< const ValueType** >( out ) );
+	return out + (queries_end - queries_begin);
+}
+
+
+/// Adapts parallel batch search to the signature of batch search functions, 
+/// by running it with the default parallel executor.
+template< unsigned Q, typename RanIt, typename ValueType >
+RanIt* parallel_lower_bound_batch( RanIt begin, RanIt end, 
+		const ValueType* queries_begin, const ValueType* queries_end, 
+		RanIt* out )
+{
+	return ml::algorithm::q_ary_lower_bound_batch< Q >( 
+			ml::algorithm::q_ary_parallel_executor(), 
+			begin, end, queries_begin, queries_end, out );
+}
+
+
+/// Adapts an index type 'IndexT' to the signature of search functions, 
+/// by building it over [begin, end) on every call.
+/// Used for testing only.
+template< typename IndexT, typename RanIt, typename ValueType >
+RanIt index_lower_bound( RanIt begin, RanIt end, const ValueType& q )
+{
+	const IndexT index( begin, end );
+	return begin + index.lower_bound( q );
+}
+
+
+/// Adapts search with parameters, given at run time, to the signature 
+/// of search functions.
+/// Used for testing only.
+template< unsigned Q, unsigned Threshold, typename RanIt, typename ValueType >
+RanIt runtime_parameters_lower_bound( RanIt begin, RanIt end, const ValueType& q )
+{
+	return ml::algorithm::q_ary_lower_bound< Q >( begin, end, q, 
+			ml::algorithm::q_ary_runtime_parameters{ Threshold } );
+}
+
+/// Adapts search with parameters, fixed at compile time, to the signature 
+/// of search functions.
+/// Used for testing only.
+template< unsigned Q, unsigned Threshold, typename RanIt, typename ValueType >
+RanIt static_parameters_lower_bound( RanIt begin, RanIt end, const ValueType& q )
+{
+	return ml::algorithm::q_ary_lower_bound< Q, ml::algorithm::q_ary_branchless_step >( 
+			begin, end, q, ml::algorithm::q_ary_static_parameters< Threshold >() );
+}
+
+
+/// Adapts search by a precomputed schedule to the signature of search 
+/// functions, by making the schedule on every call.
+/// Used for testing only.
+template< unsigned Q, typename StepT, typename RanIt, typename ValueType >
+RanIt scheduled_lower_bound( RanIt begin, RanIt end, const ValueType& q )
+{
+	return ml::algorithm::q_ary_search< Q, StepT >( 
+			ml::algorithm::q_ary_search_schedule::make< Q >( (ml::algorithm::length_t)(end - begin) ), 
+			begin, q, std::less< ValueType >() );
+}
+
+/// Adapts search with run-time 'Q' to the signature of search functions.
+/// Used for testing only.
+template< unsigned Q, typename RanIt, typename ValueType >
+RanIt dynamic_lower_bound( RanIt begin, RanIt end, const ValueType& q )
+{
+	return ml::algorithm::q_ary_dynamic_search( 
+			ml::algorithm::q_ary_divider( Q ), 2 * Q, 
+			begin, end, q, std::less< ValueType >() );
+}
+
+
+/// Counts values in [q, q + Width) by two independent searches, as 
+/// 'begin' advanced by the count, to fit the signature of search functions.
+/// Used for benchmarking only.
+template< unsigned Q, typename StepT, int Width, typename RanIt, typename ValueType >
+RanIt two_searches_range_count( RanIt begin, RanIt end, const ValueType& q )
+{
+	return begin + (ml::algorithm::q_ary_lower_bound< Q, StepT >( begin, end, q + Width ) 
+			- ml::algorithm::q_ary_lower_bound< Q, StepT >( begin, end, q ));
+}
+
+/// Same as 'two_searches_range_count()', but by 'q_ary_range_count()'.
+/// Used for benchmarking only.
+template< unsigned Q, typename StepT, int Width, typename RanIt, typename ValueType >
+RanIt range_count( RanIt begin, RanIt end, const ValueType& q )
+{
+	return begin + ml::algorithm::q_ary_range_count< Q, StepT >( begin, end, q, q + Width );
+}
+
+
+/// Adapts search of records by projection to their key, to the signature 
+/// of search functions.
+/// Used for benchmarking only.
+template< unsigned Q, typename StepT >
+const test_record* projected_lower_bound( 
+		const test_record* begin, const test_record* end, const std::int64_t& q )
+{
+	return ml::algorithm::q_ary_lower_bound< Q, StepT >( begin, end, q, 
+			std::less< std::int64_t >(), &test_record::_key );
 }
 
 
@@ -164,6 +1077,181 @@ clock_type::duration run_searches(
 }
 
 
+/// Same as 'run_searches()', but for an index, prebuilt over the sorted 
+/// array (its 'lower_bound()' returns rank of the result).
+template< typename IndexT, typename ValueType >
+clock_type::duration run_index_searches( 
+		const IndexT& index, 
+		ValueType start_q, 
+		ValueType finish_q, 
+		ValueType step_q )
+{
+	clock_type::time_point start_time = clock_type::now();
+	// Search
+	for ( ValueType q = start_q; q <= finish_q; q += step_q ) {
+		// Just add the rank to collector.
+		collector += index.lower_bound( q );
+	}
+	// Track
+	clock_type::duration dur = clock_type::now() - start_time;
+	std::cout << std::chrono::duration_cast< std::chrono::milliseconds >( dur ).count()
+			<< " msc" << std::endl;
+	return dur;
+}
+
+
+/// Same as 'run_searches()', but for a search function 'search_f', 
+/// which is given every query of 'queries' (and returns rank of the 
+/// result).
+template< typename SearchT, typename ValueType >
+clock_type::duration run_query_searches( 
+		const SearchT& search_f, 
+		const std::vector< ValueType >& queries )
+{
+	clock_type::time_point start_time = clock_type::now();
+	// Search
+	for ( const ValueType& q : queries ) {
+		// Just add the rank to collector.
+		collector += search_f( q );
+	}
+	// Track
+	clock_type::duration dur = clock_type::now() - start_time;
+	std::cout << std::chrono::duration_cast< std::chrono::milliseconds >( dur ).count()
+			<< " msc" << std::endl;
+	return dur;
+}
+
+
+/// Same as 'run_searches()', but for a batch search function 'batch_search_f',
+/// which is given the queries by batches of 'batch_size'.
+template< typename RanIt, typename ValueType >
+clock_type::duration run_batch_searches( 
+		RanIt* (*batch_search_f)( RanIt begin, RanIt end, 
+				const ValueType* queries_begin, const ValueType* queries_end, 
+				RanIt* out ), 
+		RanIt begin, RanIt end, 
+		ValueType start_q, 
+		ValueType finish_q, 
+		ValueType step_q, 
+		int batch_size = 1024 )
+{
+	std::vector< ValueType > queries( batch_size );
+	std::vector< RanIt > results( batch_size );
+	clock_type::duration dur = clock_type::duration::zero();
+	for ( ValueType q = start_q; q <= finish_q; ) {
+		// Prepare the next batch (not timed)
+		int count = 0;
+		for ( ; count < batch_size && q <= finish_q; ++count, q += step_q )
+			queries[ count ] = q;
+		// Search
+		clock_type::time_point start_time = clock_type::now();
+		(*batch_search_f)( begin, end, 
+				queries.data(), queries.data() + count, 
+				results.data() );
+		dur += clock_type::now() - start_time;
+		// Just add the offsets to collector.
+		for ( int i = 0; i < count; ++i )
+			collector += (results[ i ] - begin);
+	}
+	// Track
+	std::cout << std::chrono::duration_cast< std::chrono::milliseconds >( dur ).count()
+			<< " msc" << std::endl;
+	return dur;
+}
+
+
+/// Searcher of a sorted array, which accepts 'Q' at run time (so the 
+/// compiler can't turn divisions by it into multiplications), optionally
+/// by a precomputed schedule. Its 'lower_bound()' returns rank of the 
+/// result, as the ones of indexes do.
+template< typename ValueType >
+struct dynamic_q_searcher {
+	const ValueType* _begin;
+	const ValueType* _end;
+	unsigned _q;
+	bool _by_divider;   // Divide by reciprocals, instead of 'div' instructions
+	bool _by_schedule;  // Use the precomputed schedule
+	ml::algorithm::q_ary_divider _divider;
+	ml::algorithm::q_ary_search_schedule _schedule;
+
+	dynamic_q_searcher( const ValueType* begin, const ValueType* end, unsigned q, 
+			bool by_divider, bool by_schedule )
+		: _begin( begin ), _end( end ), _q( q ), 
+		  _by_divider( by_divider ), _by_schedule( by_schedule ), 
+		  _divider( q ), 
+		  _schedule( q, (ml::algorithm::length_t)(end - begin), 2 * q )
+		{}
+
+	std::size_t lower_bound( const ValueType& q ) const
+	{
+		std::less< ValueType > pred;
+		if ( _by_schedule )
+			return ml::algorithm::q_ary_dynamic_search( _schedule, _begin, q, pred ) - _begin;
+		if ( _by_divider )
+			return ml::algorithm::q_ary_dynamic_search( _divider, 2 * _q, 
+					_begin, _end, q, pred ) - _begin;
+		// Plain divisions
+		const ValueType* begin = _begin;
+		ml::algorithm::length_t length = (ml::algorithm::length_t)(_end - _begin);
+		while ( length >= 2 * _q )
+			ml::algorithm::_q_ary_dynamic_step( begin, length, length / _q, _q, q, pred );
+		return ml::algorithm::_q_ary_linear_search( begin, length, q, pred ) - _begin;
+	}
+};
+
+/// Adapts search by a precomputed schedule of a compile-time 'Q' to
+/// the interface of indexes.
+template< unsigned Q, typename StepT, typename ValueType >
+struct scheduled_searcher {
+	const ValueType* _begin;
+	ml::algorithm::q_ary_search_schedule _schedule;
+
+	scheduled_searcher( const ValueType* begin, const ValueType* end )
+		: _begin( begin ), 
+		  _schedule( ml::algorithm::q_ary_search_schedule::make< Q >( 
+				(ml::algorithm::length_t)(end - begin) ) )
+		{}
+
+	std::size_t lower_bound( const ValueType& q ) const
+		{ return ml::algorithm::q_ary_search< Q, StepT >( 
+				_schedule, _begin, q, std::less< ValueType >() ) - _begin; }
+};
+
+/// Benchmarks Q-ary search with the given 'Q', with fragment lengths 
+/// computed on every step vs. taken from a precomputed schedule, and
+/// the same for 'Q' known only at run time.
+template< unsigned Q, typename ValueType >
+void run_schedule_searches( 
+		ValueType* begin, ValueType* end, 
+		ValueType start_q, 
+		ValueType finish_q, 
+		ValueType step_q )
+{
+	std::cout << "\t q_ary_search< " << Q << ", branchless, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< Q, 
+					ml::algorithm::q_ary_branchless_step, ValueType*, ValueType >,
+			begin, end, 
+			start_q, finish_q, step_q );
+	std::cout << "\t q_ary_search< " << Q << ", branchless, ... >( schedule ) ... ";
+	run_index_searches( 
+			scheduled_searcher< Q, ml::algorithm::q_ary_branchless_step, ValueType >( begin, end ), 
+			start_q, finish_q, step_q );
+	std::cout << "\t q_ary_dynamic_search( " << Q << ", div ) ... ";
+	run_index_searches( 
+			dynamic_q_searcher< ValueType >( begin, end, Q, false, false ), 
+			start_q, finish_q, step_q );
+	std::cout << "\t q_ary_dynamic_search( " << Q << ", divider ) ... ";
+	run_index_searches( 
+			dynamic_q_searcher< ValueType >( begin, end, Q, true, false ), 
+			start_q, finish_q, step_q );
+	std::cout << "\t q_ary_dynamic_search( " << Q << ", schedule ) ... ";
+	run_index_searches( 
+			dynamic_q_searcher< ValueType >( begin, end, Q, false, true ), 
+			start_q, finish_q, step_q );
+}
+
+
+/// Runs the tests, and then the benchmarks (unless '--tests' is given).
 int main( int argc, char* argv[] )
 {
 	std::cout << "Testing search algorithms: " << std::endl;
@@ -185,8 +1273,323 @@ int main( int argc, char* argv[] )
 	//
 	std::cout << "\t _6_ary_search< int >() ..." << std::endl;
 	test_search_on_sorted_int_array( & ml::algorithm::_6_ary_lower_bound< const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 8, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 8, 
+			ml::algorithm::q_ary_branchy_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 16, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 16, 
+			ml::algorithm::q_ary_branchy_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 32, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 32, 
+			ml::algorithm::q_ary_branchy_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 4, branchless, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 4, 
+			ml::algorithm::q_ary_branchless_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 8, branchless, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 8, 
+			ml::algorithm::q_ary_branchless_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 16, branchless, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 16, 
+			ml::algorithm::q_ary_branchless_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 4, simd, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 4, 
+			ml::algorithm::q_ary_simd_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 9, simd, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 9, 
+			ml::algorithm::q_ary_simd_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 17, simd, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 17, 
+			ml::algorithm::q_ary_simd_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 5 / 33, simd, int8 / int16 >() ..." << std::endl;
+	test_simd_step_on_sorted_narrow_int_array< 5, std::int8_t >();
+	test_simd_step_on_sorted_narrow_int_array< 33, std::int8_t >();
+	test_simd_step_on_sorted_narrow_int_array< 5, std::int16_t >();
+	test_simd_step_on_sorted_narrow_int_array< 33, std::int16_t >();
+	//
+	std::cout << "\t q_ary_search< 4, runtime parameters, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & runtime_parameters_lower_bound< 4, 4, const int*, int > );
+	test_search_on_sorted_int_array( & runtime_parameters_lower_bound< 4, 100, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 3, static parameters, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & static_parameters_lower_bound< 3, 3, const int*, int > );
+	test_search_on_sorted_int_array( & static_parameters_lower_bound< 3, 12, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 4, 6G values >() ..." << std::endl;
+	test_search_on_huge_virtual_sequence( & ml::algorithm::q_ary_lower_bound< 4, 
+			ml::algorithm::q_ary_branchy_step, virtual_sequence_iterator, long long > );
+	//
+	std::cout << "\t q_ary_search< 16, branchless, 6G values >() ..." << std::endl;
+	test_search_on_huge_virtual_sequence( & ml::algorithm::q_ary_lower_bound< 16, 
+			ml::algorithm::q_ary_branchless_step, virtual_sequence_iterator, long long > );
+	//
+	std::cout << "\t q_ary_interpolation_search< 4, 6G values >() ..." << std::endl;
+	test_search_on_huge_virtual_sequence( & ml::algorithm::q_ary_interpolation_lower_bound< 4, 
+			ml::algorithm::q_ary_branchy_step, virtual_sequence_iterator, long long > );
+	//
+	std::cout << "\t q_ary_search< 4, simd_tail< branchless >, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 4, 
+			ml::algorithm::q_ary_simd_tail_step<>, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 3, simd_tail< branchy, 5 >, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 3, 
+			ml::algorithm::q_ary_simd_tail_step< ml::algorithm::q_ary_branchy_step, 5 >, 
+			const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 4, prefetching< branchless >, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound< 4, 
+			ml::algorithm::q_ary_prefetching_step< ml::algorithm::q_ary_branchless_step >, 
+			const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 4, prefetching< branchy >, 128-byte records >() ..." << std::endl;
+	test_projected_search_on_sorted_records< 4, 
+			ml::algorithm::q_ary_prefetching_step< ml::algorithm::q_ary_branchy_step >, 
+			test_wide_record >();
+	//
+	std::cout << "\t q_ary_interpolation_search< 4, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_interpolation_lower_bound< 4, 
+			ml::algorithm::q_ary_branchy_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_interpolation_search< 8, branchless, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_interpolation_lower_bound< 8, 
+			ml::algorithm::q_ary_branchless_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_interpolation_search< 4, infinite borders >() ..." << std::endl;
+	test_interpolation_search_on_infinite_borders< 4, ml::algorithm::q_ary_branchy_step >();
+	//
+	std::cout << "\t q_ary_search< 4, schedule, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & scheduled_lower_bound< 4, 
+			ml::algorithm::q_ary_branchy_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_search< 8, simd, schedule, int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & scheduled_lower_bound< 8, 
+			ml::algorithm::q_ary_simd_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_dynamic_search( 5, int ) ..." << std::endl;
+	test_search_on_sorted_int_array( & dynamic_lower_bound< 5, const int*, int > );
+	//
+	std::cout << "\t q_ary_auto_lower_bound< int >() ..." << std::endl;
+	test_search_on_sorted_int_array( & ml::algorithm::q_ary_auto_lower_bound< 
+			ml::algorithm::q_ary_branchless_step, const int*, int > );
+	//
+	std::cout << "\t q_ary_auto_lower_bound< int >( profile ) ..." << std::endl;
+	{
+		// Buckets with compiled and with dynamic 'Q'
+		ml::algorithm::q_ary_default_tuning_profile() = ml::algorithm::q_ary_tuning_profile( "i4", {
+				{ 8, 2, 2 }, { 10, 7, 7 }, { 12, 3, 12 }, { SIZE_MAX, 5, 10 } } );
+		test_search_on_sorted_int_array( & ml::algorithm::q_ary_auto_lower_bound< 
+				ml::algorithm::q_ary_branchy_step, const int*, int > );
+		ml::algorithm::q_ary_default_tuning_profile() = ml::algorithm::q_ary_tuning_profile();
+	}
+	//
+	std::cout << "\t q_ary_equal_range< 4, int >() ..." << std::endl;
+	test_range_search_on_sorted_int_array< 4, ml::algorithm::q_ary_branchy_step >();
+	//
+	std::cout << "\t q_ary_equal_range< 3, branchless, int >() ..." << std::endl;
+	test_range_search_on_sorted_int_array< 3, ml::algorithm::q_ary_branchless_step >();
+	//
+	std::cout << "\t q_ary_equal_range< 16, simd, int >() ..." << std::endl;
+	test_range_search_on_sorted_int_array< 16, ml::algorithm::q_ary_simd_step >();
+	//
+	std::cout << "\t q_ary_equal_range< 4, 6G values >() ..." << std::endl;
+	{
+		const virtual_sequence_iterator begin( 0 ), end( 4 * 1'500'000'001LL );
+		for ( long long q : { -1LL, 0LL, 77LL, 1'073'741'824LL, 1'500'000'000LL, 1'500'000'001LL } ) {
+			const auto range = ml::algorithm::q_ary_equal_range< 4 >( begin, end, q );
+			const long long expected = q < 0 ? 0 : (q < 1'500'000'001LL ? q * 4 : end - begin);
+			Q_ARY_CHECK( range.first - begin == expected );
+			Q_ARY_CHECK( range.second - range.first == (expected < end - begin && q >= 0 ? 4 : 0) );
+		}
+		Q_ARY_CHECK( ml::algorithm::q_ary_range_count< 8 >( begin, end, 10LL, 1'200'000'000LL ) 
+				== 4 * (1'200'000'000LL - 10LL) );
+	}
+	//
+	std::cout << "\t q_ary_lower_bound< 4, records by projection >() ..." << std::endl;
+	test_projected_search_on_sorted_records< 4, ml::algorithm::q_ary_branchy_step >();
+	//
+	std::cout << "\t q_ary_lower_bound< 8, branchless, records by projection >() ..." << std::endl;
+	test_projected_search_on_sorted_records< 8, ml::algorithm::q_ary_branchless_step >();
+	//
+	std::cout << "\t q_ary_lower_bound< 5, simd, records by projection >() ..." << std::endl;
+	test_projected_search_on_sorted_records< 5, ml::algorithm::q_ary_simd_step >();
+	//
+	std::cout << "\t q_ary_lower_bound< 16, simd_tail, records by projection >() ..." << std::endl;
+	test_projected_search_on_sorted_records< 16, ml::algorithm::q_ary_simd_tail_step<> >();
+	//
+	std::cout << "\t q_ary_lower_bound_batch< 4, int >() ..." << std::endl;
+	test_batch_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound_batch< 4, 
+			ml::algorithm::q_ary_branchless_step, ml::algorithm::q_ary_batch_group_size, 
+			const int*, const int*, const int** > );
+	//
+	std::cout << "\t q_ary_lower_bound_batch< 8, simd, int >() ..." << std::endl;
+	test_batch_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound_batch< 8, 
+			ml::algorithm::q_ary_simd_step, 5, 
+			const int*, const int*, const int** > );
+	//
+	std::cout << "\t q_ary_lower_bound_batch< 4, simd_tail< branchless >, int >() ..." << std::endl;
+	test_batch_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound_batch< 4, 
+			ml::algorithm::q_ary_simd_tail_step<>, ml::algorithm::q_ary_batch_group_size, 
+			const int*, const int*, const int** > );
+	//
+	std::cout << "\t q_ary_lower_bound_sorted_batch< 4, int >() ..." << std::endl;
+	test_batch_search_on_sorted_int_array( & ml::algorithm::q_ary_lower_bound_sorted_batch< 4, 
+			ml::algorithm::q_ary_branchy_step, const int*, const int*, const int** >, 
+			true );
+	//
+	std::cout << "\t q_ary_lower_bound_batch< 4, parallel, int >() ..." << std::endl;
+	test_batch_search_on_sorted_int_array( & parallel_lower_bound_batch< 4, const int*, int > );
+	//
+	std::cout << "\t q_ary_dispatched_lower_bound() (picked: " 
+			<< ml::algorithm::q_ary_isa_name( ml::algorithm::q_ary_best_search_kernels()._isa ) 
+			<< ") ..." << std::endl;
+	test_dispatched_search_kernels< std::int32_t >();
+	test_dispatched_search_kernels< std::int64_t >();
+	test_dispatched_search_kernels< float >();
+	test_dispatched_search_kernels< double >();
+#if defined( Q_ARY_SEARCH_HAVE_GPU )
+	//
+	if ( ml::algorithm::q_ary_gpu_available() ) {
+		std::cout << "\t q_ary_gpu_searcher::lower_bound_batch() ..." << std::endl;
+		test_gpu_batch_search< std::int32_t >();
+		test_gpu_batch_search< std::int64_t >();
+		test_gpu_batch_search< double >();
+	}
+	else
+		std::cout << "\t q_ary_gpu_searcher::lower_bound_batch() (no device, skipped)" << std::endl;
+#endif
+	//
+	std::cout << "\t q_ary_eytzinger_index< int, 4 >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_eytzinger_index< int, 4 >, const int*, int > );
+	//
+	std::cout << "\t q_ary_eytzinger_index< int, 16, simd >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_eytzinger_index< int, 16, ml::algorithm::q_ary_simd_step >, 
+			const int*, int > );
+	//
+	std::cout << "\t q_ary_static_tree< int, 4 >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_static_tree< int, 4 >, const int*, int > );
+	//
+	std::cout << "\t q_ary_static_tree< int >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_static_tree< int >, const int*, int > );
+	//
+	std::cout << "\t q_ary_static_tree< int, prefetching >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_static_tree< int, 16, 
+					ml::algorithm::q_ary_prefetching_step< ml::algorithm::q_ary_simd_step > >, 
+			const int*, int > );
 
 	//
+	std::cout << "\t q_ary_compressed_blocks< int >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_compressed_blocks< int >, const int*, int > );
+	//
+	std::cout << "\t q_ary_compressed_blocks< int64, int8 / int16 / int32 > ..." << std::endl;
+	test_compressed_blocks_on_sorted_int64_array< 
+			ml::algorithm::q_ary_compressed_blocks< std::int64_t, std::int8_t > >();
+	test_compressed_blocks_on_sorted_int64_array< 
+			ml::algorithm::q_ary_compressed_blocks< std::int64_t > >();
+	test_compressed_blocks_on_sorted_int64_array< 
+			ml::algorithm::q_ary_compressed_blocks< std::int64_t, std::int32_t > >();
+	test_compressed_blocks_on_sorted_int64_array< 
+			ml::algorithm::q_ary_compressed_blocks< std::int64_t, std::int32_t, 8, 4, 
+					ml::algorithm::q_ary_simd_step > >();
+	//
+	std::cout << "\t q_ary_string_index<>::lower_bound() ..." << std::endl;
+	test_string_index_on_sorted_strings< ml::algorithm::q_ary_string_index<> >();
+	test_string_index_on_sorted_strings< ml::algorithm::q_ary_string_index< 4, 
+			ml::algorithm::q_ary_branchy_step > >();
+	test_string_index_on_sorted_strings< ml::algorithm::q_ary_string_index< 16, 
+			ml::algorithm::q_ary_simd_step > >();
+	//
+	std::cout << "\t q_ary_counting_step< ... > ..." << std::endl;
+	test_counting_step();
+	//
+	std::cout << "\t q_ary_perf_counters ..." << std::endl;
+	test_perf_counters();
+	//
+	std::cout << "\t q_ary_huge_page_allocator< int > ..." << std::endl;
+	test_huge_page_allocator();
+	//
+	std::cout << "\t q_ary_numa_replicas< eytzinger >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_numa_replicas< ml::algorithm::q_ary_eytzinger_index< int > >, 
+			const int*, int > );
+	test_numa_replicas();
+
+	//
+	std::cout << "\t q_ary_key_column< int >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_key_column< int >, const int*, int > );
+	//
+	std::cout << "\t q_ary_key_column< int, eytzinger >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_key_column< int, 4, ml::algorithm::q_ary_branchy_step, 
+					ml::algorithm::q_ary_eytzinger_index< int > >, 
+			const int*, int > );
+	//
+	std::cout << "\t q_ary_key_column< int64, records >::equal_range() ..." << std::endl;
+	test_key_column_on_sorted_records< ml::algorithm::q_ary_key_column< std::int64_t, 8, 
+			ml::algorithm::q_ary_simd_step > >();
+	//
+	std::cout << "\t q_ary_key_column< int64, eytzinger, records >::equal_range() ..." << std::endl;
+	test_key_column_on_sorted_records< ml::algorithm::q_ary_key_column< std::int64_t, 4, 
+			ml::algorithm::q_ary_branchy_step, 
+			ml::algorithm::q_ary_eytzinger_index< std::int64_t > > >();
+	//
+	std::cout << "\t q_ary_key_column< int64, static tree, records >::equal_range() ..." << std::endl;
+	test_key_column_on_sorted_records< ml::algorithm::q_ary_key_column< std::int64_t, 4, 
+			ml::algorithm::q_ary_branchy_step, 
+			ml::algorithm::q_ary_static_tree< std::int64_t >, 2 > >();
+	//
+	std::cout << "\t q_ary_key_column< int64, learned index, records >::equal_range() ..." << std::endl;
+	test_key_column_on_sorted_records< ml::algorithm::q_ary_key_column< std::int64_t, 4, 
+			ml::algorithm::q_ary_branchy_step, 
+			ml::algorithm::q_ary_learned_index< std::int64_t >, 64 > >();
+	//
+#if defined( ML__ALGORITHM__Q_ARY_MMAP_SEARCHER_ENABLED )
+	std::cout << "\t q_ary_mmap_searcher< int64 >::lower_bound() ..." << std::endl;
+	test_mmap_searcher_on_sorted_file();
+	//
+#endif
+	std::cout << "\t q_ary_rcu_pointer< ... >::snapshot() ..." << std::endl;
+	test_rcu_pointer();
+	//
+	std::cout << "\t q_ary_sorted_vector< int >::lower_bound() ..." << std::endl;
+	test_sorted_vector< ml::algorithm::q_ary_sorted_vector< int > >( false );
+	test_sorted_vector< ml::algorithm::q_ary_sorted_vector< int > >( true );
+	//
+	std::cout << "\t q_ary_sorted_vector< int, static tree >::lower_bound() ..." << std::endl;
+	test_sorted_vector< ml::algorithm::q_ary_sorted_vector< int, 
+			ml::algorithm::q_ary_static_tree< int > > >( true );
+	//
+	std::cout << "\t q_ary_sorted_vector< int, learned index >::lower_bound() ..." << std::endl;
+	test_sorted_vector< ml::algorithm::q_ary_sorted_vector< int, 
+			ml::algorithm::q_ary_learned_index< int >, 8, ml::algorithm::q_ary_simd_step, 4 > >( true );
+	//
+	std::cout << "\t q_ary_learned_index< int, 2 >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_learned_index< int, 2 >, const int*, int > );
+	//
+	std::cout << "\t q_ary_learned_index< int >::lower_bound() ..." << std::endl;
+	test_search_on_sorted_int_array( & index_lower_bound< 
+			ml::algorithm::q_ary_learned_index< int >, const int*, int > );
+	//
+
+	// Only the tests (as ctest runs them)
+	if ( argc > 1 && std::string( argv[ 1 ] ) == "--tests" )
+		return 0;
 
 	std::default_random_engine gen;
 
@@ -195,7 +1598,9 @@ int main( int argc, char* argv[] )
 	typedef int data_t;  // Type of data, on which Q-ary search will run
 
 	const int N = 7'500;            // Length of the sorted array
-	data_t A[ N ];                  // The sorted array
+	std::vector< data_t, ml::algorithm::q_ary_huge_page_allocator< data_t > > 
+			storage( N );               // The sorted array (on huge pages, if long)
+	data_t* const A = storage.data();
 	const data_t start_q = 0;              // Start of the query range
 	const data_t finish_q = 10'000'000;    // Finish of the query range
 	const data_t step_q = 1;               // The step inside the query range
@@ -248,15 +1653,359 @@ int main( int argc, char* argv[] )
 			A, A+N, 
 			start_q, finish_q, step_q );
 
+	std::cout << "\t q_ary_search< 8, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 8, 
+					ml::algorithm::q_ary_branchy_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
 
-	// - Try move the array data to heap
-	//    or to global memory
+	std::cout << "\t q_ary_search< 16, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 16, 
+					ml::algorithm::q_ary_branchy_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
 
-	// + Try playing with array length
-	//
+	std::cout << "\t q_ary_search< 32, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 32, 
+					ml::algorithm::q_ary_branchy_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
 
-	// + Try searches on other data types
-	//
+	std::cout << "\t q_ary_search< 4, branchless, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 4, 
+					ml::algorithm::q_ary_branchless_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_search< 8, branchless, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 8, 
+					ml::algorithm::q_ary_branchless_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_search< 16, branchless, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 16, 
+					ml::algorithm::q_ary_branchless_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_search< 5, simd, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 5, 
+					ml::algorithm::q_ary_simd_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_search< 9, simd, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 9, 
+					ml::algorithm::q_ary_simd_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_search< 17, simd, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 17, 
+					ml::algorithm::q_ary_simd_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_dispatched_lower_bound< ... >() ... ";
+	run_searches( & dispatched_lower_bound< data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_search< 4, simd_tail< branchless >, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 4, 
+					ml::algorithm::q_ary_simd_tail_step<>, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_search< 8, simd_tail< branchy >, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 8, 
+					ml::algorithm::q_ary_simd_tail_step< ml::algorithm::q_ary_branchy_step >, 
+					data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_search< 4, prefetching< branchless >, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_lower_bound< 4, 
+					ml::algorithm::q_ary_prefetching_step< 
+							ml::algorithm::q_ary_branchless_step >, 
+					data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_interpolation_search< 4, ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_interpolation_lower_bound< 4, 
+					ml::algorithm::q_ary_branchy_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_lower_bound_batch< 4, ... >() ... ";
+	run_batch_searches( & ml::algorithm::q_ary_lower_bound_batch< 4, 
+					ml::algorithm::q_ary_branchless_step, 
+					ml::algorithm::q_ary_batch_group_size, 
+					data_t*, const data_t*, data_t** >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_lower_bound_batch< 8, ... >() ... ";
+	run_batch_searches( & ml::algorithm::q_ary_lower_bound_batch< 8, 
+					ml::algorithm::q_ary_branchless_step, 
+					ml::algorithm::q_ary_batch_group_size, 
+					data_t*, const data_t*, data_t** >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_dispatched_lower_bound_batch< ... >() ... ";
+	run_batch_searches( & dispatched_lower_bound_batch< data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_lower_bound_sorted_batch< 4, ... >() ... ";
+	run_batch_searches( & ml::algorithm::q_ary_lower_bound_sorted_batch< 4, 
+					ml::algorithm::q_ary_branchy_step, 
+					data_t*, const data_t*, data_t** >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_lower_bound_batch< 4, parallel, ... >() ... ";
+	run_batch_searches( & parallel_lower_bound_batch< 4, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q, 
+			1024 * 1024 );
+
+	std::cout << "\t q_ary_eytzinger_index< ..., 16 >::lower_bound() ... ";
+	run_index_searches( 
+			ml::algorithm::q_ary_eytzinger_index< data_t, 16 >( A, A+N ), 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_eytzinger_index< ..., 16, simd >::lower_bound() ... ";
+	run_index_searches( 
+			ml::algorithm::q_ary_eytzinger_index< data_t, 16, 
+					ml::algorithm::q_ary_simd_step >( A, A+N ), 
+			start_q, finish_q, step_q );
+
+	std::cout << "\t q_ary_static_tree< ... >::lower_bound() ... ";
+	run_index_searches( 
+			ml::algorithm::q_ary_static_tree< data_t >( A, A+N ), 
+			start_q, finish_q, step_q );
+	std::cout << "\t q_ary_static_tree< ..., prefetching >::lower_bound() ... ";
+	run_index_searches( 
+			ml::algorithm::q_ary_static_tree< data_t, 
+					ml::algorithm::q_ary_static_tree_fan_out< data_t >(), 
+					ml::algorithm::q_ary_prefetching_step< 
+							ml::algorithm::q_ary_simd_step > >( A, A+N ), 
+			start_q, finish_q, step_q );
+	std::cout << "\t\t (it would occupy " 
+			<< ml::algorithm::q_ary_static_tree< data_t >::memory_footprint( 100'000'000 ) 
+					/ (1024 * 1024)
+			<< " MB for N=10^8)" << std::endl;
+	std::cout << "\t q_ary_learned_index< ... >::lower_bound() ... ";
+	{
+		const ml::algorithm::q_ary_learned_index< data_t > index( A, A+N );
+		run_index_searches( index, 
+				start_q, finish_q, step_q );
+		std::cout << "\t\t (" << index.segment_count() << " segments, " 
+				<< index.memory_footprint() << " bytes)" << std::endl;
+	}
+
+
+	std::cout << "\t ... calibrating the tuning profile for N=" << N << " ..." << std::endl;
+	ml::algorithm::q_ary_default_tuning_profile() = 
+			ml::algorithm::q_ary_tuning_profile::calibrate< data_t >( 
+					{ N * sizeof(data_t) }, 20'000 );
+	std::cout << "\t\t (chose Q=" 
+			<< ml::algorithm::q_ary_default_tuning_profile().lookup( N )._q 
+			<< ", threshold=" 
+			<< ml::algorithm::q_ary_default_tuning_profile().lookup( N )._to_linear_threshold 
+			<< ")" << std::endl;
+	std::cout << "\t q_ary_auto_lower_bound< ... >() ... ";
+	run_searches( & ml::algorithm::q_ary_auto_lower_bound< 
+					ml::algorithm::q_ary_branchless_step, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+
+	std::cout << "Benchmarking precomputed schedules (before / after): " << std::endl;
+	run_schedule_searches< 2 >( A, A+N, start_q, finish_q, step_q );
+	run_schedule_searches< 4 >( A, A+N, start_q, finish_q, step_q );
+	run_schedule_searches< 8 >( A, A+N, start_q, finish_q, step_q );
+	run_schedule_searches< 16 >( A, A+N, start_q, finish_q, step_q );
+
+
+	std::cout << "Benchmarking search of records, by projection to the key: " << std::endl;
+	{
+		std::vector< test_record > records( N );
+		for ( int i = 0; i < N; ++i )
+			records[ i ] = { A[ i ], i };
+		const test_record* const records_begin = records.data();
+		const test_record* const records_end = records.data() + records.size();
+		std::cout << "\t q_ary_lower_bound< 4, branchless >( projection ) ... ";
+		run_searches( & projected_lower_bound< 4, ml::algorithm::q_ary_branchless_step >,
+				records_begin, records_end, 
+				(std::int64_t)start_q, (std::int64_t)finish_q, (std::int64_t)step_q );
+		std::cout << "\t q_ary_lower_bound< 16, simd >( projection ) ... ";
+		run_searches( & projected_lower_bound< 16, ml::algorithm::q_ary_simd_step >,
+				records_begin, records_end, 
+				(std::int64_t)start_q, (std::int64_t)finish_q, (std::int64_t)step_q );
+		std::cout << "\t q_ary_key_column< 16, simd > ... ";
+		run_index_searches( 
+				ml::algorithm::q_ary_key_column< std::int64_t, 16, ml::algorithm::q_ary_simd_step >( 
+						records_begin, records_end, &test_record::_key ), 
+				(std::int64_t)start_q, (std::int64_t)finish_q, (std::int64_t)step_q );
+		std::cout << "\t q_ary_key_column< eytzinger > ... ";
+		run_index_searches( 
+				ml::algorithm::q_ary_key_column< std::int64_t, 4, ml::algorithm::q_ary_branchy_step, 
+						ml::algorithm::q_ary_eytzinger_index< std::int64_t > >( 
+						records_begin, records_end, &test_record::_key ), 
+				(std::int64_t)start_q, (std::int64_t)finish_q, (std::int64_t)step_q );
+	}
+
+
+	std::cout << "Benchmarking search of a sorted container, with a delta: " << std::endl;
+	{
+		ml::algorithm::q_ary_sorted_vector< data_t, 
+				ml::algorithm::q_ary_eytzinger_index< data_t > > container( A, A+N );
+		for ( int i = 0; i < N / 32; ++i )
+			container.insert( A[ (i * 7919) % N ] + 1 );
+		container.flush();
+		container.wait();
+		const auto snapshot = container.snapshot();
+		std::cout << "\t q_ary_sorted_vector< eytzinger >( " << snapshot->base_size() 
+				<< " + " << snapshot->delta_size() << " values ) ... ";
+		run_index_searches( *snapshot, start_q, finish_q, step_q );
+		std::cout << "\t q_ary_sorted_vector< eytzinger >( snapshot per search ) ... ";
+		run_index_searches( container, start_q, finish_q, step_q );
+	}
+
+
+#if defined( ML__ALGORITHM__Q_ARY_MMAP_SEARCHER_ENABLED )
+	std::cout << "Benchmarking search of a memory mapped file: " << std::endl;
+	{
+		char path[] = "/tmp/q_ary_mmap_searcher_XXXXXX";
+		const int fd = ::mkstemp( path );
+		if ( fd >= 0 && ::write( fd, A, N * sizeof(data_t) ) == (ssize_t)(N * sizeof(data_t)) ) {
+			::close( fd );
+			ml::algorithm::q_ary_mmap_searcher< data_t > searcher;
+			for ( bool advise_reads : { false, true } ) {
+				if ( ! searcher.open( path, 0, ml::algorithm::q_ary_mmap_pinned_bytes, 
+						ml::algorithm::q_ary_mmap_fan_out, advise_reads ) )
+					break;
+				std::cout << "\t q_ary_mmap_searcher< ... >( " << searcher.pinned_count() 
+						<< " pinned keys" << (advise_reads ? ", read hints" : "") << " ) ... ";
+				run_index_searches( searcher, start_q, finish_q, step_q );
+			}
+		}
+		::unlink( path );
+	}
+#endif
+
+
+	std::cout << "Benchmarking search of a large array (huge pages / NUMA replicas): " << std::endl;
+	{
+		const int large_n = 16'000'000;
+		const data_t large_step_q = 10;
+		std::vector< data_t, ml::algorithm::q_ary_huge_page_allocator< data_t > > large( large_n );
+		prepare_sorted_int_array( large.data(), large_n, start_q, finish_q, gen );
+		std::cout << "\t q_ary_eytzinger_index< ... >( N=" << large_n << " ) ... ";
+		run_index_searches( 
+				ml::algorithm::q_ary_eytzinger_index< data_t >( large.begin(), large.end() ), 
+				start_q, finish_q, large_step_q );
+		typedef ml::algorithm::q_ary_eytzinger_index< data_t, 
+				ml::algorithm::q_ary_cache_line_fan_out< data_t >(), 
+				ml::algorithm::q_ary_branchless_step, 
+				ml::algorithm::q_ary_huge_page_allocator< data_t > > huge_index_t;
+		std::cout << "\t q_ary_eytzinger_index< ..., huge pages > ... ";
+		run_index_searches( huge_index_t( large.begin(), large.end() ), 
+				start_q, finish_q, large_step_q );
+		const ml::algorithm::q_ary_numa_replicas< huge_index_t > replicas( 
+				large.begin(), large.end() );
+		std::cout << "\t q_ary_numa_replicas< eytzinger, huge pages >( " 
+				<< replicas.replica_count() << " nodes ) ... ";
+		run_index_searches( replicas, start_q, finish_q, large_step_q );
+	}
+
+
+	std::cout << "Benchmarking search of 64-bit keys with locality (compressed blocks): " << std::endl;
+	{
+		// Timestamps, apart by [0, 2 * finish_q / N] on average
+		std::vector< std::int64_t > stamps( N );
+		for ( int i = 0; i < N; ++i )
+			stamps[ i ] = std::int64_t( 1 ) << 40 | A[ i ];
+		const std::int64_t stamps_start_q = stamps.front(), 
+				stamps_finish_q = stamps_start_q + (finish_q - start_q);
+		std::cout << "\t q_ary_eytzinger_index< int64 > ... ";
+		run_index_searches( 
+				ml::algorithm::q_ary_eytzinger_index< std::int64_t >( stamps.begin(), stamps.end() ), 
+				stamps_start_q, stamps_finish_q, (std::int64_t)step_q );
+		const ml::algorithm::q_ary_compressed_blocks< std::int64_t, std::int16_t > 
+				blocks_16( stamps.begin(), stamps.end() );
+		std::cout << "\t q_ary_compressed_blocks< int64, int16 >( " << blocks_16.block_count() 
+				<< " blocks, " << blocks_16.memory_footprint() << " bytes ) ... ";
+		run_index_searches( blocks_16, stamps_start_q, stamps_finish_q, (std::int64_t)step_q );
+		const ml::algorithm::q_ary_compressed_blocks< std::int64_t, std::int32_t > 
+				blocks_32( stamps.begin(), stamps.end() );
+		std::cout << "\t q_ary_compressed_blocks< int64, int32 >( " << blocks_32.block_count() 
+				<< " blocks, " << blocks_32.memory_footprint() << " bytes ) ... ";
+		run_index_searches( blocks_32, stamps_start_q, stamps_finish_q, (std::int64_t)step_q );
+	}
+
+
+	std::cout << "Benchmarking search of string keys (by cached prefixes): " << std::endl;
+	{
+		std::vector< std::string > keys( N );
+		for ( int i = 0; i < N; ++i )
+			keys[ i ] = "user/" + std::to_string( A[ i ] );
+		std::sort( keys.begin(), keys.end() );
+		std::vector< std::string > queries;
+		for ( data_t q = start_q; q <= finish_q; q += 10 * step_q )
+			queries.push_back( "user/" + std::to_string( q ) );
+		std::cout << "\t std::lower_bound< string >() ... ";
+		run_query_searches( [&]( const std::string& q ) {
+					return std::lower_bound( keys.begin(), keys.end(), q ) - keys.begin(); }, 
+				queries );
+		std::cout << "\t q_ary_lower_bound< 8, string >() ... ";
+		run_query_searches( [&]( const std::string& q ) {
+					return ml::algorithm::q_ary_lower_bound< 8 >( 
+							keys.begin(), keys.end(), q ) - keys.begin(); }, 
+				queries );
+		const ml::algorithm::q_ary_string_index<> index( keys.begin(), keys.end() );
+		std::cout << "\t q_ary_string_index<>::lower_bound() ... ";
+		run_query_searches( [&]( const std::string& q ) {
+					return index.lower_bound( q ); }, 
+				queries );
+		const ml::algorithm::q_ary_string_index< 16, ml::algorithm::q_ary_simd_step > 
+				simd_index( keys.begin(), keys.end() );
+		std::cout << "\t q_ary_string_index< 16, simd >::lower_bound() ... ";
+		run_query_searches( [&]( const std::string& q ) {
+					return simd_index.lower_bound( q ); }, 
+				queries );
+	}
+
+
+	std::cout << "Benchmarking range counts (two searches / one descent): " << std::endl;
+	std::cout << "\t q_ary_lower_bound< 4 >() x 2 ... ";
+	run_searches( & two_searches_range_count< 4, 
+					ml::algorithm::q_ary_branchy_step, 10'000, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+	std::cout << "\t q_ary_range_count< 4 >() ... ";
+	run_searches( & range_count< 4, 
+					ml::algorithm::q_ary_branchy_step, 10'000, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+	std::cout << "\t q_ary_lower_bound< 16, simd >() x 2 ... ";
+	run_searches( & two_searches_range_count< 16, 
+					ml::algorithm::q_ary_simd_step, 10'000, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+	std::cout << "\t q_ary_range_count< 16, simd >() ... ";
+	run_searches( & range_count< 16, 
+					ml::algorithm::q_ary_simd_step, 10'000, data_t*, data_t >,
+			A, A+N, 
+			start_q, finish_q, step_q );
+
+	// + Sweeps over array lengths, data types and distributions of
+	//    queries are in the benchmark suite ('q_ary_search_bench.cpp')
 
 	// + Try on other compilers
 	//
@@ -0,0 +1,177 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_ALLOCATOR_HPP
+#define ML__ALGORITHM__Q_ARY_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#if defined( __linux__ )
+#include <sys/mman.h>
+#define ML__ALGORITHM__Q_ARY_HUGE_PAGES_ENABLED 1
+#endif
+
+namespace ml {
+namespace algorithm {
+
+
+/// Size of cache line, assumed by the cache-aware layouts.
+constexpr std::size_t q_ary_cache_line_size = 64;
+
+
+/// Allocator, which aligns every allocated array by 'Alignment' bytes
+/// (by a cache line, by default).
+/// Used by the index builders, so that every node of an index starts
+/// at a cache line boundary.
+template< typename T, std::size_t Alignment = q_ary_cache_line_size >
+struct q_ary_aligned_allocator {
+	typedef T value_type;
+
+	template< typename U >
+	struct rebind {
+		typedef q_ary_aligned_allocator< U, Alignment > other;
+	};
+
+	q_ary_aligned_allocator() noexcept = default;
+
+	template< typename U >
+	q_ary_aligned_allocator( const q_ary_aligned_allocator< U, Alignment >& ) noexcept
+		{}
+
+	T* allocate( std::size_t n )
+		{ return static_cast< T* >( ::operator new(
+				n * sizeof(T), std::align_val_t( Alignment ) ) ); }
+
+	void deallocate( T* p, std::size_t ) noexcept
+		{ ::operator delete( p, std::align_val_t( Alignment ) ); }
+};
+
+template< typename T, typename U, std::size_t Alignment >
+inline bool operator==(
+		const q_ary_aligned_allocator< T, Alignment >&,
+		const q_ary_aligned_allocator< U, Alignment >& )
+	{ return true; }
+
+template< typename T, typename U, std::size_t Alignment >
+inline bool operator!=(
+		const q_ary_aligned_allocator< T, Alignment >&,
+		const q_ary_aligned_allocator< U, Alignment >& )
+	{ return false; }
+
+
+/// Size of a huge page (of the x86-64 and AArch64 default), by which
+/// 'q_ary_huge_page_allocator' backs the arrays.
+constexpr std::size_t q_ary_huge_page_size = std::size_t( 2 ) << 20;
+
+
+/// Allocator, which backs every array of at least one huge page of
+/// 'PageBytes' (2 MB, or 1 GB) by huge pages, so the whole array is
+/// covered by a few TLB entries, and the probes of a search, which land
+/// far apart, don't miss the TLB on almost every step.
+/// Arrays are mapped by 'mmap( MAP_HUGETLB )', which takes pages of the
+/// reserved pool of the kernel; if there are none, they are mapped
+/// aligned by 'PageBytes', and marked by 'madvise( MADV_HUGEPAGE )', so
+/// the kernel backs them by transparent huge pages (2 MB) instead.
+/// Smaller arrays (and all the arrays, on systems other than Linux) are
+/// allocated as by 'q_ary_aligned_allocator'.
+/// Pages are faulted in (so placed on a NUMA node) by the thread, which
+/// first writes them, as usual.
+template< typename T, std::size_t PageBytes = q_ary_huge_page_size >
+struct q_ary_huge_page_allocator {
+	static_assert( PageBytes >= q_ary_cache_line_size && (PageBytes & (PageBytes - 1)) == 0,
+			"Huge page size must be a power of 2." );
+
+	typedef T value_type;
+
+	template< typename U >
+	struct rebind {
+		typedef q_ary_huge_page_allocator< U, PageBytes > other;
+	};
+
+	q_ary_huge_page_allocator() noexcept = default;
+
+	template< typename U >
+	q_ary_huge_page_allocator( const q_ary_huge_page_allocator< U, PageBytes >& ) noexcept
+		{}
+
+	T* allocate( std::size_t n )
+	{
+		const std::size_t bytes = n * sizeof(T);
+#if defined( ML__ALGORITHM__Q_ARY_HUGE_PAGES_ENABLED )
+		if ( bytes >= PageBytes )
+			return static_cast< T* >( _map( _mapped_bytes( bytes ) ) );
+#endif
+		return static_cast< T* >( ::operator new(
+				bytes, std::align_val_t( q_ary_cache_line_size ) ) );
+	}
+
+	void deallocate( T* p, std::size_t n ) noexcept
+	{
+		const std::size_t bytes = n * sizeof(T);
+#if defined( ML__ALGORITHM__Q_ARY_HUGE_PAGES_ENABLED )
+		if ( bytes >= PageBytes ) {
+			::munmap( p, _mapped_bytes( bytes ) );
+			return;
+		}
+#endif
+		::operator delete( p, std::align_val_t( q_ary_cache_line_size ) );
+	}
+
+protected:
+	/// Count of bytes, mapped for an array of 'bytes' (whole huge pages).
+	static std::size_t _mapped_bytes( std::size_t bytes )
+		{ return (bytes + PageBytes - 1) & ~(PageBytes - 1); }
+
+#if defined( ML__ALGORITHM__Q_ARY_HUGE_PAGES_ENABLED )
+	/// Maps 'bytes' (whole huge pages), by huge pages of the reserved
+	/// pool, or else by transparent ones.
+	static void* _map( std::size_t bytes )
+	{
+		int huge_flags = MAP_HUGETLB;
+#if defined( MAP_HUGE_SHIFT )
+		huge_flags |= _log2( PageBytes ) << MAP_HUGE_SHIFT;
+#endif
+		void* p = ::mmap( nullptr, bytes, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | huge_flags, -1, 0 );
+		if ( p != MAP_FAILED )
+			return p;
+		// No reserved pages: map more, to trim it to an aligned range
+		const std::size_t padded_bytes = bytes + PageBytes;
+		p = ::mmap( nullptr, padded_bytes, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		if ( p == MAP_FAILED )
+			throw std::bad_alloc();
+		const std::uintptr_t begin = (std::uintptr_t)p;
+		const std::uintptr_t aligned = (begin + PageBytes - 1) & ~(std::uintptr_t)(PageBytes - 1);
+		if ( aligned != begin )
+			::munmap( p, aligned - begin );
+		if ( aligned + bytes != begin + padded_bytes )
+			::munmap( (void*)(aligned + bytes), begin + padded_bytes - (aligned + bytes) );
+#if defined( MADV_HUGEPAGE )
+		::madvise( (void*)aligned, bytes, MADV_HUGEPAGE );
+#endif
+		return (void*)aligned;
+	}
+
+	static constexpr int _log2( std::size_t x )
+		{ return x <= 1 ? 0 : 1 + _log2( x >> 1 ); }
+#endif
+};
+
+template< typename T, typename U, std::size_t PageBytes >
+inline bool operator==(
+		const q_ary_huge_page_allocator< T, PageBytes >&,
+		const q_ary_huge_page_allocator< U, PageBytes >& )
+	{ return true; }
+
+template< typename T, typename U, std::size_t PageBytes >
+inline bool operator!=(
+		const q_ary_huge_page_allocator< T, PageBytes >&,
+		const q_ary_huge_page_allocator< U, PageBytes >& )
+	{ return false; }
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_ALLOCATOR_HPP
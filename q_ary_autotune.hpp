@@ -0,0 +1,324 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_AUTOTUNE_HPP
+#define ML__ALGORITHM__Q_ARY_AUTOTUNE_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_search_schedule.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Values of 'Q', for which 'q_ary_auto_search()' has compiled kernels,
+/// and among which the calibration chooses.
+/// Profiles may name other values as well; those are searched by
+/// 'q_ary_dynamic_search()'.
+constexpr unsigned q_ary_tuning_candidates[] = { 2, 3, 4, 5, 6, 8, 16, 32 };
+
+/// Thresholds of switching to linear search, which the calibration tries,
+/// as multiples of 'Q'.
+constexpr unsigned q_ary_tuning_threshold_factors[] = { 1, 2, 4, 8 };
+
+
+/// Tag of value type 'T' in profile files, e.g. "i4" for 'int32_t',
+/// "u8" for 'uint64_t', or "f8" for 'double'.
+template< typename T >
+inline std::string _q_ary_type_tag()
+{
+	static_assert( std::is_arithmetic< T >::value,
+			"Profiles are kept for arithmetic types only." );
+	const char kind = std::is_floating_point< T >::value ? 'f'
+			: (std::is_signed< T >::value ? 'i' : 'u');
+	return std::string( 1, kind ) + std::to_string( sizeof(T) );
+}
+
+
+/// Profile of Q-ary search on one machine, for one value type: the best
+/// 'Q' and threshold of switching to linear search, for every bucket of
+/// array lengths.
+/// Made by 'calibrate()', which measures all the candidates on the
+/// current machine, and can be saved to a small text file, and loaded
+/// later (e.g. at the start of every run on the same machine).
+class q_ary_tuning_profile
+{
+public:
+	/// Parameters of search, for arrays of lengths up to '_max_length'.
+	struct entry_t {
+		std::size_t _max_length;
+		unsigned _q;
+		length_t _to_linear_threshold;
+	};
+
+	/// Sizes (in bytes) of the arrays, on which calibration runs by default:
+	/// resident in L1, L2, L3 caches and in DRAM, on most machines.
+	static constexpr std::size_t default_bucket_bytes[] = {
+			16 * 1024, 256 * 1024, 4 * 1024 * 1024, 64 * 1024 * 1024 };
+
+protected:
+	/// Tag of the value type (see '_q_ary_type_tag()').
+	std::string _type_tag;
+	/// Entries, by increasing '_max_length'. The last one covers all the
+	/// longer arrays as well.
+	std::vector< entry_t > _entries;
+
+public:
+	/// Profile with plain 4-ary search, for arrays of any length.
+	q_ary_tuning_profile()
+		: _entries{ { std::numeric_limits< std::size_t >::max(), 4, 8 } }
+		{}
+
+	q_ary_tuning_profile( const std::string& type_tag, std::vector< entry_t > entries )
+		: _type_tag( type_tag ), _entries( std::move( entries ) )
+		{ assert( ! _entries.empty() ); }
+
+	const std::string& type_tag() const
+		{ return _type_tag; }
+
+	const std::vector< entry_t >& entries() const
+		{ return _entries; }
+
+	/// Parameters of search, for arrays of 'length' values.
+	const entry_t& lookup( std::size_t length ) const
+	{
+		for ( const entry_t& entry : _entries )
+			if ( length <= entry._max_length )
+				return entry;
+		return _entries.back();
+	}
+
+	/// Measures all the candidate 'Q' and thresholds with step policy 'StepT',
+	/// on sorted arrays of random values of type 'T', of sizes 'bucket_bytes',
+	/// by 'query_count' random queries, and makes the profile of the best
+	/// ones. Every entry covers lengths up to the middle (geometric)
+	/// between its bucket and the next one.
+	/// Takes about a second per bucket.
+	template< typename T, typename StepT = q_ary_branchless_step >
+	static q_ary_tuning_profile calibrate(
+			const std::vector< std::size_t >& bucket_bytes = std::vector< std::size_t >(
+					std::begin( default_bucket_bytes ), std::end( default_bucket_bytes ) ),
+			std::size_t query_count = 200'000 )
+	{
+		std::mt19937_64 gen( 0x5eed );
+		std::vector< entry_t > entries;
+		for ( std::size_t b = 0; b < bucket_bytes.size(); ++b ) {
+			const std::size_t length = std::max< std::size_t >( bucket_bytes[ b ] / sizeof(T), 1 );
+			// The array, and the queries
+			std::vector< T > a( length );
+			std::vector< T > queries( query_count );
+			_fill_random( a, gen );
+			std::sort( a.begin(), a.end() );
+			_fill_random( queries, gen );
+			// The best of candidates
+			entry_t best = { 0, 4, 8 };
+			double best_time = std::numeric_limits< double >::max();
+			for ( unsigned q : q_ary_tuning_candidates )
+				for ( unsigned factor : q_ary_tuning_threshold_factors ) {
+					const entry_t entry = { 0, q, (length_t)(q * factor) };
+					const double time = _measure< StepT >( entry, a, queries );
+					if ( time < best_time ) {
+						best = entry;
+						best_time = time;
+					}
+				}
+			// Bound of the bucket
+			const std::size_t next_length = b + 1 < bucket_bytes.size()
+					? bucket_bytes[ b + 1 ] / sizeof(T)
+					: 0;
+			best._max_length = next_length > length
+					? (std::size_t)std::sqrt( (double)length * (double)next_length )
+					: std::numeric_limits< std::size_t >::max();
+			entries.push_back( best );
+		}
+		return q_ary_tuning_profile( _q_ary_type_tag< T >(), std::move( entries ) );
+	}
+
+	/// Saves the profile to file 'path'. Returns false on failure.
+	bool save( const std::string& path ) const
+	{
+		std::ofstream out( path );
+		out << "q_ary_tuning_profile 1 " << _type_tag << ' ' << _entries.size() << '\n';
+		for ( const entry_t& entry : _entries )
+			out << entry._max_length << ' ' << entry._q << ' '
+					<< entry._to_linear_threshold << '\n';
+		return (bool)out;
+	}
+
+	/// Loads the profile from file 'path', which must have been saved for
+	/// value type 'T'. Returns false (leaving the profile unchanged), if the
+	/// file can't be read, or is not such a profile.
+	template< typename T >
+	bool load( const std::string& path )
+	{
+		std::ifstream in( path );
+		std::string magic, type_tag;
+		unsigned version = 0;
+		std::size_t count = 0;
+		if ( ! (in >> magic >> version >> type_tag >> count)
+				|| magic != "q_ary_tuning_profile" || version != 1
+				|| type_tag != _q_ary_type_tag< T >() || count == 0 )
+			return false;
+		std::vector< entry_t > entries( count );
+		for ( entry_t& entry : entries ) {
+			if ( ! (in >> entry._max_length >> entry._q >> entry._to_linear_threshold)
+					|| entry._q < 2 )
+				return false;
+			if ( entry._to_linear_threshold < entry._q )
+				entry._to_linear_threshold = entry._q;
+		}
+		_type_tag = type_tag;
+		_entries = std::move( entries );
+		return true;
+	}
+
+protected:
+	template< typename T, typename Gen >
+	static void _fill_random( std::vector< T >& values, Gen& gen )
+	{
+		if constexpr ( std::is_floating_point< T >::value ) {
+			std::uniform_real_distribution< T > dist( 0, 1 );
+			for ( T& value : values )
+				value = dist( gen );
+		}
+		else {
+			for ( T& value : values )
+				value = (T)gen();
+		}
+	}
+
+	/// Time (in seconds) of searching all the 'queries' in 'a', by the
+	/// parameters of 'entry'. Best of 3 runs.
+	template< typename StepT, typename T >
+	static double _measure( const entry_t& entry,
+			const std::vector< T >& a, const std::vector< T >& queries );
+};
+
+
+/// Q-ary search, whose 'Q' and threshold of switching to linear search
+/// are taken from 'entry' (e.g. of a tuning profile).
+/// 'Q' from 'q_ary_tuning_candidates' is dispatched to its compiled
+/// kernel; other ones are searched by 'q_ary_dynamic_search()'.
+/// Returns the first position 'it' in the range [begin, end),
+/// on which 'pred(*it, q)' is not satisfied.
+template< typename StepT = q_ary_branchless_step,
+		typename RanIt, typename ValueT, typename PredT >
+inline RanIt q_ary_search(
+		const q_ary_tuning_profile::entry_t& entry,
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		PredT pred )
+{
+	const q_ary_runtime_parameters params = { entry._to_linear_threshold };
+	switch ( entry._q ) {
+	case 2:   return q_ary_search< 2, StepT >( begin, end, q, pred, params );
+	case 3:   return q_ary_search< 3, StepT >( begin, end, q, pred, params );
+	case 4:   return q_ary_search< 4, StepT >( begin, end, q, pred, params );
+	case 5:   return q_ary_search< 5, StepT >( begin, end, q, pred, params );
+	case 6:   return q_ary_search< 6, StepT >( begin, end, q, pred, params );
+	case 8:   return q_ary_search< 8, StepT >( begin, end, q, pred, params );
+	case 16:  return q_ary_search< 16, StepT >( begin, end, q, pred, params );
+	case 32:  return q_ary_search< 32, StepT >( begin, end, q, pred, params );
+	default:
+		return q_ary_dynamic_search( q_ary_divider( entry._q ), entry._to_linear_threshold,
+				begin, end, q, pred );
+	}
+}
+
+
+template< typename StepT, typename T >
+inline double q_ary_tuning_profile::_measure( const entry_t& entry,
+		const std::vector< T >& a, const std::vector< T >& queries )
+{
+	typedef std::chrono::steady_clock clock_type;
+	double best = std::numeric_limits< double >::max();
+	std::size_t collector = 0;
+	for ( int run = 0; run < 3; ++run ) {
+		const clock_type::time_point start = clock_type::now();
+		for ( const T& q : queries )
+			collector += (std::size_t)(q_ary_search< StepT >( entry,
+					a.data(), a.data() + a.size(), q, std::less< T >() ) - a.data());
+		const double time = std::chrono::duration< double >( clock_type::now() - start ).count();
+		best = time < best ? time : best;
+	}
+	// Keep the searches from being optimized out
+	volatile std::size_t sink = collector;
+	(void)sink;
+	return best;
+}
+
+
+/// Profile, used by 'q_ary_auto_search()' when none is given (plain 4-ary
+/// search, until it is replaced, e.g. by a calibrated or loaded one).
+/// It must not be replaced while other threads search by it.
+inline q_ary_tuning_profile& q_ary_default_tuning_profile()
+{
+	static q_ary_tuning_profile profile;
+	return profile;
+}
+
+
+/// Q-ary search, whose 'Q' and threshold of switching to linear search
+/// are the ones of 'profile' for arrays of length 'end - begin'.
+/// Returns the first position 'it' in the range [begin, end),
+/// on which 'pred(*it, q)' is not satisfied.
+template< typename StepT = q_ary_branchless_step,
+		typename RanIt, typename ValueT, typename PredT >
+inline RanIt q_ary_auto_search(
+		const q_ary_tuning_profile& profile,
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		PredT pred )
+{
+	return q_ary_search< StepT >( profile.lookup( (std::size_t)(end - begin) ),
+			begin, end, q, pred );
+}
+
+template< typename StepT = q_ary_branchless_step,
+		typename RanIt, typename ValueT >
+inline RanIt q_ary_auto_lower_bound(
+		const q_ary_tuning_profile& profile,
+		RanIt begin, RanIt end,
+		const ValueT& q )
+	{ return q_ary_auto_search< StepT >( profile, begin, end, q, std::less< ValueT >() ); }
+
+template< typename StepT = q_ary_branchless_step,
+		typename RanIt, typename ValueT >
+inline RanIt q_ary_auto_upper_bound(
+		const q_ary_tuning_profile& profile,
+		RanIt begin, RanIt end,
+		const ValueT& q )
+	{ return q_ary_auto_search< StepT >( profile, begin, end, q, std::less_equal< ValueT >() ); }
+
+/// Same as above, by 'q_ary_default_tuning_profile()'.
+template< typename StepT = q_ary_branchless_step,
+		typename RanIt, typename ValueT >
+inline RanIt q_ary_auto_lower_bound(
+		RanIt begin, RanIt end,
+		const ValueT& q )
+	{ return q_ary_auto_lower_bound< StepT >( q_ary_default_tuning_profile(), begin, end, q ); }
+
+template< typename StepT = q_ary_branchless_step,
+		typename RanIt, typename ValueT >
+inline RanIt q_ary_auto_upper_bound(
+		RanIt begin, RanIt end,
+		const ValueT& q )
+	{ return q_ary_auto_upper_bound< StepT >( q_ary_default_tuning_profile(), begin, end, q ); }
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_AUTOTUNE_HPP
@@ -0,0 +1,205 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_COMPRESSED_BLOCKS_HPP
+#define ML__ALGORITHM__Q_ARY_COMPRESSED_BLOCKS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_search_simd.hpp"
+#include "q_ary_allocator.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Default count of keys in one block of 'q_ary_compressed_blocks' with
+/// deltas of type 'DeltaT': as many, as fit in one cache line (e.g. 16
+/// 32-bit deltas, or 32 16-bit ones).
+template< typename DeltaT >
+constexpr unsigned q_ary_compressed_block_keys()
+	{ return (unsigned)(q_ary_cache_line_size / sizeof(DeltaT)); }
+
+
+/// Read-only index over a sorted array of integer keys of type 'T' (e.g.
+/// 64-bit timestamps, or sorted ids), compressed by frame of reference:
+/// keys are cut into blocks of up to 'BlockKeys' consecutive ones, and
+/// every block stores its first key in full (as its base), and all its
+/// keys as deltas of type 'DeltaT' from the base ('std::int8_t',
+/// 'std::int16_t' or 'std::int32_t'), in one cache line aligned run.
+/// A block is closed early when the next key is too far from its base,
+/// for a delta to hold it, so the blocks are full only if the keys are
+/// dense enough (with 16-bit deltas, 32 keys per cache line, where there
+/// would be 8 full 64-bit keys).
+/// The bases are the uncompressed top level: they are searched by
+/// 'q_ary_search< Q, StepT >()' with the given 'pred', while the one
+/// block, which can contain the result, is searched by comparing its
+/// deltas with the query minus its base, by vector compares (one or two
+/// per cache line block with AVX2 or AVX-512, up to four with SSE2 or
+/// NEON), when 'pred' is 'std::less' or 'std::less_equal'; other
+/// predicates decode the block's keys, and call 'pred' on them.
+/// Search results are ranks in the original sorted array.
+template< typename T,
+		typename DeltaT = std::int16_t,
+		unsigned BlockKeys = q_ary_compressed_block_keys< DeltaT >(),
+		unsigned Q = 8,
+		typename StepT = q_ary_branchless_step >
+class q_ary_compressed_blocks
+{
+	static_assert( std::is_integral< T >::value, "Compressed keys must be integers." );
+	static_assert( std::is_integral< DeltaT >::value && std::is_signed< DeltaT >::value
+			&& sizeof(DeltaT) <= sizeof(T),
+			"Deltas must be signed integers, not wider than the keys." );
+	static_assert( BlockKeys >= 1, "Compressed block needs at least 1 key." );
+
+public:
+	typedef T value_type;
+	typedef DeltaT delta_type;
+	typedef std::size_t size_type;
+
+	/// Count of keys, stored in one block.
+	static constexpr unsigned block_keys = BlockKeys;
+
+protected:
+	typedef typename std::make_unsigned< T >::type unsigned_t;
+
+	/// Delta of the unused slots of a block, greater than all the deltas
+	/// of keys (which are never negative).
+	static constexpr DeltaT _padding = std::numeric_limits< DeltaT >::max();
+
+	/// Length of the original array.
+	size_type _size = 0;
+	/// First key of every block.
+	std::vector< T, q_ary_aligned_allocator< T > > _bases;
+	/// Rank of the first key of every block, and the length of the array.
+	std::vector< size_type > _firsts;
+	/// Deltas of the keys of every block, 'BlockKeys' slots per block.
+	std::vector< DeltaT, q_ary_aligned_allocator< DeltaT > > _deltas;
+
+public:
+	q_ary_compressed_blocks() = default;
+
+	/// Builds the index over sorted range [begin, end).
+	template< typename RanIt >
+	q_ary_compressed_blocks( RanIt begin, RanIt end )
+		{ build( begin, end ); }
+
+	/// Rebuilds the index over sorted range [begin, end).
+	template< typename RanIt >
+	void build( RanIt begin, RanIt end )
+	{
+		_size = (size_type)(end - begin);
+		_bases.clear();
+		_firsts.clear();
+		_deltas.clear();
+		for ( size_type i = 0; i < _size; ) {
+			const T base = *(begin + i);
+			_bases.push_back( base );
+			_firsts.push_back( i );
+			unsigned k = 0;
+			for ( ; k < BlockKeys && i < _size; ++k, ++i ) {
+				const unsigned_t delta = _delta( *(begin + i), base );
+				if ( delta >= (unsigned_t)_padding )
+					break;
+				_deltas.push_back( (DeltaT)delta );
+			}
+			_deltas.insert( _deltas.end(), BlockKeys - k, _padding );
+		}
+		_firsts.push_back( _size );
+		_bases.shrink_to_fit();
+		_firsts.shrink_to_fit();
+		_deltas.shrink_to_fit();
+	}
+
+	/// Length of the original array.
+	size_type size() const
+		{ return _size; }
+
+	bool empty() const
+		{ return _size == 0; }
+
+	/// Count of the blocks.
+	size_type block_count() const
+		{ return _bases.size(); }
+
+	/// Returns rank of the first value 'v' of the original array,
+	/// for which 'pred(v, q)' is not satisfied.
+	template< typename PredT >
+	size_type search( const T& q, PredT pred ) const
+	{
+		// The result is in block 'block - 1', or is the first key of 'block'
+		const size_type block = (size_type)(q_ary_search< Q, StepT >(
+				_bases.data(), _bases.data() + _bases.size(), q, pred ) - _bases.data());
+		if ( block == 0 )
+			return 0;
+		const T base = _bases[ block - 1 ];
+		const DeltaT* const deltas = _deltas.data() + (block - 1) * BlockKeys;
+		if constexpr ( _q_ary_simd_predicate< PredT, T >::enabled ) {
+			constexpr bool strict = _q_ary_simd_predicate< PredT, T >::strict;
+			// 'pred( base, q )' holds, so 'q' is not less than 'base'
+			const unsigned_t delta = _delta( q, base );
+			if ( delta >= (unsigned_t)_padding )
+				// Past all the keys of the block
+				return _firsts[ block ];
+			return _firsts[ block - 1 ] + _count< strict >( deltas, (DeltaT)delta );
+		}
+		else {
+			const size_type length = _firsts[ block ] - _firsts[ block - 1 ];
+			size_type k = 1;
+			while ( k < length && pred( (T)((unsigned_t)base + (unsigned_t)deltas[ k ]), q ) )
+				++k;
+			return _firsts[ block - 1 ] + k;
+		}
+	}
+
+	/// Returns rank of the first value, which is not less than 'q'.
+	size_type lower_bound( const T& q ) const
+		{ return search( q, std::less< T >() ); }
+
+	/// Returns rank of the first value, which is greater than 'q'.
+	size_type upper_bound( const T& q ) const
+		{ return search( q, std::less_equal< T >() ); }
+
+	/// Checks if 'q' is present in the original array.
+	bool contains( const T& q ) const
+		{ return lower_bound( q ) != upper_bound( q ); }
+
+	/// Returns the count of bytes, occupied by the index.
+	size_type memory_footprint() const
+		{ return sizeof(*this)
+				+ _bases.capacity() * sizeof(T)
+				+ _firsts.capacity() * sizeof(size_type)
+				+ _deltas.capacity() * sizeof(DeltaT); }
+
+protected:
+	/// Distance from 'base' to 'key' (which is not less than it).
+	static unsigned_t _delta( const T& key, const T& base )
+		{ return (unsigned_t)key - (unsigned_t)base; }
+
+	/// Counts the deltas of a block, which are less than (or less or
+	/// equal to, when not 'Strict') 'q'; the padding never is.
+	template< bool Strict >
+	static size_type _count( const DeltaT* deltas, DeltaT q )
+	{
+		if constexpr ( _q_ary_simd_ops< DeltaT >::enabled )
+			return _q_ary_simd_count_contiguous< Strict >( deltas, (length_t)BlockKeys, q );
+		else {
+			// No vector instructions for 'DeltaT' on this target; of fixed
+			// length, so the compiler may still vectorize it
+			size_type count = 0;
+			for ( unsigned k = 0; k < BlockKeys; ++k )
+				count += (size_type)(Strict ? deltas[ k ] < q : deltas[ k ] <= q);
+			return count;
+		}
+	}
+};
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_COMPRESSED_BLOCKS_HPP
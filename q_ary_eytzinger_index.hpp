@@ -0,0 +1,237 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_EYTZINGER_INDEX_HPP
+#define ML__ALGORITHM__Q_ARY_EYTZINGER_INDEX_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_allocator.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Default fan-out of cache-aware indexes over values of type 'T':
+/// as many values as fit in one cache line (Q-1 keys, plus one unused
+/// slot, for alignment).
+template< typename T >
+constexpr unsigned q_ary_cache_line_fan_out()
+	{ return sizeof(T) * 2 <= q_ary_cache_line_size
+			? (unsigned)(q_ary_cache_line_size / sizeof(T))
+			: 2; }
+
+
+/// Index over a sorted array, which stores a permuted copy of it in
+/// Q-ary Eytzinger (BFS) order: it is an implicit B-tree, every node of
+/// which holds Q-1 keys, and has Q children.
+/// Node 'k' has children 'k*Q + 1', ..., 'k*Q + Q', so no pointers
+/// are stored.
+/// The Q-1 pivots of one Q-ary step are the keys of one node, which are
+/// contiguous and (with the default 'Q') fill exactly one cache line,
+/// while the strided pivots of 'q_ary_search()' touch a new cache line
+/// at almost every probe.
+/// Search results are ranks in the original sorted array, computed
+/// during descent, so no rank table is stored either.
+/// 'StepT' is the policy by which keys of one node are searched
+/// (its 'finish()' is called on them); wrapping it by
+/// 'q_ary_prefetching_step' enables prefetching of the next levels.
+template< typename T,
+		unsigned Q = q_ary_cache_line_fan_out< T >(),
+		typename StepT = q_ary_branchless_step,
+		typename Alloc = q_ary_aligned_allocator< T > >
+class q_ary_eytzinger_index
+{
+	static_assert( Q >= 2, "Q-ary index needs at least 2 children per node." );
+
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+
+	/// Count of keys, stored in one node.
+	static constexpr unsigned keys_per_node = Q - 1;
+	/// Distance between adjacent nodes, in values (there is one
+	/// unused slot at the end of every node).
+	static constexpr unsigned node_stride = Q;
+	/// How many levels ahead nodes are prefetched (see 'q_ary_prefetching_step').
+	static constexpr unsigned prefetch_distance = q_ary_prefetch_distance< StepT >::value;
+
+protected:
+	/// Length of the original array.
+	size_type _size = 0;
+	/// Nodes of the tree, in BFS order.
+	std::vector< T, Alloc > _nodes;
+	/// Count of nodes in the last level of the tree.
+	size_type _last_level_count = 0;
+	/// For every level 'd' of the tree: index of its first node,
+	/// count of nodes in the complete levels of a subtree of one node's
+	/// child, and count of last-level nodes, which such subtree can have.
+	struct level_t {
+		size_type _first;
+		size_type _child_complete_nodes;
+		size_type _child_last_level_width;
+	};
+	std::vector< level_t > _levels;
+
+public:
+	q_ary_eytzinger_index() = default;
+
+	/// Builds the index over sorted range [begin, end).
+	template< typename RanIt >
+	q_ary_eytzinger_index( RanIt begin, RanIt end )
+		{ build( begin, end ); }
+
+	/// Rebuilds the index over sorted range [begin, end).
+	template< typename RanIt >
+	void build( RanIt begin, RanIt end )
+	{
+		_size = (size_type)(end - begin);
+		_nodes.clear();
+		_levels.clear();
+		_last_level_count = 0;
+		if ( _size == 0 )
+			return;
+		const size_type node_count = (_size + keys_per_node - 1) / keys_per_node;
+		_nodes.resize( node_count * node_stride );
+		// Shape of the tree
+		size_type level_first = 0, level_width = 1;
+		while ( level_first + level_width < node_count ) {
+			_levels.push_back( { level_first, 0, 0 } );
+			level_first += level_width;
+			level_width *= Q;
+		}
+		_levels.push_back( { level_first, 0, 0 } );
+		_last_level_count = node_count - level_first;
+		// Sizes of children's subtrees, bottom up
+		size_type complete_nodes = 0, last_level_width = 1;
+		for ( size_type d = _levels.size() - 1; d-- > 0; ) {
+			_levels[ d ]._child_complete_nodes = complete_nodes;
+			_levels[ d ]._child_last_level_width = last_level_width;
+			complete_nodes = complete_nodes * Q + 1;
+			last_level_width *= Q;
+		}
+		// Keys, by in-order traversal.
+		// Positions past the end are padded by the last key, so the
+		// padding stays sorted.
+		size_type rank = 0;
+		_fill( 0, begin, rank, node_count );
+	}
+
+	/// Length of the original array.
+	size_type size() const
+		{ return _size; }
+
+	bool empty() const
+		{ return _size == 0; }
+
+	/// Returns rank of the first value 'v' of the original array,
+	/// for which 'pred(v, q)' is not satisfied.
+	template< typename PredT >
+	size_type search( const T& q, PredT pred ) const
+		{ const T* candidate;
+		  return _search( q, pred, candidate ); }
+
+	/// Returns rank of the first value, which is not less than 'q'.
+	size_type lower_bound( const T& q ) const
+		{ return search( q, std::less< T >() ); }
+
+	/// Returns rank of the first value, which is greater than 'q'.
+	size_type upper_bound( const T& q ) const
+		{ return search( q, std::less_equal< T >() ); }
+
+	/// Checks if 'q' is present in the original array.
+	bool contains( const T& q ) const
+		{ const T* candidate;
+		  std::less< T > pred;
+		  _search( q, pred, candidate );
+		  return candidate != nullptr && ! (q < *candidate); }
+
+	/// Returns the count of bytes, occupied by the index.
+	size_type memory_footprint() const
+		{ return sizeof(*this) + _nodes.capacity() * sizeof(T)
+				+ _levels.capacity() * sizeof(level_t); }
+
+protected:
+	template< typename RanIt >
+	void _fill( size_type k, RanIt begin, size_type& rank, size_type node_count )
+	{
+		if ( k >= node_count )
+			return;
+		T* node = _nodes.data() + k * node_stride;
+		for ( unsigned s = 0; s < keys_per_node; ++s ) {
+			_fill( k * Q + s + 1, begin, rank, node_count );
+			node[ s ] = *(begin + (rank < _size ? rank : _size - 1));
+			++rank;
+		}
+		node[ keys_per_node ] = node[ keys_per_node - 1 ];
+		_fill( k * Q + Q, begin, rank, node_count );
+	}
+
+	/// Descends the tree, returning the count of values satisfying 'pred'.
+	/// 'candidate' receives the first stored key, which doesn't satisfy
+	/// it, or 'nullptr'.
+	template< typename PredT >
+	size_type _search( const T& q, PredT& pred, const T*& candidate ) const
+	{
+		candidate = nullptr;
+		if ( _size == 0 )
+			return 0;
+		const T* nodes = _nodes.data();
+		const size_type depth = _levels.size();
+		size_type rank = 0;
+		size_type position = 0;  // Position of the node in its level
+		for ( size_type d = 0; ; ++d ) {
+			const level_t& level = _levels[ d ];
+			const T* node = nodes + (level._first + position) * node_stride;
+			if constexpr ( prefetch_distance > 0 ) {
+				// Descendants of the node at 'prefetch_distance' levels below
+				// are contiguous
+				if ( d + prefetch_distance < depth ) {
+					size_type first = position, count = 1;
+					for ( unsigned i = 0; i < prefetch_distance; ++i ) {
+						first *= Q;
+						count *= Q;
+					}
+					first += _levels[ d + prefetch_distance ]._first;
+					const size_type node_count = _nodes.size() / node_stride;
+					if ( first < node_count ) {
+						if ( count > node_count - first )
+							count = node_count - first;
+						_q_ary_prefetch_range( nodes + first * node_stride, 
+								count * node_stride * sizeof(T) );
+					}
+				}
+			}
+			// The whole node is searched, along with the unused slot (which
+			// repeats the last key), so vector kernels don't need a scalar
+			// remainder
+			size_type i = (size_type)(
+					StepT::finish( node, (length_t)node_stride, q, pred ) - node );
+			if ( i < keys_per_node )
+				candidate = node + i;
+			else
+				i = keys_per_node;
+			// Values, stored in 'i' left subtrees, and 'i' keys of the node
+			const size_type first_child_leaf = position * Q * level._child_last_level_width;
+			size_type last_level_nodes = 0;
+			if ( first_child_leaf < _last_level_count ) {
+				last_level_nodes = _last_level_count - first_child_leaf;
+				if ( last_level_nodes > i * level._child_last_level_width )
+					last_level_nodes = i * level._child_last_level_width;
+			}
+			rank += i + keys_per_node * (i * level._child_complete_nodes + last_level_nodes);
+			// Dive into i-th child
+			position = position * Q + i;
+			if ( d + 1 == depth || (d + 2 == depth && position >= _last_level_count) )
+				break;
+		}
+		return rank < _size ? rank : _size;
+	}
+};
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_EYTZINGER_INDEX_HPP
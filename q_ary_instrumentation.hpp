@@ -0,0 +1,271 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_INSTRUMENTATION_HPP
+#define ML__ALGORITHM__Q_ARY_INSTRUMENTATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "q_ary_search.hpp"
+
+#if defined( __linux__ )
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define ML__ALGORITHM__Q_ARY_PERF_COUNTERS_ENABLED 1
+#endif
+
+namespace ml {
+namespace algorithm {
+
+
+/// Counts of the work of the searches, made by 'q_ary_counting_step' on
+/// the calling thread (so they are not shared between threads). They cost
+/// a lookup of the thread local counts, and a few increments of them in
+/// memory, per step and per linear search, so counted searches are
+/// slower than plain ones, and are not meant to be timed.
+struct q_ary_search_stats {
+	/// Count of the Q-ary steps.
+	std::uint64_t _steps = 0;
+	/// Count of the pivots of the steps (Q-1 per step). The branchless and
+	/// the vector steps compare all of them, but the branchy one stops at
+	/// the first pivot, which doesn't satisfy the predicate, so this is an
+	/// upper bound of its comparisons.
+	std::uint64_t _step_pivots = 0;
+	/// Count of the linear searches, which finish the searches (for the
+	/// index layouts, of the nodes visited).
+	std::uint64_t _finishes = 0;
+	/// Total length of the linear searches.
+	std::uint64_t _tail_length = 0;
+
+	/// Counts of the calling thread.
+	static q_ary_search_stats& local()
+	{
+		thread_local q_ary_search_stats stats;
+		return stats;
+	}
+
+	void reset()
+		{ *this = q_ary_search_stats(); }
+
+	/// Average count of the steps, and length of the linear search, per
+	/// search (if every search finishes by one linear search).
+	double average_steps() const
+		{ return _finishes ? (double)_steps / (double)_finishes : 0.0; }
+	double average_tail_length() const
+		{ return _finishes ? (double)_tail_length / (double)_finishes : 0.0; }
+};
+
+
+/// Policy of a Q-ary step, which wraps another policy 'StepT', and counts
+/// its steps and linear searches in 'q_ary_search_stats::local()'.
+template< typename StepT >
+struct q_ary_counting_step {
+	template< unsigned Q, typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline void step(
+			RanIt& begin, LengthT& length,
+			LengthT fragment_length,
+			const ValueT& q,
+			PredT& pred )
+	{
+		q_ary_search_stats& stats = q_ary_search_stats::local();
+		++stats._steps;
+		stats._step_pivots += Q - 1;
+		StepT::template step< Q >( begin, length, fragment_length, q, pred );
+	}
+
+	template< typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline RanIt finish(
+			RanIt begin, LengthT length,
+			const ValueT& q,
+			PredT& pred )
+	{
+		q_ary_search_stats& stats = q_ary_search_stats::local();
+		++stats._finishes;
+		stats._tail_length += (std::uint64_t)length;
+		return StepT::finish( begin, length, q, pred );
+	}
+};
+
+template< typename StepT >
+struct q_ary_prefetch_distance< q_ary_counting_step< StepT > >
+	: q_ary_prefetch_distance< StepT > {};
+
+template< unsigned Q, typename StepT,
+		typename RanIt, typename ValueT, typename PredT >
+struct q_ary_step_parameters< Q, q_ary_counting_step< StepT >, RanIt, ValueT, PredT >
+	: q_ary_step_parameters< Q, StepT, RanIt, ValueT, PredT > {};
+
+
+/// Step policy 'StepT', counted by 'q_ary_counting_step' if
+/// 'ML__ALGORITHM__Q_ARY_SEARCH_STATS' is defined, and 'StepT' itself
+/// otherwise (so the counting costs nothing, when it's off).
+#if defined( ML__ALGORITHM__Q_ARY_SEARCH_STATS )
+template< typename StepT >
+using q_ary_instrumented_step = q_ary_counting_step< StepT >;
+#else
+template< typename StepT >
+using q_ary_instrumented_step = StepT;
+#endif
+
+
+/// Hardware events, counted by 'q_ary_perf_counters'.
+enum class q_ary_perf_event : unsigned {
+	cycles,
+	instructions,
+	branch_misses,
+	l1d_misses,
+	llc_misses,
+	dtlb_misses
+};
+
+constexpr unsigned q_ary_perf_event_count = 6;
+
+/// Name of event 'event' (as reported by the benchmark suite).
+inline const char* q_ary_perf_event_name( q_ary_perf_event event )
+{
+	static const char* const names[ q_ary_perf_event_count ] = {
+			"cycles", "instructions", "branch_misses",
+			"l1d_misses", "llc_misses", "dtlb_misses" };
+	return names[ (unsigned)event ];
+}
+
+
+/// Hardware performance counters of the calling thread (by Linux
+/// 'perf_event_open()', in user space only), for the events of
+/// 'q_ary_perf_event'.
+/// Every event is opened on its own, so the ones, which the processor or
+/// the kernel (e.g. by 'perf_event_paranoid', or in a container) doesn't
+/// allow, are just not 'available()'. Counts are scaled up by the time
+/// the counter was really running, if the kernel multiplexed it.
+/// On other systems than Linux, no event is available.
+class q_ary_perf_counters
+{
+protected:
+	int _fds[ q_ary_perf_event_count ];
+
+public:
+	/// Opens the counters (stopped).
+	q_ary_perf_counters()
+	{
+		for ( unsigned e = 0; e < q_ary_perf_event_count; ++e )
+			_fds[ e ] = _open( (q_ary_perf_event)e );
+	}
+
+	q_ary_perf_counters( const q_ary_perf_counters& ) = delete;
+	q_ary_perf_counters& operator=( const q_ary_perf_counters& ) = delete;
+
+	~q_ary_perf_counters()
+	{
+#if defined( ML__ALGORITHM__Q_ARY_PERF_COUNTERS_ENABLED )
+		for ( int fd : _fds )
+			if ( fd >= 0 )
+				::close( fd );
+#endif
+	}
+
+	/// Checks if 'event' is counted.
+	bool available( q_ary_perf_event event ) const
+		{ return _fds[ (unsigned)event ] >= 0; }
+
+	/// Checks if any event is counted.
+	bool any_available() const
+	{
+		for ( int fd : _fds )
+			if ( fd >= 0 )
+				return true;
+		return false;
+	}
+
+	/// Resets the counts, and starts counting.
+	void start()
+	{
+#if defined( ML__ALGORITHM__Q_ARY_PERF_COUNTERS_ENABLED )
+		for ( int fd : _fds )
+			if ( fd >= 0 ) {
+				::ioctl( fd, PERF_EVENT_IOC_RESET, 0 );
+				::ioctl( fd, PERF_EVENT_IOC_ENABLE, 0 );
+			}
+#endif
+	}
+
+	/// Stops counting.
+	void stop()
+	{
+#if defined( ML__ALGORITHM__Q_ARY_PERF_COUNTERS_ENABLED )
+		for ( int fd : _fds )
+			if ( fd >= 0 )
+				::ioctl( fd, PERF_EVENT_IOC_DISABLE, 0 );
+#endif
+	}
+
+	/// Count of 'event' since the last 'start()' (0, if not available).
+	std::uint64_t count( q_ary_perf_event event ) const
+	{
+#if defined( ML__ALGORITHM__Q_ARY_PERF_COUNTERS_ENABLED )
+		const int fd = _fds[ (unsigned)event ];
+		// Value, time enabled, time running
+		std::uint64_t values[ 3 ] = { 0, 0, 0 };
+		if ( fd < 0 || ::read( fd, values, sizeof(values) ) != (ssize_t)sizeof(values) )
+			return 0;
+		if ( values[ 2 ] != 0 && values[ 2 ] < values[ 1 ] )
+			return (std::uint64_t)((double)values[ 0 ] * (double)values[ 1 ] / (double)values[ 2 ]);
+		return values[ 0 ];
+#else
+		(void)event;
+		return 0;
+#endif
+	}
+
+protected:
+	/// Opens the counter of 'event', or returns -1.
+	static int _open( q_ary_perf_event event )
+	{
+#if defined( ML__ALGORITHM__Q_ARY_PERF_COUNTERS_ENABLED )
+		struct perf_event_attr attr = {};
+		attr.size = sizeof(attr);
+		const std::uint64_t read_miss =
+				(PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		switch ( event ) {
+		case q_ary_perf_event::cycles:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case q_ary_perf_event::instructions:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case q_ary_perf_event::branch_misses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+		case q_ary_perf_event::l1d_misses:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+			break;
+		case q_ary_perf_event::llc_misses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			break;
+		case q_ary_perf_event::dtlb_misses:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_DTLB | read_miss;
+			break;
+		}
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return (int)::syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 );
+#else
+		(void)event;
+		return -1;
+#endif
+	}
+};
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_INSTRUMENTATION_HPP
@@ -0,0 +1,102 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_INTERPOLATION_SEARCH_HPP
+#define ML__ALGORITHM__Q_ARY_INTERPOLATION_SEARCH_HPP
+
+#include <functional>
+#include <type_traits>
+
+#include "q_ary_search.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Default count of interpolation rounds, after which
+/// 'q_ary_interpolation_search()' gives up on interpolation.
+constexpr unsigned q_ary_interpolation_rounds = 2;
+
+
+/// Q-ary search, guided by interpolation, for arithmetic values which are
+/// distributed near uniformly (e.g. timestamps, or hashes).
+/// Every round estimates the position of 'q' from its value and the values
+/// at borders of the current range, and checks a narrow window of
+/// 'Q * _to_linear_threshold' values around it. If the window contains
+/// the result, it is searched by 'q_ary_search< Q, StepT >()'.
+/// Otherwise the range is narrowed by the missed window border, and also
+/// by one ordinary, equal-width Q-ary step.
+/// After 'Rounds' missed rounds it continues as plain 'q_ary_search()',
+/// so for any (skewed) data it costs at most 'Rounds' extra probes
+/// over O(log_Q N) steps, and never degrades to O(N).
+/// Returns the first position 'it' in the range [begin, end),
+/// on which 'pred(*it, q)' is not satisfied ('pred' must order values
+/// as numbers do, like 'std::less' and 'std::less_equal' do).
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		unsigned Rounds = q_ary_interpolation_rounds,
+		typename RanIt, typename ValueT, typename PredT >
+inline RanIt q_ary_interpolation_search(
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		PredT pred )
+{
+	static_assert( std::is_arithmetic< ValueT >::value,
+			"Interpolation needs arithmetic values." );
+	typedef q_ary_length_t< RanIt > wide_length_t;
+	const length_t threshold = q_ary_default_parameters< Q >::to_linear_threshold();
+	const length_t window = Q * threshold;
+	// Work with {begin, length}, not with [begin, end)
+	wide_length_t length = (wide_length_t)(end - begin);
+	for ( unsigned round = 0; round < Rounds && length > window; ++round ) {
+		// Values at the borders
+		const auto& first = *begin;
+		const auto& last = *(begin + (length - 1));
+		if ( ! pred( first, q ) )
+			return begin;
+		if ( pred( last, q ) )
+			return begin + length;
+		// So the result is in [begin + 1, begin + length - 1]
+		// Estimated position
+		const double span = (double)last - (double)first;
+		double fraction = span > 0.0 ? ((double)q - (double)first) / span : 0.5;
+		// Clamped, also if it's NaN (of infinite borders, or of the query)
+		fraction = fraction > 0.0 ? (fraction < 1.0 ? fraction : 1.0) : 0.0;
+		const wide_length_t estimate = (wide_length_t)(fraction * (length - 1));
+		const wide_length_t lo = estimate > window / 2 ? estimate - window / 2 : 0;
+		const wide_length_t hi = lo + window < length - 1 ? lo + window : length - 1;
+		// Check the window
+		const bool after_lo = pred( *(begin + lo), q );
+		const bool after_hi = pred( *(begin + hi), q );
+		if ( after_lo && ! after_hi )
+			return q_ary_search< Q, StepT >( begin + (lo + 1), begin + hi, q, pred );
+		// Missed, so narrow the range by the window border
+		if ( after_hi ) {
+			begin += hi + 1;
+			length -= hi + 1;
+		}
+		else
+			length = lo;
+		// One ordinary Q-ary step
+		if ( length >= threshold )
+			StepT::template step< Q >( begin, length, (wide_length_t)(length / Q), q, pred );
+	}
+	return q_ary_search< Q, StepT >( begin, begin + length, q, pred );
+}
+
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename ValueT >
+inline RanIt q_ary_interpolation_lower_bound(
+		RanIt begin, RanIt end,
+		const ValueT& q )
+	{ return q_ary_interpolation_search< Q, StepT >( begin, end, q, std::less< ValueT >() ); }
+
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename ValueT >
+inline RanIt q_ary_interpolation_upper_bound(
+		RanIt begin, RanIt end,
+		const ValueT& q )
+	{ return q_ary_interpolation_search< Q, StepT >( begin, end, q, std::less_equal< ValueT >() ); }
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_INTERPOLATION_SEARCH_HPP
@@ -0,0 +1,192 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_KEY_COLUMN_HPP
+#define ML__ALGORITHM__Q_ARY_KEY_COLUMN_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_allocator.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Column of keys of type 'T', extracted from a sorted range of records
+/// (by a projection, as in 'q_ary_lower_bound( begin, end, q, comp, proj )'),
+/// into a dense, cache line aligned array, which is searched instead of
+/// the records: one cache line holds '64 / sizeof(T)' keys, rather than
+/// a few (or one) records, so every probe touches as few lines as it can,
+/// and the records are only reached by the resulting rank.
+/// Keys are searched by 'q_ary_search< Q, StepT >()', unless 'IndexT' is
+/// given (e.g. 'q_ary_eytzinger_index< T >' or 'q_ary_static_tree< T >'),
+/// in which case they are also kept in the layout of that index.
+/// Records appended to the original range are followed by 'append()',
+/// which pushes their keys to the dense column. The index (if any) is not
+/// rebuilt on every append: keys past its end are searched in the column,
+/// and it is rebuilt only when they grow longer than '1 / RebuildRatio'
+/// of the indexed ones, or when the column is reallocated (which it is
+/// geometrically), so appends cost amortized O(1) per key.
+/// Search results are ranks in the original range; versions, which are
+/// given its 'begin', map them back to iterators.
+template< typename T,
+		unsigned Q = 4,
+		typename StepT = q_ary_branchy_step,
+		typename IndexT = void,
+		unsigned RebuildRatio = 8,
+		typename Alloc = q_ary_aligned_allocator< T > >
+class q_ary_key_column
+{
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+
+	/// If the keys are also kept in the layout of an index.
+	static constexpr bool indexed = ! std::is_void< IndexT >::value;
+
+protected:
+	/// Stand-in for the index type, when there is none.
+	struct no_index_t {};
+	typedef typename std::conditional< indexed, IndexT, no_index_t >::type index_t;
+
+	/// The keys, in order of the original range.
+	std::vector< T, Alloc > _keys;
+	/// The index, over the first '_indexed_size' keys.
+	index_t _index;
+	size_type _indexed_size = 0;
+
+public:
+	q_ary_key_column() = default;
+
+	/// Extracts keys 'proj(*it)' of the sorted range [begin, end).
+	template< typename RanIt, typename ProjT = q_ary_identity >
+	q_ary_key_column( RanIt begin, RanIt end, ProjT proj = ProjT() )
+		{ build( begin, end, proj ); }
+
+	/// Extracts keys 'proj(*it)' of the sorted range [begin, end), anew.
+	template< typename RanIt, typename ProjT = q_ary_identity >
+	void build( RanIt begin, RanIt end, ProjT proj = ProjT() )
+	{
+		_keys.clear();
+		_indexed_size = 0;
+		append( begin, end, proj );
+		rebuild();
+	}
+
+	/// Follows the records [begin, end), appended to the original range
+	/// (whose keys must not be less than the last one).
+	template< typename RanIt, typename ProjT = q_ary_identity >
+	void append( RanIt begin, RanIt end, ProjT proj = ProjT() )
+	{
+		// Grown geometrically, so reallocations are amortized O(1) per key
+		const T* const data = _keys.data();
+		const size_type size = _keys.size() + (size_type)(end - begin);
+		if ( size > _keys.capacity() )
+			_keys.reserve( size > 2 * _keys.capacity() ? size : 2 * _keys.capacity() );
+		for ( ; begin != end; ++begin ) {
+			_keys.push_back( std::invoke( proj, *begin ) );
+			assert( _keys.size() < 2 || ! (_keys.back() < _keys[ _keys.size() - 2 ]) );
+		}
+		if constexpr ( indexed ) {
+			// The index may refer to the keys (as 'q_ary_learned_index'
+			// does), so it's also rebuilt, once they are moved
+			if ( _keys.data() != data
+					|| (_keys.size() - _indexed_size) * RebuildRatio > _indexed_size )
+				rebuild();
+		}
+	}
+
+	/// Rebuilds the index (if any) over all the keys.
+	void rebuild()
+	{
+		if constexpr ( indexed )
+			_index.build( _keys.data(), _keys.data() + _keys.size() );
+		_indexed_size = _keys.size();
+	}
+
+	/// Length of the original range.
+	size_type size() const
+		{ return _keys.size(); }
+
+	bool empty() const
+		{ return _keys.empty(); }
+
+	/// The dense keys, in order of the original range.
+	const T* keys() const
+		{ return _keys.data(); }
+
+	/// Returns rank of the first record of the original range, for whose
+	/// key 'k' the 'pred(k, q)' is not satisfied.
+	template< typename PredT >
+	size_type search( const T& q, PredT pred ) const
+	{
+		const T* const keys = _keys.data();
+		if constexpr ( indexed ) {
+			const size_type rank = _index.search( q, pred );
+			if ( rank < _indexed_size || _indexed_size == _keys.size() )
+				return rank;
+			// The appended keys, not indexed yet
+			return (size_type)(q_ary_search< Q, StepT >(
+					keys + _indexed_size, keys + _keys.size(), q, pred ) - keys);
+		}
+		else
+			return (size_type)(q_ary_search< Q, StepT >(
+					keys, keys + _keys.size(), q, pred ) - keys);
+	}
+
+	/// Returns rank of the first record, whose key is not less than 'q'.
+	size_type lower_bound( const T& q ) const
+		{ return search( q, std::less< T >() ); }
+
+	/// Returns rank of the first record, whose key is greater than 'q'.
+	size_type upper_bound( const T& q ) const
+		{ return search( q, std::less_equal< T >() ); }
+
+	/// Returns the ranks of the records, whose keys are equal to 'q'.
+	std::pair< size_type, size_type > equal_range( const T& q ) const
+		{ return { lower_bound( q ), upper_bound( q ) }; }
+
+	/// Checks if a record with key 'q' is present in the original range.
+	bool contains( const T& q ) const
+		{ const size_type rank = lower_bound( q );
+		  return rank != _keys.size() && ! (q < _keys[ rank ]); }
+
+	/// Same as 'lower_bound( q )', but as an iterator into the original
+	/// range, starting from 'begin'.
+	template< typename RanIt >
+	RanIt lower_bound( RanIt begin, const T& q ) const
+		{ return begin + lower_bound( q ); }
+
+	/// Same as 'upper_bound( q )', but as an iterator into the original
+	/// range, starting from 'begin'.
+	template< typename RanIt >
+	RanIt upper_bound( RanIt begin, const T& q ) const
+		{ return begin + upper_bound( q ); }
+
+	/// Same as 'equal_range( q )', but as iterators into the original
+	/// range, starting from 'begin'.
+	template< typename RanIt >
+	std::pair< RanIt, RanIt > equal_range( RanIt begin, const T& q ) const
+		{ const std::pair< size_type, size_type > ranks = equal_range( q );
+		  return { begin + ranks.first, begin + ranks.second }; }
+
+	/// Returns the count of bytes, occupied by the column (with the index,
+	/// if any).
+	size_type memory_footprint() const
+	{
+		size_type bytes = sizeof(*this) + _keys.capacity() * sizeof(T);
+		if constexpr ( indexed )
+			bytes += _index.memory_footprint() - sizeof(index_t);
+		return bytes;
+	}
+};
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_KEY_COLUMN_HPP
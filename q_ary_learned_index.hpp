@@ -0,0 +1,215 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_LEARNED_INDEX_HPP
+#define ML__ALGORITHM__Q_ARY_LEARNED_INDEX_HPP
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "q_ary_search.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Default maximal error of the position, predicted by 'q_ary_learned_index'.
+constexpr unsigned q_ary_learned_index_epsilon = 32;
+
+
+/// Learned index over a sorted array of arithmetic values: a piecewise
+/// linear model (PGM-style), which predicts position of a value with an
+/// error of at most 'Epsilon'.
+/// Segments are found in one pass over the array, by the shrinking cone
+/// method: a segment grows while some slope, through its first point,
+/// passes within 'Epsilon' of the ranks of all its values.
+/// Only the first key, the rank and the slope of every segment are
+/// stored (a few KB for millions of near-uniform values), not the values
+/// themselves, so the array must outlive the index, and stay unchanged.
+/// A search finds the segment by 'q_ary_search< Q, StepT >()' over
+/// first keys of segments, and then the result, by the same search in
+/// the window of '2*Epsilon + 1' values around the predicted position.
+/// The error is guaranteed for ranks of the first occurrences of the
+/// values present in the array. If the window misses the result anyway
+/// (e.g. for a query, which falls into a long run of equal values), it
+/// is found by galloping from the window border, so the result is always
+/// exact, and costs O(log d) for a miss by 'd'.
+/// Search results are ranks in the original sorted array.
+template< typename T,
+		unsigned Epsilon = q_ary_learned_index_epsilon,
+		unsigned Q = 4,
+		typename StepT = q_ary_branchy_step >
+class q_ary_learned_index
+{
+	static_assert( std::is_arithmetic< T >::value,
+			"Learned index needs arithmetic values." );
+
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+
+	/// Maximal error of the predicted position.
+	static constexpr unsigned epsilon = Epsilon;
+
+protected:
+	/// The original array.
+	const T* _data = nullptr;
+	/// Length of the original array.
+	size_type _size = 0;
+	/// First key of every segment.
+	std::vector< T > _keys;
+	/// Rank of the first key, and slope of every segment.
+	struct segment_t {
+		size_type _rank;
+		double _slope;
+	};
+	std::vector< segment_t > _segments;
+
+public:
+	q_ary_learned_index() = default;
+
+	/// Builds the index over sorted contiguous range [begin, end).
+	template< typename RanIt >
+	q_ary_learned_index( RanIt begin, RanIt end )
+		{ build( begin, end ); }
+
+	/// Rebuilds the index over sorted contiguous range [begin, end).
+	template< typename RanIt >
+	void build( RanIt begin, RanIt end )
+	{
+		_size = (size_type)(end - begin);
+		_data = _size > 0 ? std::addressof( *begin ) : nullptr;
+		_keys.clear();
+		_segments.clear();
+		if ( _size == 0 )
+			return;
+		// Points are (value, rank of its first occurrence)
+		double x0 = 0.0, y0 = 0.0;  // Origin of the current segment
+		double min_slope = 0.0, max_slope = 0.0;
+		for ( size_type i = 0; i < _size; ++i ) {
+			if ( i > 0 && ! (_data[ i - 1 ] < _data[ i ]) )
+				continue;
+			const double x = (double)_data[ i ], y = (double)i;
+			if ( ! _segments.empty() && x > x0 ) {
+				// Range of slopes, which pass within 'Epsilon' of this point
+				const double low = (y - Epsilon - y0) / (x - x0);
+				const double high = (y + Epsilon - y0) / (x - x0);
+				if ( low <= max_slope && high >= min_slope ) {
+					min_slope = low > min_slope ? low : min_slope;
+					max_slope = high < max_slope ? high : max_slope;
+					continue;
+				}
+			}
+			// Start a new segment
+			if ( ! _segments.empty() )
+				_segments.back()._slope = _slope( min_slope, max_slope );
+			_keys.push_back( _data[ i ] );
+			_segments.push_back( { i, 0.0 } );
+			x0 = x;
+			y0 = y;
+			min_slope = 0.0;
+			max_slope = std::numeric_limits< double >::infinity();
+		}
+		_segments.back()._slope = _slope( min_slope, max_slope );
+	}
+
+	/// Length of the original array.
+	size_type size() const
+		{ return _size; }
+
+	bool empty() const
+		{ return _size == 0; }
+
+	/// Count of segments of the model.
+	size_type segment_count() const
+		{ return _segments.size(); }
+
+	/// Returns rank of the first value 'v' of the original array,
+	/// for which 'pred(v, q)' is not satisfied ('pred' must order values
+	/// as numbers do, like 'std::less' and 'std::less_equal' do).
+	template< typename PredT >
+	size_type search( const T& q, PredT pred ) const
+	{
+		if ( _size == 0 )
+			return 0;
+		// The segment: the last one, whose first key is not greater than 'q'
+		size_type s = (size_type)(q_ary_search< Q, StepT >(
+				_keys.data(), _keys.data() + _keys.size(), q,
+				std::less_equal< T >() ) - _keys.data());
+		s = s > 0 ? s - 1 : 0;
+		const segment_t& segment = _segments[ s ];
+		// Predicted position, clamped to the segment
+		const size_type next_rank = s + 1 < _segments.size()
+				? _segments[ s + 1 ]._rank
+				: _size;
+		const double offset = segment._slope * ((double)q - (double)_keys[ s ]);
+		size_type position = segment._rank;
+		if ( offset > 0.0 )
+			position = offset < (double)(next_rank - segment._rank)
+					? segment._rank + (size_type)offset
+					: next_rank;
+		// The window [lo, hi], where the result is expected
+		size_type lo = position > Epsilon ? position - Epsilon : 0;
+		size_type hi = position + Epsilon + 1 < _size ? position + Epsilon + 1 : _size;
+		if ( lo > 0 && ! pred( _data[ lo - 1 ], q ) ) {
+			// Missed to the left: gallop down from 'lo'
+			size_type distance = 2 * Epsilon + 2;
+			hi = lo - 1;
+			lo = hi > distance ? hi - distance : 0;
+			while ( lo > 0 && ! pred( _data[ lo - 1 ], q ) ) {
+				hi = lo - 1;
+				distance *= 2;
+				lo = hi > distance ? hi - distance : 0;
+			}
+		}
+		else if ( hi < _size && pred( _data[ hi ], q ) ) {
+			// Missed to the right: gallop up from 'hi'
+			size_type distance = 2 * Epsilon + 2;
+			lo = hi + 1;
+			hi = _size - lo > distance ? lo + distance : _size;
+			while ( hi < _size && pred( _data[ hi ], q ) ) {
+				lo = hi + 1;
+				distance *= 2;
+				hi = _size - lo > distance ? lo + distance : _size;
+			}
+		}
+		// The last mile
+		return (size_type)(q_ary_search< Q, StepT >(
+				_data + lo, _data + hi, q, pred ) - _data);
+	}
+
+	/// Returns rank of the first value, which is not less than 'q'.
+	size_type lower_bound( const T& q ) const
+		{ return search( q, std::less< T >() ); }
+
+	/// Returns rank of the first value, which is greater than 'q'.
+	size_type upper_bound( const T& q ) const
+		{ return search( q, std::less_equal< T >() ); }
+
+	/// Checks if 'q' is present in the original array.
+	bool contains( const T& q ) const
+		{ const size_type rank = lower_bound( q );
+		  return rank != _size && ! (q < _data[ rank ]); }
+
+	/// Returns the count of bytes, occupied by the index
+	/// (without the original array).
+	size_type memory_footprint() const
+		{ return sizeof(*this) + _keys.capacity() * sizeof(T)
+				+ _segments.capacity() * sizeof(segment_t); }
+
+protected:
+	/// Slope of a segment, whose feasible slopes are [min_slope, max_slope]
+	/// (unbounded, if it has only one point).
+	static double _slope( double min_slope, double max_slope )
+		{ return max_slope == std::numeric_limits< double >::infinity()
+				? 0.0
+				: (min_slope + max_slope) / 2; }
+};
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_LEARNED_INDEX_HPP
@@ -0,0 +1,285 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_MMAP_SEARCHER_HPP
+#define ML__ALGORITHM__Q_ARY_MMAP_SEARCHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_allocator.hpp"
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ML__ALGORITHM__Q_ARY_MMAP_SEARCHER_ENABLED 1
+#endif
+
+namespace ml {
+namespace algorithm {
+
+
+/// Default count of bytes of RAM, in which 'q_ary_mmap_searcher' keeps
+/// the pinned top levels of its search.
+constexpr std::size_t q_ary_mmap_pinned_bytes = std::size_t( 1 ) << 20;
+
+/// Default count of fragments of every step of 'q_ary_mmap_searcher' over
+/// the mapped file: how many reads it lets the device serve in parallel.
+constexpr unsigned q_ary_mmap_fan_out = 16;
+
+
+#if defined( ML__ALGORITHM__Q_ARY_MMAP_SEARCHER_ENABLED )
+
+/// Searcher of a file of sorted fixed-width keys of type 'T' (a raw
+/// array, in native byte order), which is memory mapped, and searched in
+/// place (with no copy), so it may be far larger than RAM.
+/// The file is seen as a sequence of read units (by default, OS pages),
+/// and every search touches as few of them as it can:
+///  - the first keys of every few units (as many as fit in 'pinned_bytes')
+///    are kept in RAM, as the pinned top levels of the implicit search
+///    tree, and searched by 'q_ary_search< Q, StepT >()', so no page of
+///    the file is touched by them,
+///  - the units between two such keys are searched by steps of up to
+///    'fan_out' fragments, which are whole units, so every pivot touches
+///    one unit; optionally (see 'open()'), pages of all the pivots of a
+///    step are hinted to the OS (by 'madvise( MADV_WILLNEED )') before any
+///    of them is probed, so they are read in parallel, and the step costs
+///    about one device latency,
+///  - the only unit, which can contain the result, is searched by
+///    'q_ary_search< Q, StepT >()'.
+/// Read-ahead of the OS is switched off for the mapping
+/// ('MADV_RANDOM'), as it only wastes the device bandwidth here.
+/// Search results are ranks of keys in the file.
+/// Available on POSIX systems only.
+template< typename T,
+		unsigned Q = 8,
+		typename StepT = q_ary_branchless_step >
+class q_ary_mmap_searcher
+{
+	static_assert( std::is_trivially_copyable< T >::value,
+			"Memory mapped keys must be trivially copyable." );
+
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+
+protected:
+	/// The mapped file.
+	bool _open = false;
+	const T* _data = nullptr;
+	size_type _size = 0;
+	size_type _mapped_bytes = 0;
+	/// Count of keys, and count of bytes, which one read unit has.
+	size_type _unit_keys = 1;
+	size_type _page_bytes = 4096;
+	/// Count of fragments of every step over the mapped keys.
+	size_type _fan_out = q_ary_mmap_fan_out;
+	/// If the reads are hinted to the OS (see 'open()').
+	bool _advise_reads = false;
+	/// First keys of every '_fence_stride' units (the pinned top levels).
+	std::vector< T, q_ary_aligned_allocator< T > > _fences;
+	size_type _fence_stride = 1;
+
+public:
+	q_ary_mmap_searcher() = default;
+
+	q_ary_mmap_searcher( const q_ary_mmap_searcher& ) = delete;
+	q_ary_mmap_searcher& operator=( const q_ary_mmap_searcher& ) = delete;
+
+	~q_ary_mmap_searcher()
+		{ close(); }
+
+	/// Maps the file at 'path', which must consist of whole keys, sorted.
+	/// 'read_unit' is the count of bytes, which the storage reads at once
+	/// (0 for the OS page size), and is rounded to whole keys.
+	/// 'advise_reads' enables the read hints, which is a system call per
+	/// pivot (or one per step, once its pivots are in adjacent units), so
+	/// it pays off only for files, which are mostly not cached; on cached
+	/// ones it's many times slower, so it's off by default.
+	/// Returns 'false', if the file can't be mapped.
+	bool open( const std::string& path,
+			size_type read_unit = 0,
+			size_type pinned_bytes = q_ary_mmap_pinned_bytes,
+			unsigned fan_out = q_ary_mmap_fan_out,
+			bool advise_reads = false )
+	{
+		close();
+		const int fd = ::open( path.c_str(), O_RDONLY );
+		if ( fd < 0 )
+			return false;
+		struct stat st;
+		if ( ::fstat( fd, &st ) != 0 || st.st_size % sizeof(T) != 0 ) {
+			::close( fd );
+			return false;
+		}
+		_mapped_bytes = (size_type)st.st_size;
+		_size = _mapped_bytes / sizeof(T);
+		if ( _size > 0 ) {
+			void* const p = ::mmap( nullptr, _mapped_bytes, PROT_READ, MAP_SHARED, fd, 0 );
+			if ( p == MAP_FAILED ) {
+				::close( fd );
+				_size = _mapped_bytes = 0;
+				return false;
+			}
+			_data = static_cast< const T* >( p );
+			::madvise( p, _mapped_bytes, MADV_RANDOM );
+		}
+		// The mapping stays valid without the descriptor
+		::close( fd );
+		const long page_bytes = ::sysconf( _SC_PAGESIZE );
+		_page_bytes = page_bytes > 0 ? (size_type)page_bytes : 4096;
+		if ( read_unit == 0 )
+			read_unit = _page_bytes;
+		_unit_keys = read_unit > sizeof(T) ? read_unit / sizeof(T) : 1;
+		_fan_out = fan_out >= 2 ? fan_out : 2;
+		_advise_reads = advise_reads;
+		_pin( pinned_bytes );
+		_open = true;
+		return true;
+	}
+
+	/// Unmaps the file.
+	void close()
+	{
+		if ( _data != nullptr )
+			::munmap( const_cast< T* >( _data ), _mapped_bytes );
+		_open = false;
+		_data = nullptr;
+		_size = _mapped_bytes = 0;
+		_fences.clear();
+		_fence_stride = 1;
+	}
+
+	bool is_open() const
+		{ return _open; }
+
+	/// Count of keys in the file.
+	size_type size() const
+		{ return _size; }
+
+	bool empty() const
+		{ return _size == 0; }
+
+	/// The mapped keys (which may be passed to any search of the library).
+	const T* data() const
+		{ return _data; }
+
+	/// Count of keys of one read unit.
+	size_type unit_keys() const
+		{ return _unit_keys; }
+
+	/// Count of the pinned keys.
+	size_type pinned_count() const
+		{ return _fences.size(); }
+
+	/// Returns rank of the first key 'k' of the file, for which
+	/// 'pred(k, q)' is not satisfied.
+	template< typename PredT >
+	size_type search( const T& q, PredT pred ) const
+	{
+		if ( _size == 0 )
+			return 0;
+		const size_type unit_count = (_size + _unit_keys - 1) / _unit_keys;
+		// The result is in one of units [begin_unit - 1, end_unit)
+		size_type begin_unit = 1, end_unit = unit_count;
+		if ( ! _fences.empty() ) {
+			// By the pinned levels: first key of unit 'begin_unit - 1'
+			// satisfies 'pred', while the one of 'end_unit' (if any) doesn't
+			const size_type fence = (size_type)(q_ary_search< Q, StepT >(
+					_fences.data(), _fences.data() + _fences.size(), q, pred ) - _fences.data());
+			if ( fence == 0 )
+				return 0;
+			begin_unit = (fence - 1) * _fence_stride + 1;
+			end_unit = fence * _fence_stride < unit_count ? fence * _fence_stride : unit_count;
+		}
+		// Q-ary steps over first keys of units, with whole units as fragments
+		size_type unit = begin_unit, length = end_unit - begin_unit;
+		while ( length >= 2 ) {
+			const size_type q_count = length < _fan_out ? length : _fan_out;
+			const size_type fragment_length = length / q_count;
+			if ( _advise_reads ) {
+				if ( fragment_length == 1 )
+					// Pivots are in adjacent units, so by one hint
+					_advise( unit + 1, q_count - 1 );
+				else
+					for ( size_type k = 1; k < q_count; ++k )
+						_advise( unit + k * fragment_length, 1 );
+			}
+			size_type count = 0;
+			for ( size_type k = 1; k < q_count; ++k )
+				count += (size_type)pred( _data[ (unit + k * fragment_length) * _unit_keys ], q );
+			unit += count * fragment_length;
+			// The last fragment is longer than the others
+			length = (count == q_count - 1)
+					? length - (q_count - 1) * fragment_length
+					: fragment_length;
+		}
+		if ( length == 1 && pred( _data[ unit * _unit_keys ], q ) )
+			++unit;
+		// The result is in unit 'unit - 1'
+		const size_type begin = (unit - 1) * _unit_keys;
+		const size_type end = begin + _unit_keys < _size ? begin + _unit_keys : _size;
+		if ( _advise_reads )
+			_advise( unit - 1, 1 );
+		return (size_type)(q_ary_search< Q, StepT >(
+				_data + begin, _data + end, q, pred ) - _data);
+	}
+
+	/// Returns rank of the first key, which is not less than 'q'.
+	size_type lower_bound( const T& q ) const
+		{ return search( q, std::less< T >() ); }
+
+	/// Returns rank of the first key, which is greater than 'q'.
+	size_type upper_bound( const T& q ) const
+		{ return search( q, std::less_equal< T >() ); }
+
+	/// Checks if 'q' is present in the file.
+	bool contains( const T& q ) const
+		{ const size_type rank = lower_bound( q );
+		  return rank != _size && ! (q < _data[ rank ]); }
+
+	/// Returns the count of bytes of RAM, occupied by the searcher
+	/// (without the mapped file).
+	size_type memory_footprint() const
+		{ return sizeof(*this) + _fences.capacity() * sizeof(T); }
+
+protected:
+	/// Keeps the first keys of every few units, as many as fit in
+	/// 'pinned_bytes'.
+	void _pin( size_type pinned_bytes )
+	{
+		const size_type unit_count = (_size + _unit_keys - 1) / _unit_keys;
+		const size_type max_count = pinned_bytes / sizeof(T);
+		if ( unit_count < 2 || max_count == 0 )
+			return;
+		_fence_stride = (unit_count + max_count - 1) / max_count;
+		const size_type fence_count = (unit_count + _fence_stride - 1) / _fence_stride;
+		_fences.resize( fence_count );
+		for ( size_type i = 0; i < fence_count; ++i )
+			_fences[ i ] = _data[ i * _fence_stride * _unit_keys ];
+	}
+
+	/// Hints the OS, that 'count' units from 'unit' will be read soon.
+	void _advise( size_type unit, size_type count ) const
+	{
+		const std::uintptr_t first = (std::uintptr_t)(_data + unit * _unit_keys);
+		std::uintptr_t last = (std::uintptr_t)(_data + (unit + count) * _unit_keys);
+		const std::uintptr_t end = (std::uintptr_t)_data + _mapped_bytes;
+		last = last < end ? last : end;
+		const std::uintptr_t page_first = first - first % _page_bytes;
+		::madvise( (void*)page_first, last - page_first, MADV_WILLNEED );
+	}
+};
+
+#endif // ML__ALGORITHM__Q_ARY_MMAP_SEARCHER_ENABLED
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_MMAP_SEARCHER_HPP
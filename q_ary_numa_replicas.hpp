@@ -0,0 +1,246 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_NUMA_REPLICAS_HPP
+#define ML__ALGORITHM__Q_ARY_NUMA_REPLICAS_HPP
+
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#define ML__ALGORITHM__Q_ARY_NUMA_ENABLED 1
+#endif
+
+namespace ml {
+namespace algorithm {
+
+
+/// Count of searches, after which 'q_ary_numa_replicas' checks
+/// again, on which NUMA node the calling thread runs.
+constexpr unsigned q_ary_numa_node_recheck_period = 256;
+
+
+/// NUMA nodes of the host, and their CPUs (as the kernel reports them in
+/// '/sys/devices/system/node'). On other systems than Linux, or if the
+/// kernel reports no nodes, there is one node with no CPUs listed.
+class q_ary_numa_topology
+{
+protected:
+	/// CPUs of every node.
+	std::vector< std::vector< unsigned > > _node_cpus;
+	/// Node of every CPU.
+	std::vector< unsigned > _cpu_nodes;
+
+public:
+	/// Reads the topology of the host.
+	q_ary_numa_topology()
+	{
+#if defined( ML__ALGORITHM__Q_ARY_NUMA_ENABLED )
+		for ( unsigned node = 0; ; ++node ) {
+			std::ifstream cpulist( "/sys/devices/system/node/node"
+					+ std::to_string( node ) + "/cpulist" );
+			if ( ! cpulist )
+				break;
+			std::string list;
+			std::getline( cpulist, list );
+			_node_cpus.push_back( _parse_cpu_list( list ) );
+			for ( unsigned cpu : _node_cpus.back() ) {
+				if ( cpu >= _cpu_nodes.size() )
+					_cpu_nodes.resize( cpu + 1, 0 );
+				_cpu_nodes[ cpu ] = node;
+			}
+		}
+#endif
+		if ( _node_cpus.empty() )
+			_node_cpus.emplace_back();
+	}
+
+	/// The topology of the host, read once.
+	static const q_ary_numa_topology& host()
+	{
+		static const q_ary_numa_topology topology;
+		return topology;
+	}
+
+	/// Count of NUMA nodes.
+	unsigned node_count() const
+		{ return (unsigned)_node_cpus.size(); }
+
+	/// CPUs of 'node'.
+	const std::vector< unsigned >& cpus( unsigned node ) const
+		{ return _node_cpus[ node ]; }
+
+	/// Node of 'cpu'.
+	unsigned node_of_cpu( unsigned cpu ) const
+		{ return cpu < _cpu_nodes.size() ? _cpu_nodes[ cpu ] : 0; }
+
+	/// Node, on which the calling thread runs now.
+	unsigned current_node() const
+	{
+#if defined( ML__ALGORITHM__Q_ARY_NUMA_ENABLED )
+		const int cpu = ::sched_getcpu();
+		if ( cpu >= 0 )
+			return node_of_cpu( (unsigned)cpu );
+#endif
+		return 0;
+	}
+
+	/// Runs 'job' on a thread, bound to the CPUs of 'node' (so the pages
+	/// it writes first are placed on that node), and waits for it.
+	template< typename JobT >
+	void run_on_node( unsigned node, JobT job ) const
+	{
+		std::thread thread( [this, node, &job]() {
+#if defined( ML__ALGORITHM__Q_ARY_NUMA_ENABLED )
+			if ( ! _node_cpus[ node ].empty() ) {
+				cpu_set_t cpu_set;
+				CPU_ZERO( &cpu_set );
+				for ( unsigned cpu : _node_cpus[ node ] )
+					if ( cpu < CPU_SETSIZE )
+						CPU_SET( cpu, &cpu_set );
+				::pthread_setaffinity_np( ::pthread_self(), sizeof(cpu_set), &cpu_set );
+			}
+#endif
+			job();
+		} );
+		thread.join();
+	}
+
+protected:
+	/// Parses list of CPUs, like "0-3,8-11".
+	static std::vector< unsigned > _parse_cpu_list( const std::string& list )
+	{
+		std::vector< unsigned > cpus;
+		std::istringstream input( list );
+		std::string range;
+		while ( std::getline( input, range, ',' ) ) {
+			if ( range.empty() )
+				continue;
+			const std::size_t dash = range.find( '-' );
+			const unsigned first = (unsigned)std::stoul( range.substr( 0, dash ) );
+			const unsigned last = dash == std::string::npos
+					? first
+					: (unsigned)std::stoul( range.substr( dash + 1 ) );
+			for ( unsigned cpu = first; cpu <= last; ++cpu )
+				cpus.push_back( cpu );
+		}
+		return cpus;
+	}
+};
+
+
+/// Replicas of a read-only index of type 'IndexT' (e.g.
+/// 'q_ary_eytzinger_index< T >', 'q_ary_static_tree< T >' or
+/// 'q_ary_key_column< T >'), one per NUMA node of the host, so that every
+/// search reads the memory of the node, on which it runs, and never
+/// crosses the interconnect.
+/// Every replica is built by a thread, bound to the CPUs of its node, so
+/// its pages are placed there by the first-touch policy of the kernel
+/// (with 'q_ary_huge_page_allocator' as the allocator of the index, they
+/// are also huge pages).
+/// Searches are dispatched to the replica of the node of the calling
+/// thread, which is looked up once every 'q_ary_numa_node_recheck_period'
+/// searches of the thread (threads rarely migrate between nodes, and the
+/// lookup costs about as much as a short search).
+/// On a host of one node there is one replica.
+template< typename IndexT >
+class q_ary_numa_replicas
+{
+public:
+	typedef IndexT index_type;
+	typedef typename IndexT::value_type value_type;
+	typedef std::size_t size_type;
+
+protected:
+	const q_ary_numa_topology* _topology;
+	std::vector< std::unique_ptr< IndexT > > _replicas;
+
+public:
+	explicit q_ary_numa_replicas(
+			const q_ary_numa_topology& topology = q_ary_numa_topology::host() )
+		: _topology( &topology )
+		{}
+
+	/// Builds the replicas by 'build( args... )' of the index.
+	template< typename... ArgsT >
+	explicit q_ary_numa_replicas( const ArgsT&... args )
+		: _topology( &q_ary_numa_topology::host() )
+		{ build( args... ); }
+
+	/// Rebuilds every replica on its node, by 'build( args... )' of the
+	/// index (e.g. 'begin, end' of a sorted range).
+	template< typename... ArgsT >
+	void build( const ArgsT&... args )
+	{
+		_replicas.clear();
+		for ( unsigned node = 0; node < _topology->node_count(); ++node ) {
+			std::unique_ptr< IndexT > replica;
+			_topology->run_on_node( node, [&]() {
+				replica.reset( new IndexT );
+				replica->build( args... );
+			} );
+			_replicas.push_back( std::move( replica ) );
+		}
+	}
+
+	/// Count of the replicas (of NUMA nodes).
+	unsigned replica_count() const
+		{ return (unsigned)_replicas.size(); }
+
+	/// Replica of 'node'.
+	const IndexT& replica( unsigned node ) const
+		{ return *_replicas[ node ]; }
+
+	/// Replica of the node, on which the calling thread runs.
+	const IndexT& local() const
+	{
+		if ( _replicas.size() == 1 )
+			return *_replicas.front();
+		thread_local unsigned node = 0, searches = 0;
+		if ( searches++ % q_ary_numa_node_recheck_period == 0 )
+			node = _topology->current_node();
+		return *_replicas[ node < _replicas.size() ? node : 0 ];
+	}
+
+	/// Length of the original array.
+	size_type size() const
+		{ return _replicas.empty() ? 0 : (size_type)_replicas.front()->size(); }
+
+	bool empty() const
+		{ return size() == 0; }
+
+	/// Searches the local replica.
+	template< typename PredT >
+	size_type search( const value_type& q, PredT pred ) const
+		{ return local().search( q, pred ); }
+
+	size_type lower_bound( const value_type& q ) const
+		{ return local().lower_bound( q ); }
+
+	size_type upper_bound( const value_type& q ) const
+		{ return local().upper_bound( q ); }
+
+	bool contains( const value_type& q ) const
+		{ return local().contains( q ); }
+
+	/// Returns the count of bytes, occupied by all the replicas.
+	size_type memory_footprint() const
+	{
+		size_type bytes = sizeof(*this) + _replicas.capacity() * sizeof(_replicas[ 0 ]);
+		for ( const std::unique_ptr< IndexT >& replica : _replicas )
+			bytes += replica->memory_footprint();
+		return bytes;
+	}
+};
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_NUMA_REPLICAS_HPP
@@ -0,0 +1,216 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_RANGE_SEARCH_HPP
+#define ML__ALGORITHM__Q_ARY_RANGE_SEARCH_HPP
+
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include "q_ary_search.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Counts the first 'sizeof...(Ks)' pivots of fragments of length
+/// 'fragment_length' from 'begin', which satisfy 'pred1(pivot, q1)', into
+/// 'count1', and the ones, which satisfy 'pred2(pivot, q2)', into 'count2'.
+/// Every pivot is loaded once, for both predicates, without any branching
+/// on their results.
+template< typename RanIt, typename LengthT, typename ValueT,
+		typename PredT1, typename PredT2, unsigned... Ks >
+inline void _q_ary_count_pivot_pairs(
+		RanIt begin, LengthT fragment_length,
+		const ValueT& q1, PredT1& pred1,
+		const ValueT& q2, PredT2& pred2,
+		length_t& count1, length_t& count2,
+		std::integer_sequence< unsigned, Ks... > )
+{
+	count1 = count2 = 0;
+	( ..., [&]( const auto& pivot ) {
+			count1 += (length_t)pred1( pivot, q1 );
+			count2 += (length_t)pred2( pivot, q2 );
+		}( *(begin + (Ks + 1) * fragment_length) ) );
+}
+
+/// One common Q-ary step of two searches in range {begin, length}, with
+/// lengths of type 'LengthT': both searches are advanced by the same
+/// evaluation of the pivots (see '_q_ary_count_pivot_pairs()').
+/// Returns 'false', and the ranges of both searches in {begin1, length1}
+/// and {begin2, length2}, if the searches dive into different fragments.
+template< unsigned Q,
+		typename RanIt, typename LengthT, typename ValueT,
+		typename PredT1, typename PredT2 >
+inline bool _q_ary_common_step(
+		RanIt& begin, LengthT& length,
+		RanIt& begin1, LengthT& length1,
+		RanIt& begin2, LengthT& length2,
+		const ValueT& q1, PredT1& pred1,
+		const ValueT& q2, PredT2& pred2 )
+{
+	const LengthT fragment_length = length / Q;
+	length_t count1, count2;
+	_q_ary_count_pivot_pairs( begin, fragment_length, q1, pred1, q2, pred2,
+			count1, count2, std::make_integer_sequence< unsigned, Q - 1 >() );
+	// The last fragment is longer than the others
+	const LengthT last_length = length - (Q - 1) * fragment_length;
+	begin1 = begin + count1 * fragment_length;
+	length1 = count1 == Q - 1 ? last_length : fragment_length;
+	begin2 = begin + count2 * fragment_length;
+	length2 = count2 == Q - 1 ? last_length : fragment_length;
+	if ( count1 != count2 )
+		return false;
+	begin = begin1;
+	length = length1;
+	return true;
+}
+
+/// Two Q-ary searches in range [begin, end), which go together while they
+/// dive into the same fragments (by common steps, which evaluate every
+/// pivot once for both), and continue on their own (by
+/// '_q_ary_search_range()', with 'StepT') from the step where they diverge.
+/// 'to_linear_threshold' must be at least 'Q'.
+template< unsigned Q, typename StepT,
+		typename RanIt, typename ValueT,
+		typename PredT1, typename PredT2 >
+inline std::pair< RanIt, RanIt > _q_ary_search_pair(
+		RanIt begin, RanIt end,
+		length_t to_linear_threshold,
+		const ValueT& q1, PredT1& pred1,
+		const ValueT& q2, PredT2& pred2 )
+{
+	static_assert( Q >= 2, "Q-ary search needs at least 2 fragments." );
+	assert( to_linear_threshold >= Q );
+	typedef q_ary_length_t< RanIt > wide_length_t;
+	// Work with {begin, length}, not with [begin, end)
+	wide_length_t wide_length = (wide_length_t)(end - begin);
+	if constexpr ( sizeof(wide_length_t) > sizeof(length_t) ) {
+		while ( wide_length > std::numeric_limits< length_t >::max() ) {
+			RanIt begin1 = begin, begin2 = begin;
+			wide_length_t length1, length2;
+			if ( ! _q_ary_common_step< Q >( begin, wide_length,
+					begin1, length1, begin2, length2, q1, pred1, q2, pred2 ) )
+				// Diverged
+				return { _q_ary_search_range< Q, StepT >( begin1, begin1 + length1,
+								to_linear_threshold, q1, pred1 ),
+						_q_ary_search_range< Q, StepT >( begin2, begin2 + length2,
+								to_linear_threshold, q2, pred2 ) };
+		}
+	}
+	length_t length = (length_t)wide_length;
+	// Common Q-ary steps
+	while ( length >= to_linear_threshold ) {
+		RanIt begin1 = begin, begin2 = begin;
+		length_t length1, length2;
+		if ( ! _q_ary_common_step< Q >( begin, length,
+				begin1, length1, begin2, length2, q1, pred1, q2, pred2 ) )
+			// Diverged
+			return { _q_ary_search< Q, StepT >( begin1, length1, to_linear_threshold, q1, pred1 ),
+					_q_ary_search< Q, StepT >( begin2, length2, to_linear_threshold, q2, pred2 ) };
+	}
+	// Linear search
+	return { StepT::finish( begin, length, q1, pred1 ),
+			StepT::finish( begin, length, q2, pred2 ) };
+}
+
+
+/// Two Q-ary searches of values 'q1' and 'q2', by predicates 'pred1' and
+/// 'pred2' respectively, in range [begin, end), which descend together
+/// while both results are in the same fragment, and split only where they
+/// diverge, so the common top of the descent is walked once.
+/// 'params' are the parameters of the search ('q_ary_static_parameters',
+/// or 'q_ary_runtime_parameters').
+/// Returns the pair of the first positions in the range, on which
+/// 'pred1(*it, q1)' and 'pred2(*it, q2)' respectively are not satisfied.
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename ValueT, typename PredT1, typename PredT2,
+		typename ParamsT >
+inline std::pair< RanIt, RanIt > q_ary_search_pair(
+		RanIt begin, RanIt end,
+		const ValueT& q1, PredT1 pred1,
+		const ValueT& q2, PredT2 pred2,
+		const ParamsT& params )
+{
+	return _q_ary_search_pair< Q, StepT >( begin, end,
+			params.to_linear_threshold(), q1, pred1, q2, pred2 );
+}
+
+/// Same as above, with the default parameters for 'StepT'
+/// (see 'q_ary_step_parameters').
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename ValueT, typename PredT1, typename PredT2 >
+inline std::pair< RanIt, RanIt > q_ary_search_pair(
+		RanIt begin, RanIt end,
+		const ValueT& q1, PredT1 pred1,
+		const ValueT& q2, PredT2 pred2 )
+{
+	typedef typename q_ary_step_parameters< Q, StepT, RanIt, ValueT, PredT1 >::type params_t;
+	return q_ary_search_pair< Q, StepT >( begin, end, q1, pred1, q2, pred2, params_t() );
+}
+
+
+/// Returns the range of values, equal to 'q', in sorted range [begin, end)
+/// (the same as 'std::equal_range()'), by one Q-ary descent down to the
+/// level where its lower and upper bounds diverge.
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename ValueT >
+inline std::pair< RanIt, RanIt > q_ary_equal_range(
+		RanIt begin, RanIt end,
+		const ValueT& q )
+	{ return q_ary_search_pair< Q, StepT >( begin, end,
+			q, std::less< ValueT >(), q, std::less_equal< ValueT >() ); }
+
+/// Same as above, for a range, sorted by projection 'proj' with "less"
+/// comparator 'comp' (see 'q_ary_projected_pred').
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename ValueT, typename CompT, typename ProjT >
+inline std::pair< RanIt, RanIt > q_ary_equal_range(
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		CompT comp,
+		ProjT proj )
+	{ return q_ary_search_pair< Q, StepT >( begin, end,
+			q, q_ary_projected_pred< CompT, ProjT >{ comp, proj },
+			q, q_ary_projected_pred< CompT, ProjT, true >{ comp, proj } ); }
+
+/// Returns the count of values 'v' in sorted range [begin, end), for which
+/// 'lo <= v < hi', by one Q-ary descent down to the level where the
+/// bounds diverge.
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename ValueT >
+inline typename std::iterator_traits< RanIt >::difference_type q_ary_range_count(
+		RanIt begin, RanIt end,
+		const ValueT& lo, const ValueT& hi )
+{
+	if ( ! (lo < hi) )
+		return 0;
+	const std::pair< RanIt, RanIt > bounds = q_ary_search_pair< Q, StepT >( begin, end,
+			lo, std::less< ValueT >(), hi, std::less< ValueT >() );
+	return bounds.second - bounds.first;
+}
+
+
+/// Same as above, for a range, sorted by projection 'proj' with "less"
+/// comparator 'comp' (see 'q_ary_projected_pred').
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename ValueT, typename CompT, typename ProjT >
+inline typename std::iterator_traits< RanIt >::difference_type q_ary_range_count(
+		RanIt begin, RanIt end,
+		const ValueT& lo, const ValueT& hi,
+		CompT comp,
+		ProjT proj )
+{
+	if ( ! comp( lo, hi ) )
+		return 0;
+	typedef q_ary_projected_pred< CompT, ProjT > pred_t;
+	const std::pair< RanIt, RanIt > bounds = q_ary_search_pair< Q, StepT >( begin, end,
+			lo, pred_t{ comp, proj }, hi, pred_t{ comp, proj } );
+	return bounds.second - bounds.first;
+}
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_RANGE_SEARCH_HPP
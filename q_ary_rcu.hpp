@@ -0,0 +1,206 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_RCU_HPP
+#define ML__ALGORITHM__Q_ARY_RCU_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ml {
+namespace algorithm {
+
+
+/// Default count of reader slots of 'q_ary_rcu_pointer' (the count of
+/// readers, which can hold snapshots at the same time, without spinning).
+constexpr unsigned q_ary_rcu_reader_slots = 128;
+
+
+template< typename T, unsigned Slots >
+class q_ary_rcu_pointer;
+
+/// Snapshot of the object of a 'q_ary_rcu_pointer', which stays valid
+/// (and unchanged) while the snapshot is held, however many newer objects
+/// are published meanwhile. It should be held briefly, as it holds back
+/// reclamation of all the objects, retired since it was taken.
+template< typename T, unsigned Slots = q_ary_rcu_reader_slots >
+class q_ary_rcu_snapshot
+{
+	friend class q_ary_rcu_pointer< T, Slots >;
+
+protected:
+	const q_ary_rcu_pointer< T, Slots >* _owner = nullptr;
+	unsigned _slot = 0;
+	const T* _object = nullptr;
+
+	q_ary_rcu_snapshot( const q_ary_rcu_pointer< T, Slots >* owner, unsigned slot, const T* object )
+		: _owner( owner ), _slot( slot ), _object( object )
+		{}
+
+public:
+	q_ary_rcu_snapshot( q_ary_rcu_snapshot&& other ) noexcept
+		: _owner( other._owner ), _slot( other._slot ), _object( other._object )
+		{ other._owner = nullptr; }
+
+	q_ary_rcu_snapshot& operator=( q_ary_rcu_snapshot&& other ) noexcept
+	{
+		if ( this != &other ) {
+			release();
+			_owner = other._owner;
+			_slot = other._slot;
+			_object = other._object;
+			other._owner = nullptr;
+		}
+		return *this;
+	}
+
+	~q_ary_rcu_snapshot()
+		{ release(); }
+
+	/// Leaves the snapshot, before it is destroyed.
+	void release()
+	{
+		if ( _owner != nullptr )
+			_owner->_leave( _slot );
+		_owner = nullptr;
+		_object = nullptr;
+	}
+
+	const T* get() const
+		{ return _object; }
+	const T& operator*() const
+		{ return *_object; }
+	const T* operator->() const
+		{ return _object; }
+	explicit operator bool() const
+		{ return _object != nullptr; }
+};
+
+
+/// Pointer to an immutable object of type 'T', which is replaced by
+/// publishing a new object (one atomic pointer swap), while readers keep
+/// using the old one (read-copy-update).
+/// Reclamation is epoch based: the pointer has a global epoch, which every
+/// publication advances, and 'Slots' reader slots, each on its own cache
+/// line. A reader takes a free slot (the one its thread used last time,
+/// normally), records the current epoch in it, and loads the object; on
+/// leaving, it frees the slot. A replaced object is retired with the epoch
+/// of its replacement, and deleted once no slot records an earlier epoch,
+/// as then every reader, which could have loaded it, has left.
+/// So readers take no lock and modify no shared cache line (a compare and
+/// swap on their own slot only), and never wait for writers, for which
+/// 'publish()' calls must be serialized by the caller.
+template< typename T, unsigned Slots = q_ary_rcu_reader_slots >
+class q_ary_rcu_pointer
+{
+	static_assert( Slots > 0, "RCU pointer needs at least one reader slot." );
+	friend class q_ary_rcu_snapshot< T, Slots >;
+
+public:
+	typedef q_ary_rcu_snapshot< T, Slots > snapshot_type;
+
+protected:
+	/// Epoch, recorded by a reader slot, which is free.
+	static constexpr std::uint64_t _idle = std::numeric_limits< std::uint64_t >::max();
+
+	struct alignas( 64 ) slot_t {
+		std::atomic< std::uint64_t > _epoch{ _idle };
+	};
+
+	std::atomic< const T* > _current{ nullptr };
+	std::atomic< std::uint64_t > _epoch{ 0 };
+	mutable slot_t _slots[ Slots ];
+	/// Replaced objects, and the epochs of their replacements.
+	std::vector< std::pair< std::uint64_t, const T* > > _retired;
+
+public:
+	q_ary_rcu_pointer() = default;
+
+	explicit q_ary_rcu_pointer( std::unique_ptr< const T > object )
+		{ _current.store( object.release() ); }
+
+	q_ary_rcu_pointer( const q_ary_rcu_pointer& ) = delete;
+	q_ary_rcu_pointer& operator=( const q_ary_rcu_pointer& ) = delete;
+
+	/// Deletes all the objects (there must be no snapshots left).
+	~q_ary_rcu_pointer()
+	{
+		delete _current.load();
+		for ( const std::pair< std::uint64_t, const T* >& retired : _retired )
+			delete retired.second;
+	}
+
+	/// Takes a snapshot of the current object.
+	snapshot_type snapshot() const
+	{
+		const unsigned slot = _enter();
+		return snapshot_type( this, slot, _current.load() );
+	}
+
+	/// The current object, for the writers only (which are serialized, so
+	/// it can't be reclaimed by another one).
+	const T* get() const
+		{ return _current.load(); }
+
+	/// Replaces the current object by 'object', and deletes the replaced
+	/// objects, which no reader can hold anymore.
+	void publish( std::unique_ptr< const T > object )
+	{
+		const T* const replaced = _current.exchange( object.release() );
+		const std::uint64_t epoch = _epoch.fetch_add( 1 ) + 1;
+		if ( replaced != nullptr )
+			_retired.emplace_back( epoch, replaced );
+		reclaim();
+	}
+
+	/// Deletes the replaced objects, which no reader can hold anymore.
+	/// Returns the count of the ones, which are still held.
+	std::size_t reclaim()
+	{
+		std::uint64_t oldest = _idle;
+		for ( const slot_t& slot : _slots ) {
+			const std::uint64_t epoch = slot._epoch.load();
+			oldest = epoch < oldest ? epoch : oldest;
+		}
+		std::size_t kept = 0;
+		for ( const std::pair< std::uint64_t, const T* >& retired : _retired ) {
+			if ( retired.first <= oldest )
+				delete retired.second;
+			else
+				_retired[ kept++ ] = retired;
+		}
+		_retired.resize( kept );
+		return kept;
+	}
+
+protected:
+	/// Takes a free reader slot, and records the current epoch in it.
+	unsigned _enter() const
+	{
+		// The slot of this thread, initially spread by thread ids
+		thread_local unsigned hint =
+				(unsigned)(std::hash< std::thread::id >()( std::this_thread::get_id() ) % Slots);
+		for ( unsigned slot = hint % Slots; ; slot = (slot + 1) % Slots ) {
+			std::uint64_t expected = _idle;
+			if ( _slots[ slot ]._epoch.load( std::memory_order_relaxed ) == _idle
+					&& _slots[ slot ]._epoch.compare_exchange_strong( expected, _epoch.load() ) ) {
+				hint = slot;
+				return slot;
+			}
+		}
+	}
+
+	void _leave( unsigned slot ) const
+		{ _slots[ slot ]._epoch.store( _idle, std::memory_order_release ); }
+};
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_RCU_HPP
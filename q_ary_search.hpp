@@ -2,365 +2,660 @@
 #ifndef ML__ALGORITHM__Q_ARY_SEARCH_HPP
 #define ML__ALGORITHM__Q_ARY_SEARCH_HPP
 
+#include <cstddef>
 #include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
 #include <cassert>
 
+#if defined( _MSC_VER ) && ! defined( __clang__ )
+#include <xmmintrin.h>
+#endif
+
+/// Inline namespace of the searches, their step policies and the SIMD
+/// kernels, whose code depends on the instruction set, they are compiled
+/// for. The build of the dispatched kernels (see
+/// "q_ary_search_dispatch.hpp") compiles them once per instruction set,
+/// each in a namespace of its own, so their inline functions never clash
+/// in one binary. Other code doesn't need to name it.
+#if ! defined( ML__ALGORITHM__Q_ARY_ISA_NAMESPACE )
+#define ML__ALGORITHM__Q_ARY_ISA_NAMESPACE isa_native
+#endif
+
 namespace ml {
 namespace algorithm {
+inline namespace ML__ALGORITHM__Q_ARY_ISA_NAMESPACE {
 
 
-/// How length of array (subarray) is represented.
+/// How length of array (subarray) is represented on the fast path.
+/// Ranges, which don't fit in it, are searched by lengths of the wider
+/// 'q_ary_length_t' type, until they do.
 typedef unsigned int length_t;
 
-
-/// Parameters used by '_2_ary_search' functions.
-struct _2_ary_search_parameters_t {
-	// Minimal length of the search range, below which we switch 
+/// How length of a range, given by iterators of type 'RanIt', is
+/// represented when it doesn't fit in 'length_t' (the unsigned variant
+/// of their 'difference_type').
+template< typename RanIt >
+using q_ary_length_t = typename std::make_unsigned<
+		typename std::iterator_traits< RanIt >::difference_type >::type;
+
+
+/// Parameters of Q-ary search, fixed at compile time, so the hot loop
+/// is specialized for them.
+/// Parameters are passed to 'q_ary_search()' as an object of a policy
+/// type, which provides:
+///  - 'to_linear_threshold()' - minimal length of the search range, below
+///        which we switch to linear search (not less than 'Q').
+template< length_t ToLinearThreshold >
+struct q_ary_static_parameters {
+	static constexpr length_t to_linear_threshold()
+		{ return ToLinearThreshold; }
+};
+
+/// Parameters, used by 'q_ary_search< Q >' functions by default.
+template< unsigned Q >
+using q_ary_default_parameters = q_ary_static_parameters< Q * 2 >;
+
+/// Parameters of Q-ary search, given at run time (e.g. when tuning).
+/// Every call gets its own copy, so changing them never affects
+/// searches on other threads.
+struct q_ary_runtime_parameters {
+	length_t _to_linear_threshold;
+
+	length_t to_linear_threshold() const
+		{ return _to_linear_threshold; }
+};
+
+
+/// Parameters used by 'q_ary_search< Q >' functions, in the legacy form.
+/// They are read-only: other parameters are passed to 'q_ary_search()'
+/// explicitly.
+template< unsigned Q >
+struct q_ary_search_parameters_t {
+	// Minimal length of the search range, below which we switch
 	// to linear search.
-	length_t _to_linear_threshold = 2*2;
-} _2_ary_search_parameters;
+	length_t _to_linear_threshold = q_ary_default_parameters< Q >::to_linear_threshold();
+
+	constexpr length_t to_linear_threshold() const
+		{ return _to_linear_threshold; }
+};
+
+/// Parameters of Q-ary search, one object per every value of 'Q'.
+template< unsigned Q >
+inline constexpr q_ary_search_parameters_t< Q > q_ary_search_parameters{};
+
+
+/// One probe of a Q-ary step: checks the pivot 'K' of the current range
+/// (the 'K'-th fragment border), and dives to the next pivot only if
+/// that one is satisfied.
+/// The chain of probes is unrolled at compile time, so for Q=4 it
+/// expands into exactly the same nested 'if' ladder as was written
+/// manually in '_4_ary_search'.
+template< unsigned K, unsigned Q, typename RanIt, typename LengthT, typename ValueT, typename PredT >
+inline void _q_ary_probe(
+		RanIt& begin, LengthT& length,
+		LengthT fragment_length,
+		const ValueT& q,
+		PredT& pred )
+{
+	if constexpr ( K < Q ) {
+		RanIt begin_k = begin + fragment_length;
+		if ( pred( *begin_k, q ) ) {
+			begin = begin_k;
+			_q_ary_probe< K + 1, Q >( begin, length, fragment_length, q, pred );
+		}
+		else
+			length = fragment_length;  // Dive into K-th fragment
+	}
+	else
+		length -= (Q - 1) * fragment_length;  // The last fragment
+}
 
+/// Counts how many of the pivots 'begin + K*fragment_length', for 'K' in
+/// 'Ks...', satisfy 'pred'.
+/// All the pivots are loaded independently of each other, without any
+/// branching on the results of the predicate.
+template< typename RanIt, typename LengthT, typename ValueT, typename PredT, unsigned... Ks >
+inline length_t _q_ary_count_pivots(
+		RanIt begin, LengthT fragment_length,
+		const ValueT& q,
+		PredT& pred,
+		std::integer_sequence< unsigned, Ks... > )
+{
+	return ( (length_t)0 + ... + 
+			(length_t)pred( *(begin + (Ks + 1) * fragment_length), q ) );
+}
 
-/// Q-ary search with partitioning into 2 fragments, on each step.
-/// At the end, linear search is being performed.
-/// Generally, this is almost the same as the binary search, 
-/// with the difference that at the end linear search is performed.
-/// Returns the first position 'it' in the range [begin, end), 
+
+/// Linear search, at the end of Q-ary search.
+/// Returns the first position 'it' in the range [begin, begin + length),
 /// on which 'pred(*it, q)' is not satisfied.
-template< typename RanIt, typename ValueT, typename PredT >
-inline RanIt _2_ary_search( 
-		RanIt begin, RanIt end, 
-		const ValueT& q, 
-		PredT pred )
+template< typename RanIt, typename LengthT, typename ValueT, typename PredT >
+inline RanIt _q_ary_linear_search(
+		RanIt begin, LengthT length,
+		const ValueT& q,
+		PredT& pred )
+{
+	RanIt end = begin + length;
+	while ( begin != end && pred( *begin, q ) )
+		++begin;
+	return begin;
+}
+
+
+/// Policy of a Q-ary step, which evaluates the pivots one by one, 
+/// by a chain of dependent branches, and stops at the first pivot 
+/// which is not satisfied.
+/// This is the default policy. It wins when queries are well predictable 
+/// (e.g. sorted ones), or when the predicate is expensive.
+struct q_ary_branchy_step {
+	template< unsigned Q, typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline void step(
+			RanIt& begin, LengthT& length,
+			LengthT fragment_length,
+			const ValueT& q,
+			PredT& pred )
+		{ _q_ary_probe< 1, Q >( begin, length, fragment_length, q, pred ); }
+
+	template< typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline RanIt finish(
+			RanIt begin, LengthT length,
+			const ValueT& q,
+			PredT& pred )
+		{ return _q_ary_linear_search( begin, length, q, pred ); }
+};
+
+/// Policy of a Q-ary step, which evaluates all the Q-1 pivots up front, 
+/// and advances 'begin' by the count of satisfied ones, without branching.
+/// Since the array is sorted, that count is exactly the index of the 
+/// fragment, into which we dive. 
+/// It wins on random queries, where the branchy policy mispredicts 
+/// about half of the time.
+struct q_ary_branchless_step {
+	template< unsigned Q, typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline void step(
+			RanIt& begin, LengthT& length,
+			LengthT fragment_length,
+			const ValueT& q,
+			PredT& pred )
+	{
+		const length_t count = _q_ary_count_pivots( 
+				begin, fragment_length, q, pred, 
+				std::make_integer_sequence< unsigned, Q - 1 >() );
+		begin += count * fragment_length;
+		// The last fragment is longer than the others
+		length = (count == Q - 1) 
+				? length - (Q - 1) * fragment_length 
+				: fragment_length;
+	}
+
+	/// Linear search, which also doesn't branch on the predicate: 
+	/// it counts all the satisfied values.
+	template< typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline RanIt finish(
+			RanIt begin, LengthT length,
+			const ValueT& q,
+			PredT& pred )
+	{
+		LengthT count = 0;
+		for ( LengthT i = 0; i < length; ++i )
+			count += (LengthT)pred( *(begin + i), q );
+		return begin + count;
+	}
+};
+
+
+/// Hints the processor to bring the cache line, containing 'p', into 
+/// cache, without waiting for it.
+inline void _q_ary_prefetch( const void* p )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+	__builtin_prefetch( p, 0, 3 );
+#elif defined( _MSC_VER )
+	_mm_prefetch( (const char*)p, _MM_HINT_T0 );
+#else
+	(void)p;
+#endif
+}
+
+/// Prefetches all the cache lines of 'bytes' bytes, starting from 'p'.
+inline void _q_ary_prefetch_range( const void* p, std::size_t bytes )
+{
+	const char* begin = (const char*)p;
+	for ( std::size_t offset = 0; offset < bytes; offset += 64 )
+		_q_ary_prefetch( begin + offset );
+}
+
+
+/// Policy of a Q-ary step, which wraps another policy 'StepT', and before
+/// every step prefetches the candidate pivots of the next 'Distance'
+/// steps, so that their loads overlap with the comparisons of the 
+/// current one.
+/// As it is not known yet into which fragment we dive, pivots of all
+/// of them are prefetched: those form a grid with 'fragment_length / Q^Distance'
+/// spacing, i.e. up to Q^(Distance+1) cache lines per step, so
+/// 'Distance' above 1 makes sense only for small Q.
+/// The same policy, passed to the index layouts ('q_ary_eytzinger_index',
+/// 'q_ary_static_tree'), makes them prefetch the nodes 'Distance' levels
+/// below the current one.
+/// This pays off once the array doesn't fit in cache, and memory 
+/// latency, not comparisons, dominates.
+template< typename StepT, unsigned Distance = 1 >
+struct q_ary_prefetching_step {
+	static constexpr unsigned prefetch_distance = Distance;
+
+	template< unsigned Q, typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline void step(
+			RanIt& begin, LengthT& length,
+			LengthT fragment_length,
+			const ValueT& q,
+			PredT& pred )
+	{
+		typedef decltype( *begin ) reference;
+		if constexpr ( std::is_lvalue_reference< reference >::value ) {
+			// Spacing of the grid, but not above one cache line
+			LengthT spacing = fragment_length;
+			for ( unsigned d = 0; d < Distance; ++d )
+				spacing /= Q;
+			const LengthT min_spacing = 
+					64 / sizeof(typename std::remove_reference< reference >::type);
+			if ( spacing < min_spacing )
+				spacing = min_spacing;
+			// Values wider than a cache line have no minimum, but the grid
+			// must still advance
+			if ( spacing == 0 )
+				spacing = 1;
+			for ( LengthT offset = spacing; offset < length; offset += spacing )
+				_q_ary_prefetch( std::addressof( *(begin + offset) ) );
+		}
+		StepT::template step< Q >( begin, length, fragment_length, q, pred );
+	}
+
+	template< typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline RanIt finish(
+			RanIt begin, LengthT length,
+			const ValueT& q,
+			PredT& pred )
+		{ return StepT::finish( begin, length, q, pred ); }
+};
+
+/// Prefetch distance (in steps), implied by step policy 'StepT'.
+template< typename StepT >
+struct q_ary_prefetch_distance {
+	static constexpr unsigned value = 0;
+};
+
+template< typename StepT, unsigned Distance >
+struct q_ary_prefetch_distance< q_ary_prefetching_step< StepT, Distance > > {
+	static constexpr unsigned value = Distance;
+};
+
+
+/// Parameters of 'q_ary_search< Q, StepT >()' over range of 'RanIt', by
+/// predicate 'PredT', when none are given: 'q_ary_default_parameters< Q >',
+/// unless step policy 'StepT' prefers other ones (e.g. a longer linear
+/// search, which it vectorizes).
+template< unsigned Q, typename StepT, 
+		typename RanIt, typename ValueT, typename PredT >
+struct q_ary_step_parameters {
+	typedef q_ary_default_parameters< Q > type;
+};
+
+template< unsigned Q, typename StepT, unsigned Distance, 
+		typename RanIt, typename ValueT, typename PredT >
+struct q_ary_step_parameters< Q, q_ary_prefetching_step< StepT, Distance >, RanIt, ValueT, PredT >
+	: q_ary_step_parameters< Q, StepT, RanIt, ValueT, PredT > {};
+
+
+/// Q-ary search of range {begin, length}, with lengths of type 'LengthT',
+/// which switches to linear search below 'to_linear_threshold' values
+/// (which must be at least 'Q').
+template< unsigned Q, typename StepT, 
+		typename RanIt, typename LengthT, typename ValueT, typename PredT >
+inline RanIt _q_ary_search(
+		RanIt begin, LengthT length,
+		length_t to_linear_threshold,
+		const ValueT& q,
+		PredT& pred )
 {
 	// Q-ary search
-	RanIt begin_1;
-	length_t fragment_length;
+	while ( length >= to_linear_threshold ) {
+		const LengthT fragment_length = length / Q;
+		StepT::template step< Q >( begin, length, fragment_length, q, pred );
+	}
+	// Linear search
+	return StepT::finish( begin, length, q, pred );
+}
+
+/// Same as 'q_ary_search()', but with the given 'to_linear_threshold'.
+/// Ranges longer than 'length_t' can represent are narrowed by steps on
+/// 'q_ary_length_t< RanIt >' lengths, down to a fitting one, so only
+/// their first few steps pay for the wider arithmetic.
+template< unsigned Q, typename StepT, 
+		typename RanIt, typename ValueT, typename PredT >
+inline RanIt _q_ary_search_range(
+		RanIt begin, RanIt end,
+		length_t to_linear_threshold,
+		const ValueT& q,
+		PredT& pred )
+{
+	static_assert( Q >= 2, "Q-ary search needs at least 2 fragments." );
+	assert( to_linear_threshold >= Q );
+	typedef q_ary_length_t< RanIt > wide_length_t;
 	// Work with {begin, length}, not with [begin, end)
-	length_t length = (length_t)(end - begin);
-	while ( length >= _2_ary_search_parameters._to_linear_threshold ) {
-		fragment_length = length / 2;
-		begin_1 = begin + fragment_length;
-		if ( pred( *begin_1, q ) ) {
-			begin = begin_1;
-			length -= fragment_length;  // The last fragment
-			continue;
+	wide_length_t length = (wide_length_t)(end - begin);
+	if constexpr ( sizeof(wide_length_t) > sizeof(length_t) ) {
+		while ( length > std::numeric_limits< length_t >::max() ) {
+			const wide_length_t fragment_length = length / Q;
+			StepT::template step< Q >( begin, length, fragment_length, q, pred );
 		}
-		length = fragment_length;  // Dive into 1/2-nd
 	}
-	// Linear search
-	end = begin + length;
-	while ( begin != end && pred( *begin, q ) )
-		++begin;
-	return begin;
+	return _q_ary_search< Q, StepT >( 
+			begin, (length_t)length, to_linear_threshold, q, pred );
+}
+
+/// Q-ary search with partitioning into 'Q' fragments, on each step.
+/// At the end, linear search is being performed.
+/// 'StepT' is the policy by which every step, as well as the final
+/// linear search, is evaluated ('q_ary_branchy_step', 
+/// 'q_ary_branchless_step', or 'q_ary_simd_step' from 
+/// "q_ary_search_simd.hpp"), possibly wrapped by 'q_ary_prefetching_step'.
+/// 'params' are the parameters of the search ('q_ary_static_parameters',
+/// or 'q_ary_runtime_parameters').
+/// Works on ranges of any length, which 'RanIt' can represent.
+/// Returns the first position 'it' in the range [begin, end),
+/// on which 'pred(*it, q)' is not satisfied.
+template< unsigned Q, typename StepT = q_ary_branchy_step, 
+		typename RanIt, typename ValueT, typename PredT, typename ParamsT >
+inline RanIt q_ary_search(
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		PredT pred,
+		const ParamsT& params )
+{
+	return _q_ary_search_range< Q, StepT >( begin, end, 
+			params.to_linear_threshold(), q, pred );
 }
 
+/// Same as above, with the default parameters for 'StepT'
+/// (see 'q_ary_step_parameters').
+template< unsigned Q, typename StepT = q_ary_branchy_step, 
+		typename RanIt, typename ValueT, typename PredT >
+inline RanIt q_ary_search(
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		PredT pred )
+{
+	typedef typename q_ary_step_parameters< Q, StepT, RanIt, ValueT, PredT >::type params_t;
+	return q_ary_search< Q, StepT >( begin, end, q, pred, params_t() );
+}
+
+/// Projection, which returns the value itself (as 'std::identity' of
+/// C++20 does).
+struct q_ary_identity {
+	template< typename T >
+	constexpr T&& operator()( T&& value ) const
+		{ return std::forward< T >( value ); }
+};
+
+/// Predicate of a search by projection 'proj' (as in the C++20 range
+/// algorithms), which compares 'proj(*it)' with the query by 'comp',
+/// where 'comp' is a "less" comparator: 'comp(proj(*it), q)' for the
+/// lower bound, or '! comp(q, proj(*it))' for the upper bound ('Upper').
+/// So ranges of records can be searched by a key data member (e.g.
+/// '&record_t::key') directly, without a copy of the key column, and
+/// without comparators, mixing records with keys.
+template< typename CompT, typename ProjT, bool Upper = false >
+struct q_ary_projected_pred {
+	CompT _comp;
+	ProjT _proj;
+
+	template< typename T, typename ValueT >
+	bool operator()( const T& value, const ValueT& q )
+		{ return Upper
+				? ! (bool)_comp( q, std::invoke( _proj, value ) )
+				: (bool)_comp( std::invoke( _proj, value ), q ); }
+};
+
+template< unsigned Q, typename StepT = q_ary_branchy_step, 
+		typename RanIt, typename ValueT >
+inline RanIt q_ary_lower_bound(
+		RanIt begin, RanIt end,
+		const ValueT& q )
+	{ return q_ary_search< Q, StepT >( begin, end, q, std::less< ValueT >() ); }
+
+template< unsigned Q, typename StepT = q_ary_branchy_step, 
+		typename RanIt, typename ValueT, typename ParamsT >
+inline RanIt q_ary_lower_bound(
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		const ParamsT& params )
+	{ return q_ary_search< Q, StepT >( begin, end, q, std::less< ValueT >(), params ); }
+
+template< unsigned Q, typename StepT = q_ary_branchy_step, 
+		typename RanIt, typename ValueT >
+inline RanIt q_ary_upper_bound(
+		RanIt begin, RanIt end,
+		const ValueT& q )
+	{ return q_ary_search< Q, StepT >( begin, end, q, std::less_equal< ValueT >() ); }
+
+template< unsigned Q, typename StepT = q_ary_branchy_step, 
+		typename RanIt, typename ValueT, typename ParamsT >
+inline RanIt q_ary_upper_bound(
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		const ParamsT& params )
+	{ return q_ary_search< Q, StepT >( begin, end, q, std::less_equal< ValueT >(), params ); }
+
+/// Returns the first position 'it' in the range [begin, end), for which
+/// 'comp(proj(*it), q)' is not satisfied.
+template< unsigned Q, typename StepT = q_ary_branchy_step, 
+		typename RanIt, typename ValueT, typename CompT, typename ProjT >
+inline RanIt q_ary_lower_bound(
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		CompT comp,
+		ProjT proj )
+	{ return q_ary_search< Q, StepT >( begin, end, q, 
+			q_ary_projected_pred< CompT, ProjT >{ comp, proj } ); }
+
+/// Returns the first position 'it' in the range [begin, end), for which
+/// 'comp(q, proj(*it))' is satisfied.
+template< unsigned Q, typename StepT = q_ary_branchy_step, 
+		typename RanIt, typename ValueT, typename CompT, typename ProjT >
+inline RanIt q_ary_upper_bound(
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		CompT comp,
+		ProjT proj )
+	{ return q_ary_search< Q, StepT >( begin, end, q, 
+			q_ary_projected_pred< CompT, ProjT, true >{ comp, proj } ); }
+
+template< unsigned Q, typename StepT = q_ary_branchy_step, 
+		typename RanIt, typename ValueT >
+inline bool q_ary_binary_search(
+		RanIt begin, RanIt end,
+		const ValueT& q )
+	{ RanIt result = q_ary_search< Q, StepT >( begin, end, q, std::less< ValueT >() );
+	  return result != end && ! (q < *result); }
+
+
+/// Parameters used by '_2_ary_search' functions.
+typedef q_ary_search_parameters_t< 2 > _2_ary_search_parameters_t;
+inline constexpr const _2_ary_search_parameters_t& _2_ary_search_parameters = q_ary_search_parameters< 2 >;
+
+/// Q-ary search with partitioning into 2 fragments, on each step.
+/// At the end, linear search is being performed.
+/// Generally, this is almost the same as the binary search,
+/// with the difference that at the end linear search is performed.
+/// Returns the first position 'it' in the range [begin, end),
+/// on which 'pred(*it, q)' is not satisfied.
+template< typename RanIt, typename ValueT, typename PredT >
+inline RanIt _2_ary_search(
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		PredT pred )
+	{ return q_ary_search< 2 >( begin, end, q, pred ); }
+
 template< typename RanIt, typename ValueT >
 inline RanIt _2_ary_lower_bound(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ return _2_ary_search( begin, end, q, std::less< ValueT >() ); }
+	{ return q_ary_lower_bound< 2 >( begin, end, q ); }
 
 template< typename RanIt, typename ValueT >
 inline RanIt _2_ary_upper_bound(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ return _2_ary_search( begin, end, q, std::less_equal< ValueT >() ); }
+	{ return q_ary_upper_bound< 2 >( begin, end, q ); }
 
 template< typename RanIt, typename ValueT >
 inline bool _2_ary_search(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ RanIt result = _2_ary_search( begin, end, q, std::less< ValueT >() );
-	  return result != end && ! (q < *result); }
+	{ return q_ary_binary_search< 2 >( begin, end, q ); }
 
 
 /// Parameters used by '_3_ary_search' functions.
-struct _3_ary_search_parameters_t {
-	// Minimal length of the search range, below which we switch 
-	// to linear search.
-	length_t _to_linear_threshold = 3*2;
-} _3_ary_search_parameters;
+typedef q_ary_search_parameters_t< 3 > _3_ary_search_parameters_t;
+inline constexpr const _3_ary_search_parameters_t& _3_ary_search_parameters = q_ary_search_parameters< 3 >;
 
 /// Q-ary search with partitioning into 3 fragments, on each step.
 /// At the end, linear search is being performed.
-/// Returns the first position 'it' in the range [begin, end), 
+/// Returns the first position 'it' in the range [begin, end),
 /// on which 'pred(*it, q)' is not satisfied.
 template< typename RanIt, typename ValueT, typename PredT >
 inline RanIt _3_ary_search(
 		RanIt begin, RanIt end,
-		const ValueT& q, 
+		const ValueT& q,
 		PredT pred )
-{
-	// Q-ary search
-	RanIt begin_1, begin_2;
-	length_t fragment_length;
-	// Work with {begin, length}, not with [begin, end)
-	length_t length = (length_t)(end - begin);
-	while ( length >= _3_ary_search_parameters._to_linear_threshold ) {
-		fragment_length = length / 3;
-		begin_1 = begin + fragment_length;
-		if ( pred( *begin_1, q ) ) {
-			begin_2 = begin_1 + fragment_length;
-			if ( pred( *begin_2, q ) ) {
-				begin = begin_2;
-				length -= 2 * fragment_length;  // The last fragment
-				continue;
-			}
-			else
-				begin = begin_1;
-		}
-		length = fragment_length;  // Dive into 1/3-rd
-	}
-	// Linear search
-	end = begin + length;
-	while ( begin != end && pred( *begin, q ) )
-		++begin;
-	return begin;
-}
+	{ return q_ary_search< 3 >( begin, end, q, pred ); }
 
 template< typename RanIt, typename ValueT >
 inline RanIt _3_ary_lower_bound(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ return _3_ary_search( begin, end, q, std::less< ValueT >() ); }
+	{ return q_ary_lower_bound< 3 >( begin, end, q ); }
 
 template< typename RanIt, typename ValueT >
 inline RanIt _3_ary_upper_bound(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ return _3_ary_search( begin, end, q, std::less_equal< ValueT >() ); }
+	{ return q_ary_upper_bound< 3 >( begin, end, q ); }
 
 template< typename RanIt, typename ValueT >
 inline bool _3_ary_search(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ RanIt result = _3_ary_search( begin, end, q, std::less< ValueT >() );
-	  return result != end && ! (q < *result); }
+	{ return q_ary_binary_search< 3 >( begin, end, q ); }
 
 
 /// Parameters used by '_4_ary_search' functions.
-struct _4_ary_search_parameters_t {
-	// Minimal length of the search range, below which we switch 
-	// to linear search.
-	length_t _to_linear_threshold = 4*2;
-} _4_ary_search_parameters;
+typedef q_ary_search_parameters_t< 4 > _4_ary_search_parameters_t;
+inline constexpr const _4_ary_search_parameters_t& _4_ary_search_parameters = q_ary_search_parameters< 4 >;
 
 /// Q-ary search with partitioning into 4 fragments, on each step.
 /// At the end, linear search is being performed.
-/// Returns the first position 'it' in the range [begin, end), 
+/// Returns the first position 'it' in the range [begin, end),
 /// on which 'pred(*it, q)' is not satisfied.
 template< typename RanIt, typename ValueT, typename PredT >
 inline RanIt _4_ary_search(
 		RanIt begin, RanIt end,
-		const ValueT& q, 
+		const ValueT& q,
 		PredT pred )
-{
-	// Q-ary search
-	RanIt begin_1, begin_2, begin_3;
-	length_t fragment_length;
-	// Work with {begin, length}, not with [begin, end)
-	length_t length = (length_t)(end - begin);
-	while ( length >= _4_ary_search_parameters._to_linear_threshold ) {
-		fragment_length = length / 4;
-		begin_1 = begin + fragment_length;
-		if ( pred( *begin_1, q ) ) {
-			begin_2 = begin_1 + fragment_length;
-			if ( pred( *begin_2, q ) ) {
-				begin_3 = begin_2 + fragment_length;
-				if ( pred( *begin_3, q ) ) {
-					begin = begin_3;
-					length -= 3 * fragment_length;  // The last fragment
-					continue;
-				}
-				else
-					begin = begin_2;
-			}
-			else
-				begin = begin_1;
-		}
-		length = fragment_length;  // Dive into 1/4-rd
-	}
-	// Linear search
-	end = begin + length;
-	while ( begin != end && pred( *begin, q ) )
-		++begin;
-	return begin;
-}
+	{ return q_ary_search< 4 >( begin, end, q, pred ); }
 
 template< typename RanIt, typename ValueT >
 inline RanIt _4_ary_lower_bound(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ return _4_ary_search( begin, end, q, std::less< ValueT >() ); }
+	{ return q_ary_lower_bound< 4 >( begin, end, q ); }
 
 template< typename RanIt, typename ValueT >
 inline RanIt _4_ary_upper_bound(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ return _4_ary_search( begin, end, q, std::less_equal< ValueT >() ); }
+	{ return q_ary_upper_bound< 4 >( begin, end, q ); }
 
 template< typename RanIt, typename ValueT >
 inline bool _4_ary_search(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ RanIt result = _4_ary_search( begin, end, q, std::less< ValueT >() );
-	  return result != end && ! (q < *result); }
+	{ return q_ary_binary_search< 4 >( begin, end, q ); }
 
 
 /// Parameters used by '_5_ary_search' functions.
-struct _5_ary_search_parameters_t {
-	// Minimal length of the search range, below which we switch 
-	// to linear search.
-	length_t _to_linear_threshold = 5*2;
-} _5_ary_search_parameters;
+typedef q_ary_search_parameters_t< 5 > _5_ary_search_parameters_t;
+inline constexpr const _5_ary_search_parameters_t& _5_ary_search_parameters = q_ary_search_parameters< 5 >;
 
 /// Q-ary search with partitioning into 5 fragments, on each step.
 /// At the end, linear search is being performed.
-/// Returns the first position 'it' in the range [begin, end), 
+/// Returns the first position 'it' in the range [begin, end),
 /// on which 'pred(*it, q)' is not satisfied.
 template< typename RanIt, typename ValueT, typename PredT >
-inline RanIt _5_ary_search( 
-		RanIt begin, RanIt end, 
-		const ValueT& q, 
+inline RanIt _5_ary_search(
+		RanIt begin, RanIt end,
+		const ValueT& q,
 		PredT pred )
-{
-	// Q-ary search
-	RanIt begin_1, begin_2, begin_3, begin_4;
-	length_t fragment_length;
-	// Work with {begin, length}, not with [begin, end)
-	length_t length = (length_t)(end - begin);
-	while ( length >= _5_ary_search_parameters._to_linear_threshold ) {  
-		fragment_length = length / 5;
-		begin_1 = begin + fragment_length;
-		if ( pred( *begin_1, q ) ) {
-			begin_2 = begin_1 + fragment_length;
-			if ( pred( *begin_2, q ) ) {
-				begin_3 = begin_2 + fragment_length;
-				if ( pred( *begin_3, q ) ) {
-					begin_4 = begin_3 + fragment_length;
-					if ( pred( *begin_4, q ) ) {
-						begin = begin_4;
-						length -= 4 * fragment_length;  // The last fragment
-						continue;
-					}
-					else
-						begin = begin_3;
-				}
-				else
-					begin = begin_2;
-			}
-			else
-				begin = begin_1;
-		}
-		length = fragment_length;  // Dive into 1/5-th
-	}
-	// Linear search
-	end = begin + length;
-	while ( begin != end && pred( *begin, q ) )
-		++begin;
-	return begin;
-}
+	{ return q_ary_search< 5 >( begin, end, q, pred ); }
 
 template< typename RanIt, typename ValueT >
 inline RanIt _5_ary_lower_bound(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ return _5_ary_search( begin, end, q, std::less< ValueT >() ); }
+	{ return q_ary_lower_bound< 5 >( begin, end, q ); }
 
 template< typename RanIt, typename ValueT >
 inline RanIt _5_ary_upper_bound(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ return _5_ary_search( begin, end, q, std::less_equal< ValueT >() ); }
+	{ return q_ary_upper_bound< 5 >( begin, end, q ); }
 
 template< typename RanIt, typename ValueT >
 inline bool _5_ary_search(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ RanIt result = _5_ary_search( begin, end, q, std::less< ValueT >() );
-	  return result != end && ! (q < *result); }
+	{ return q_ary_binary_search< 5 >( begin, end, q ); }
 
 
 /// Parameters used by '_6_ary_search' functions.
-struct _6_ary_search_parameters_t {
-	// Minimal length of the search range, below which we switch 
-	// to linear search.
-	length_t _to_linear_threshold = 6*2;
-} _6_ary_search_parameters;
+typedef q_ary_search_parameters_t< 6 > _6_ary_search_parameters_t;
+inline constexpr const _6_ary_search_parameters_t& _6_ary_search_parameters = q_ary_search_parameters< 6 >;
 
 /// Q-ary search with partitioning into 6 fragments, on each step.
 /// At the end, linear search is being performed.
-/// Returns the first position 'it' in the range [begin, end), 
+/// Returns the first position 'it' in the range [begin, end),
 /// on which 'pred(*it, q)' is not satisfied.
 template< typename RanIt, typename ValueT, typename PredT >
-inline RanIt _6_ary_search( 
-		RanIt begin, RanIt end, 
-		const ValueT& q, 
+inline RanIt _6_ary_search(
+		RanIt begin, RanIt end,
+		const ValueT& q,
 		PredT pred )
-{
-	// Q-ary search
-	RanIt begin_1, begin_2, begin_3, begin_4, begin_5;
-	length_t fragment_length;
-	// Work with {begin, length}, not with [begin, end)
-	length_t length = (length_t)(end - begin);
-	while ( length >= _6_ary_search_parameters._to_linear_threshold ) {
-		fragment_length = length / 6;
-		begin_1 = begin + fragment_length;
-		if ( pred( *begin_1, q ) ) {
-			begin_2 = begin_1 + fragment_length;
-			if ( pred( *begin_2, q ) ) {
-				begin_3 = begin_2 + fragment_length;
-				if ( pred( *begin_3, q ) ) {
-					begin_4 = begin_3 + fragment_length;
-					if ( pred( *begin_4, q ) ) {
-						begin_5 = begin_4 + fragment_length;
-						if ( pred( *begin_5, q ) ) {
-							begin = begin_5;
-							length -= 5 * fragment_length;  // The last fragment
-							continue;
-						}
-						else
-							begin = begin_4;
-					}
-					else
-						begin = begin_3;
-				}
-				else
-					begin = begin_2;
-			}
-			else
-				begin = begin_1;
-		}
-		length = fragment_length;  // Dive into 1/6-th
-	}
-	// Linear search
-	end = begin + length;
-	while ( begin != end && pred( *begin, q ) )
-		++begin;
-	return begin;
-}
+	{ return q_ary_search< 6 >( begin, end, q, pred ); }
 
 template< typename RanIt, typename ValueT >
 inline RanIt _6_ary_lower_bound(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ return _6_ary_search( begin, end, q, std::less< ValueT >() ); }
+	{ return q_ary_lower_bound< 6 >( begin, end, q ); }
 
 template< typename RanIt, typename ValueT >
 inline RanIt _6_ary_upper_bound(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ return _6_ary_search( begin, end, q, std::less_equal< ValueT >() ); }
+	{ return q_ary_upper_bound< 6 >( begin, end, q ); }
 
 template< typename RanIt, typename ValueT >
 inline bool _6_ary_search(
 		RanIt begin, RanIt end,
 		const ValueT& q )
-	{ RanIt result = _6_ary_search( begin, end, q, std::less< ValueT >() );
-	  return result != end && ! (q < *result); }
+	{ return q_ary_binary_search< 6 >( begin, end, q ); }
 
 
+} // inline namespace ML__ALGORITHM__Q_ARY_ISA_NAMESPACE
 } // namespace algorithm
 } // namespace ml
 
@@ -0,0 +1,230 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_SEARCH_BATCH_HPP
+#define ML__ALGORITHM__Q_ARY_SEARCH_BATCH_HPP
+
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include "q_ary_search.hpp"
+
+namespace ml {
+namespace algorithm {
+inline namespace ML__ALGORITHM__Q_ARY_ISA_NAMESPACE {
+
+
+/// Default count of queries, advanced in lockstep by the batch search.
+constexpr unsigned q_ary_batch_group_size = 16;
+
+
+/// Searches a group of 'G' queries (or less, if 'count < G') in lockstep:
+/// one Q-ary step for every query of the group, then the next step,
+/// and so on. After every step of a query, pivots of its next step are
+/// prefetched, so they arrive while the other queries are being advanced.
+/// All the queries run on the same sequence of range lengths: the range
+/// of every step is as long as the last (the longest) fragment of the previous
+/// one, which still contains the searched position, whichever fragment
+/// was chosen. So the number of steps doesn't depend on the query.
+/// Lengths are of type 'LengthT'. Switches to linear search below
+/// 'to_linear_threshold' values, as 'q_ary_search()' does.
+template< unsigned Q, typename StepT, unsigned G, typename LengthT,
+		typename RanIt, typename ValueT, typename OutIt, typename PredT >
+inline OutIt _q_ary_search_group(
+		RanIt begin, LengthT length,
+		length_t to_linear_threshold,
+		const ValueT* qs, unsigned count,
+		OutIt out,
+		PredT& pred )
+{
+	RanIt begins[ G ];
+	for ( unsigned j = 0; j < count; ++j )
+		begins[ j ] = begin;
+	// Q-ary search
+	while ( length >= to_linear_threshold ) {
+		const LengthT fragment_length = length / Q;
+		const LengthT next_length = length - (Q - 1) * fragment_length;
+		const LengthT next_fragment_length = next_length / Q;
+		for ( unsigned j = 0; j < count; ++j ) {
+			LengthT query_length = length;
+			StepT::template step< Q >(
+					begins[ j ], query_length, fragment_length, qs[ j ], pred );
+			// Pivots of the next step
+			if constexpr ( std::is_lvalue_reference< decltype( *begin ) >::value ) {
+				if ( next_length >= to_linear_threshold )
+					for ( unsigned k = 1; k < Q; ++k )
+						_q_ary_prefetch( std::addressof(
+								*(begins[ j ] + k * next_fragment_length) ) );
+			}
+		}
+		length = next_length;
+	}
+	// Linear search
+	for ( unsigned j = 0; j < count; ++j, ++out )
+		*out = StepT::finish( begins[ j ], length, qs[ j ], pred );
+	return out;
+}
+
+
+/// Q-ary search of a batch of queries [queries_begin, queries_end) in
+/// sorted range [begin, end).
+/// Queries are processed by groups of 'G', which are searched in lockstep,
+/// so memory latencies of independent searches overlap.
+/// Linear search starts at the same length as in 'q_ary_search()' with
+/// the default parameters of 'StepT' (see 'q_ary_step_parameters').
+/// For every query 'q', writes to 'out' the first position 'it' in the
+/// range [begin, end), on which 'pred(*it, q)' is not satisfied.
+/// Returns the end of the output.
+template< unsigned Q, typename StepT = q_ary_branchless_step,
+		unsigned G = q_ary_batch_group_size,
+		typename RanIt, typename QueryIt, typename OutIt, typename PredT >
+inline OutIt q_ary_search_batch(
+		RanIt begin, RanIt end,
+		QueryIt queries_begin, QueryIt queries_end,
+		OutIt out,
+		PredT pred )
+{
+	static_assert( G >= 1, "Group of queries can't be empty." );
+	typedef typename std::iterator_traits< QueryIt >::value_type query_t;
+	typedef q_ary_length_t< RanIt > wide_length_t;
+	typedef typename q_ary_step_parameters< Q, StepT, RanIt, query_t, PredT >::type params_t;
+	const length_t to_linear_threshold = params_t().to_linear_threshold();
+	const wide_length_t length = (wide_length_t)(end - begin);
+	query_t qs[ G ];
+	while ( queries_begin != queries_end ) {
+		unsigned count = 0;
+		for ( ; count < G && queries_begin != queries_end; ++count, ++queries_begin )
+			qs[ count ] = *queries_begin;
+		if ( length <= std::numeric_limits< length_t >::max() )
+			out = _q_ary_search_group< Q, StepT, G >(
+					begin, (length_t)length, to_linear_threshold, qs, count, out, pred );
+		else
+			out = _q_ary_search_group< Q, StepT, G >(
+					begin, length, to_linear_threshold, qs, count, out, pred );
+	}
+	return out;
+}
+
+template< unsigned Q, typename StepT = q_ary_branchless_step,
+		unsigned G = q_ary_batch_group_size,
+		typename RanIt, typename QueryIt, typename OutIt >
+inline OutIt q_ary_lower_bound_batch(
+		RanIt begin, RanIt end,
+		QueryIt queries_begin, QueryIt queries_end,
+		OutIt out )
+{
+	typedef typename std::iterator_traits< QueryIt >::value_type query_t;
+	return q_ary_search_batch< Q, StepT, G >( begin, end,
+			queries_begin, queries_end, out, std::less< query_t >() );
+}
+
+template< unsigned Q, typename StepT = q_ary_branchless_step,
+		unsigned G = q_ary_batch_group_size,
+		typename RanIt, typename QueryIt, typename OutIt >
+inline OutIt q_ary_upper_bound_batch(
+		RanIt begin, RanIt end,
+		QueryIt queries_begin, QueryIt queries_end,
+		OutIt out )
+{
+	typedef typename std::iterator_traits< QueryIt >::value_type query_t;
+	return q_ary_search_batch< Q, StepT, G >( begin, end,
+			queries_begin, queries_end, out, std::less_equal< query_t >() );
+}
+
+
+
+/// Batches, having at least 1 query per that many values of the 
+/// searched range, are searched by merge, rather than by galloping.
+constexpr unsigned q_ary_sorted_batch_merge_ratio = 8;
+
+
+/// Q-ary search of a sorted (by 'pred') batch of queries 
+/// [queries_begin, queries_end) in sorted range [begin, end).
+/// As the results are non-decreasing, every query starts from the result
+/// of the previous one: galloping (exponential) search, forward from it,
+/// finds a range of the result, and that range is then searched by 
+/// 'q_ary_search< Q, StepT >()'. So a query costs O(log d), where 'd'
+/// is the distance between its result and the previous one.
+/// If the batch is dense relative to the range, spanned by its results
+/// (has at least one query per 'q_ary_sorted_batch_merge_ratio' values of 
+/// it), it is merged with that range linearly instead.
+/// For every query 'q', writes to 'out' the first position 'it' in the
+/// range [begin, end), on which 'pred(*it, q)' is not satisfied.
+/// Returns the end of the output.
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename QueryIt, typename OutIt, typename PredT >
+inline OutIt q_ary_search_sorted_batch(
+		RanIt begin, RanIt end,
+		QueryIt queries_begin, QueryIt queries_end,
+		OutIt out,
+		PredT pred )
+{
+	if ( queries_begin == queries_end )
+		return out;
+	// Results of all the queries are in the range between the results
+	// of the first and of the last ones
+	const auto queries_count = std::distance( queries_begin, queries_end );
+	begin = q_ary_search< Q, StepT >( 
+			begin, end, *queries_begin, pred );
+	end = q_ary_search< Q, StepT >( 
+			begin, end, *std::next( queries_begin, queries_count - 1 ), pred );
+	if ( (std::size_t)queries_count * q_ary_sorted_batch_merge_ratio 
+			>= (std::size_t)(end - begin) ) {
+		// Merge
+		for ( ; queries_begin != queries_end; ++queries_begin, ++out ) {
+			while ( begin != end && pred( *begin, *queries_begin ) )
+				++begin;
+			*out = begin;
+		}
+		return out;
+	}
+	for ( ; queries_begin != queries_end; ++queries_begin, ++out ) {
+		const auto& q = *queries_begin;
+		// Galloping search: the result is in [begin + prev_bound, begin + bound]
+		const q_ary_length_t< RanIt > remaining = (q_ary_length_t< RanIt >)(end - begin);
+		q_ary_length_t< RanIt > prev_bound = 0, bound = 1;
+		while ( bound < remaining && pred( *(begin + (bound - 1)), q ) ) {
+			prev_bound = bound;
+			bound = (bound <= remaining / 2) ? bound * 2 : remaining;
+		}
+		if ( bound > remaining )
+			bound = remaining;
+		// Q-ary search
+		begin = q_ary_search< Q, StepT >( 
+				begin + prev_bound, begin + bound, q, pred );
+		*out = begin;
+	}
+	return out;
+}
+
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename QueryIt, typename OutIt >
+inline OutIt q_ary_lower_bound_sorted_batch(
+		RanIt begin, RanIt end,
+		QueryIt queries_begin, QueryIt queries_end,
+		OutIt out )
+{
+	typedef typename std::iterator_traits< QueryIt >::value_type query_t;
+	return q_ary_search_sorted_batch< Q, StepT >( begin, end,
+			queries_begin, queries_end, out, std::less< query_t >() );
+}
+
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename QueryIt, typename OutIt >
+inline OutIt q_ary_upper_bound_sorted_batch(
+		RanIt begin, RanIt end,
+		QueryIt queries_begin, QueryIt queries_end,
+		OutIt out )
+{
+	typedef typename std::iterator_traits< QueryIt >::value_type query_t;
+	return q_ary_search_sorted_batch< Q, StepT >( begin, end,
+			queries_begin, queries_end, out, std::less_equal< query_t >() );
+}
+
+
+} // inline namespace ML__ALGORITHM__Q_ARY_ISA_NAMESPACE
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_SEARCH_BATCH_HPP
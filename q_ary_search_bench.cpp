@@ -0,0 +1,666 @@
+
+/// Benchmark suite of the Q-ary search algorithms, on Google Benchmark.
+///
+/// Every benchmark is named "<type>/<variant>/<distribution>/<N>", and
+/// measures one search per iteration (so its time is in ns per query),
+/// over a sorted array of 'N' values of the type:
+///  - types: int32, int64, float, double, string, record (a 64-bit key
+///    with a payload, searched by projection to the key),
+///  - lengths: from L1-resident up to beyond the last level cache,
+///  - variants: 'std::lower_bound()', every Q with every step policy,
+///    the dispatched kernels (of the instruction set, reported in the
+///    context as 'q_ary_isa'), and every index layout of the library,
+///    which applies to the type,
+///  - distributions of queries: 'sequential' (increasing keys of the
+///    array), 'uniform' (random keys of the array), 'zipfian' (random
+///    keys of the array, with Zipf's law of exponent 1 over scattered
+///    ranks) and 'miss' (random values, which are not in the array).
+/// Besides the time, every benchmark reports the hardware events per query
+/// (cycles, instructions, branch misses, L1d / LLC / dTLB misses), which
+/// the host lets 'q_ary_perf_counters' count, and the flat Q-ary searches
+/// also report the average count of steps and the average length of the
+/// linear search per query (by a separate, untimed pass of the queries,
+/// by 'q_ary_counting_step').
+/// By default every benchmark is repeated 5 times, for at least 0.1 s
+/// each, and only the statistics of the repetitions (mean, median,
+/// standard deviation, coefficient of variation) are reported.
+/// The usual flags of Google Benchmark apply, e.g.:
+///    q_ary_search_bench --benchmark_filter='^int32/.*/uniform/'
+///            --benchmark_out=results.json --benchmark_out_format=json
+///    q_ary_search_bench --benchmark_format=csv > results.csv
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_search_simd.hpp"
+#include "q_ary_interpolation_search.hpp"
+#include "q_ary_eytzinger_index.hpp"
+#include "q_ary_static_tree.hpp"
+#include "q_ary_learned_index.hpp"
+#include "q_ary_key_column.hpp"
+#include "q_ary_compressed_blocks.hpp"
+#include "q_ary_string_index.hpp"
+#include "q_ary_instrumentation.hpp"
+#include "q_ary_search_dispatch.hpp"
+
+namespace {
+
+namespace alg = ml::algorithm;
+
+
+/// Count of the prepared queries of every benchmark (a power of 2).
+constexpr std::size_t query_count = std::size_t( 1 ) << 16;
+
+/// Distributions of the queries.
+enum class query_distribution { sequential, uniform, zipfian, miss };
+
+constexpr query_distribution distributions[] = {
+		query_distribution::sequential,
+		query_distribution::uniform,
+		query_distribution::zipfian,
+		query_distribution::miss };
+
+const char* distribution_name( query_distribution distribution )
+{
+	switch ( distribution ) {
+	case query_distribution::sequential: return "sequential";
+	case query_distribution::uniform: return "uniform";
+	case query_distribution::zipfian: return "zipfian";
+	default: return "miss";
+	}
+}
+
+
+/// Record, searched by projection to its key.
+struct bench_record {
+	std::int64_t _key;
+	std::int32_t _payload;
+};
+
+
+/// How the values of type 'T' are generated from strictly increasing even
+/// integers 'g' (so 'g + 1' is never a value), and which of the queries
+/// are misses.
+/// Also the name of the type, the lengths of arrays of it to sweep over,
+/// and the type of the queries.
+template< typename T >
+struct bench_type;
+
+template<>
+struct bench_type< std::int32_t > {
+	typedef std::int32_t query_type;
+	static constexpr const char* name = "int32";
+	static constexpr unsigned max_log_n = 24;
+	static std::int32_t make( std::int64_t g )
+		{ return (std::int32_t)g; }
+	static std::int32_t key( std::int32_t v )
+		{ return v; }
+	static std::int32_t miss( std::int32_t v, std::int32_t )
+		{ return v + 1; }
+};
+
+template<>
+struct bench_type< std::int64_t > {
+	typedef std::int64_t query_type;
+	static constexpr const char* name = "int64";
+	static constexpr unsigned max_log_n = 24;
+	// Timestamp-like: large, but close to each other
+	static std::int64_t make( std::int64_t g )
+		{ return (std::int64_t( 1 ) << 40) + g * 64; }
+	static std::int64_t key( std::int64_t v )
+		{ return v; }
+	static std::int64_t miss( std::int64_t v, std::int64_t )
+		{ return v + 1; }
+};
+
+template<>
+struct bench_type< float > {
+	typedef float query_type;
+	static constexpr const char* name = "float";
+	static constexpr unsigned max_log_n = 24;
+	static float make( std::int64_t g )
+		{ return (float)g * 0.25f; }
+	static float key( float v )
+		{ return v; }
+	// Between 'v' and the next value, if there is a float in between
+	static float miss( float v, float next )
+		{ const float q = std::nextafter( v, next );
+		  return q < next ? q : v; }
+};
+
+template<>
+struct bench_type< double > {
+	typedef double query_type;
+	static constexpr const char* name = "double";
+	static constexpr unsigned max_log_n = 24;
+	static double make( std::int64_t g )
+		{ return (double)g * 0.25; }
+	static double key( double v )
+		{ return v; }
+	static double miss( double v, double next )
+		{ const double q = std::nextafter( v, next );
+		  return q < next ? q : v; }
+};
+
+template<>
+struct bench_type< std::string > {
+	typedef std::string query_type;
+	static constexpr const char* name = "string";
+	static constexpr unsigned max_log_n = 20;
+	// Keys of a few short prefixes, like "ab/12345", sorted afterwards
+	static std::string make( std::int64_t g )
+	{
+		const std::uint64_t h = (std::uint64_t)g * 0x9E3779B97F4A7C15ull;
+		std::string s( 3, '/' );
+		s[ 0 ] = (char)('a' + (h >> 59) % 26);
+		s[ 1 ] = (char)('a' + (h >> 54) % 26);
+		return s + std::to_string( g );
+	}
+	static const std::string& key( const std::string& v )
+		{ return v; }
+	// As the keys have no zero bytes, it's between 'v' and the next one
+	static std::string miss( const std::string& v, const std::string& )
+		{ return v + '\0'; }
+};
+
+template<>
+struct bench_type< bench_record > {
+	typedef std::int64_t query_type;
+	static constexpr const char* name = "record";
+	static constexpr unsigned max_log_n = 22;
+	static bench_record make( std::int64_t g )
+		{ return { (std::int64_t( 1 ) << 40) + g * 64, (std::int32_t)g }; }
+	static std::int64_t key( const bench_record& v )
+		{ return v._key; }
+	static std::int64_t miss( const bench_record& v, const bench_record& )
+		{ return v._key + 1; }
+};
+
+
+/// Releases all the cached indexes (before the data they refer to
+/// changes).
+std::vector< std::function< void() > >& cache_releasers()
+{
+	static std::vector< std::function< void() > > releasers;
+	return releasers;
+}
+
+void release_caches()
+{
+	for ( const std::function< void() >& release : cache_releasers() )
+		release();
+}
+
+
+/// Sorted array of 'N' values of type 'T', and the queries of every
+/// distribution. Only the last one generated is kept.
+template< typename T >
+struct bench_data {
+	typedef bench_type< T > type_t;
+	typedef typename type_t::query_type query_type;
+
+	std::size_t _n = 0;
+	std::vector< T > _values;
+	std::vector< query_type > _queries[ 4 ];
+
+	const T* begin() const
+		{ return _values.data(); }
+	const T* end() const
+		{ return _values.data() + _values.size(); }
+
+	const std::vector< query_type >& queries( query_distribution distribution ) const
+		{ return _queries[ (int)distribution ]; }
+
+	static const bench_data& get( std::size_t n )
+	{
+		static bench_data data;
+		if ( data._n != n || data._values.empty() ) {
+			release_caches();
+			data._generate( n );
+		}
+		return data;
+	}
+
+protected:
+	void _generate( std::size_t n )
+	{
+		_n = n;
+		std::mt19937_64 gen( n );
+		std::uniform_int_distribution< std::int64_t > jitter( 0, 3 );
+		_values.resize( n );
+		for ( std::size_t i = 0; i < n; ++i )
+			_values[ i ] = type_t::make( 2 * ((std::int64_t)i * 4 + jitter( gen )) );
+		if constexpr ( std::is_same< T, std::string >::value )
+			std::sort( _values.begin(), _values.end() );
+		std::uniform_int_distribution< std::size_t > rank( 0, n - 1 );
+		// Zipf's law of exponent 1, by inversion of its continuous CDF,
+		// with ranks scattered by a multiplicative hash
+		std::uniform_real_distribution< double > unit( 0.0, 1.0 );
+		const double log_n = std::log( (double)n + 1.0 );
+		for ( std::vector< query_type >& queries : _queries )
+			queries.clear();
+		for ( std::size_t j = 0; j < query_count; ++j ) {
+			_queries[ (int)query_distribution::uniform ].push_back(
+					type_t::key( _values[ rank( gen ) ] ) );
+			const std::size_t zipf_rank = std::min( n - 1,
+					(std::size_t)(std::exp( unit( gen ) * log_n ) - 1.0) );
+			_queries[ (int)query_distribution::zipfian ].push_back(
+					type_t::key( _values[ (zipf_rank * 0x9E3779B1ull) % n ] ) );
+			const std::size_t miss_rank = rank( gen );
+			_queries[ (int)query_distribution::miss ].push_back( type_t::miss(
+					_values[ miss_rank ],
+					_values[ miss_rank + 1 < n ? miss_rank + 1 : miss_rank ] ) );
+		}
+		_queries[ (int)query_distribution::sequential ] =
+				_queries[ (int)query_distribution::uniform ];
+		std::sort( _queries[ (int)query_distribution::sequential ].begin(),
+				_queries[ (int)query_distribution::sequential ].end() );
+	}
+};
+
+
+/// Index of type 'IndexT', built over 'data' by 'IndexT( begin, end )'.
+/// Only the last one built is kept.
+template< typename IndexT, typename T >
+const IndexT& cached_index( const bench_data< T >& data )
+{
+	static std::unique_ptr< IndexT > index;
+	static std::size_t built_n = 0;
+	static bool registered = false;
+	if ( ! registered ) {
+		cache_releasers().push_back( []() { index.reset(); } );
+		registered = true;
+	}
+	if ( ! index || built_n != data._n ) {
+		index.reset();
+		index.reset( new IndexT( data.begin(), data.end() ) );
+		built_n = data._n;
+	}
+	return *index;
+}
+
+
+/// Checks if variant 'VariantT' can also make a counted search function,
+/// by 'prepare_counted( data )'.
+template< typename VariantT, typename = void >
+struct counted_variant : std::false_type {};
+
+template< typename VariantT >
+struct counted_variant< VariantT, decltype( (void)&VariantT::template prepare_counted< int > ) >
+	: std::true_type {};
+
+
+/// Runs searches by 'search( q )' (made by 'VariantT::prepare( data )'),
+/// cycling over the queries of 'distribution'.
+template< typename T, typename VariantT >
+void run_benchmark( benchmark::State& state, std::size_t n, query_distribution distribution )
+{
+	const bench_data< T >& data = bench_data< T >::get( n );
+	const auto search = VariantT::prepare( data );
+	const std::vector< typename bench_data< T >::query_type >& queries =
+			data.queries( distribution );
+	alg::q_ary_perf_counters counters;
+	std::size_t j = 0;
+	counters.start();
+	for ( auto _ : state ) {
+		benchmark::DoNotOptimize( search( queries[ j ] ) );
+		j = (j + 1) & (query_count - 1);
+	}
+	counters.stop();
+	state.SetItemsProcessed( state.iterations() );
+	state.counters[ "bytes" ] = (double)(n * sizeof(T));
+	for ( unsigned e = 0; e < alg::q_ary_perf_event_count; ++e ) {
+		const alg::q_ary_perf_event event = (alg::q_ary_perf_event)e;
+		if ( counters.available( event ) )
+			state.counters[ alg::q_ary_perf_event_name( event ) ] = benchmark::Counter(
+					(double)counters.count( event ) / (double)state.iterations() );
+	}
+	if constexpr ( counted_variant< VariantT >::value ) {
+		const auto counted_search = VariantT::prepare_counted( data );
+		alg::q_ary_search_stats& stats = alg::q_ary_search_stats::local();
+		stats.reset();
+		for ( const typename bench_data< T >::query_type& q : queries )
+			benchmark::DoNotOptimize( counted_search( q ) );
+		state.counters[ "steps" ] = stats.average_steps();
+		state.counters[ "tail_length" ] = stats.average_tail_length();
+	}
+}
+
+
+/// Variants of searches. Every one has a 'name' and makes the search
+/// function of 'data' by 'prepare( data )'.
+
+struct std_variant {
+	static std::string name()
+		{ return "std::lower_bound"; }
+	template< typename T >
+	static auto prepare( const bench_data< T >& data )
+	{
+		const T* const begin = data.begin();
+		const T* const end = data.end();
+		if constexpr ( std::is_same< T, bench_record >::value )
+			return [begin, end]( std::int64_t q ) {
+				return std::lower_bound( begin, end, q,
+						[]( const bench_record& r, std::int64_t x ) { return r._key < x; } )
+						- begin; };
+		else
+			return [begin, end]( const T& q ) { return std::lower_bound( begin, end, q ) - begin; };
+	}
+};
+
+template< typename StepT >
+const char* step_name()
+{
+	if constexpr ( std::is_same< StepT, alg::q_ary_branchy_step >::value )
+		return "branchy";
+	else if constexpr ( std::is_same< StepT, alg::q_ary_branchless_step >::value )
+		return "branchless";
+	else if constexpr ( std::is_same< StepT, alg::q_ary_simd_step >::value )
+		return "simd";
+	else if constexpr ( std::is_same< StepT, alg::q_ary_simd_tail_step<> >::value )
+		return "simd_tail";
+	else
+		return "prefetching";
+}
+
+template< unsigned Q, typename StepT >
+struct q_ary_variant {
+	static std::string name()
+		{ return "q_ary<" + std::to_string( Q ) + "," + step_name< StepT >() + ">"; }
+	template< typename T >
+	static auto prepare( const bench_data< T >& data )
+		{ return _prepare< StepT >( data ); }
+	template< typename T >
+	static auto prepare_counted( const bench_data< T >& data )
+		{ return _prepare< alg::q_ary_counting_step< StepT > >( data ); }
+
+	/// Search by step policy 'S'.
+	template< typename S, typename T >
+	static auto _prepare( const bench_data< T >& data )
+	{
+		const T* const begin = data.begin();
+		const T* const end = data.end();
+		if constexpr ( std::is_same< T, bench_record >::value )
+			return [begin, end]( std::int64_t q ) {
+				return alg::q_ary_lower_bound< Q, S >( begin, end, q,
+						std::less< std::int64_t >(), &bench_record::_key ) - begin; };
+		else
+			return [begin, end]( const T& q ) {
+				return alg::q_ary_lower_bound< Q, S >( begin, end, q ) - begin; };
+	}
+};
+
+template< unsigned Q >
+struct interpolation_variant {
+	static std::string name()
+		{ return "q_ary_interpolation<" + std::to_string( Q ) + ">"; }
+	template< typename T >
+	static auto prepare( const bench_data< T >& data )
+	{
+		const T* const begin = data.begin();
+		const T* const end = data.end();
+		return [begin, end]( const T& q ) {
+			return alg::q_ary_interpolation_lower_bound< Q >( begin, end, q ) - begin; };
+	}
+};
+
+/// Kernels of 'q_ary_best_search_kernels()' (of arithmetic types only).
+struct dispatched_variant {
+	static std::string name()
+		{ return "dispatched"; }
+	template< typename T >
+	static auto prepare( const bench_data< T >& data )
+	{
+		const T* const begin = data.begin();
+		const T* const end = data.end();
+		return [begin, end]( const T& q ) {
+			return alg::q_ary_dispatched_lower_bound( begin, end, q ) - begin; };
+	}
+};
+
+/// Prebuilt index of type 'IndexT< T >' (or of its key type, for records).
+template< template< typename > class IndexT >
+struct index_variant {
+	static std::string name()
+		{ return IndexT< int >::name(); }
+	template< typename T >
+	static auto prepare( const bench_data< T >& data )
+	{
+		typedef typename IndexT< typename bench_type< T >::query_type >::type index_t;
+		const index_t* const index = &cached_index< index_t >( data );
+		return [index]( const typename bench_type< T >::query_type& q ) {
+			return index->lower_bound( q ); };
+	}
+};
+
+template< typename K >
+struct eytzinger_index {
+	typedef alg::q_ary_eytzinger_index< K > type;
+	static std::string name() { return "eytzinger"; }
+};
+template< typename K >
+struct eytzinger_simd_index {
+	typedef alg::q_ary_eytzinger_index< K, alg::q_ary_cache_line_fan_out< K >(),
+			alg::q_ary_simd_step > type;
+	static std::string name() { return "eytzinger<simd>"; }
+};
+template< typename K >
+struct eytzinger_prefetching_index {
+	typedef alg::q_ary_eytzinger_index< K, alg::q_ary_cache_line_fan_out< K >(),
+			alg::q_ary_prefetching_step< alg::q_ary_branchless_step > > type;
+	static std::string name() { return "eytzinger<prefetching>"; }
+};
+template< typename K >
+struct static_tree_index {
+	typedef alg::q_ary_static_tree< K > type;
+	static std::string name() { return "static_tree"; }
+};
+template< typename K >
+struct static_tree_prefetching_index {
+	typedef alg::q_ary_static_tree< K, alg::q_ary_static_tree_fan_out< K >(),
+			alg::q_ary_prefetching_step< alg::q_ary_simd_step > > type;
+	static std::string name() { return "static_tree<prefetching>"; }
+};
+template< typename K >
+struct learned_index {
+	typedef alg::q_ary_learned_index< K > type;
+	static std::string name() { return "learned_index"; }
+};
+template< typename K >
+struct compressed_16_index {
+	typedef alg::q_ary_compressed_blocks< K, std::int16_t > type;
+	static std::string name() { return "compressed_blocks<int16>"; }
+};
+template< typename K >
+struct compressed_32_index {
+	typedef alg::q_ary_compressed_blocks< K, std::int32_t > type;
+	static std::string name() { return "compressed_blocks<int32>"; }
+};
+template< typename K >
+struct string_index {
+	typedef alg::q_ary_string_index<> type;
+	static std::string name() { return "string_index"; }
+};
+template< typename K >
+struct string_simd_index {
+	typedef alg::q_ary_string_index< 16, alg::q_ary_simd_step > type;
+	static std::string name() { return "string_index<16,simd>"; }
+};
+
+/// Key column of records, searched plainly or by an index.
+template< typename IndexT, const char* Name >
+struct key_column_variant {
+	static std::string name()
+		{ return Name; }
+	static auto prepare( const bench_data< bench_record >& data )
+	{
+		typedef alg::q_ary_key_column< std::int64_t, 8, alg::q_ary_branchless_step,
+				IndexT > column_t;
+		static std::unique_ptr< column_t > column;
+		static std::size_t built_n = 0;
+		static bool registered = false;
+		if ( ! registered ) {
+			cache_releasers().push_back( []() { column.reset(); } );
+			registered = true;
+		}
+		if ( ! column || built_n != data._n ) {
+			column.reset( new column_t( data.begin(), data.end(), &bench_record::_key ) );
+			built_n = data._n;
+		}
+		const column_t* const c = column.get();
+		return [c]( std::int64_t q ) { return c->lower_bound( q ); };
+	}
+};
+
+constexpr char key_column_name[] = "key_column";
+constexpr char key_column_eytzinger_name[] = "key_column<eytzinger>";
+constexpr char key_column_static_tree_name[] = "key_column<static_tree>";
+
+
+/// Registers benchmarks of 'VariantT' on type 'T', for every length and
+/// every distribution.
+template< typename T, typename VariantT >
+void register_variant( bool repeat, bool set_min_time )
+{
+	for ( unsigned log_n = 10; log_n <= bench_type< T >::max_log_n; log_n += 2 ) {
+		const std::size_t n = std::size_t( 1 ) << log_n;
+		for ( query_distribution distribution : distributions ) {
+			const std::string name = std::string( bench_type< T >::name ) + "/"
+					+ VariantT::name() + "/" + distribution_name( distribution )
+					+ "/" + std::to_string( n );
+			benchmark::internal::Benchmark* const b = benchmark::RegisterBenchmark(
+					name.c_str(),
+					[n, distribution]( benchmark::State& state ) {
+						run_benchmark< T, VariantT >( state, n, distribution ); } );
+			if ( repeat )
+				b->Repetitions( 5 )->ReportAggregatesOnly( true );
+			if ( set_min_time )
+				b->MinTime( 0.1 );
+		}
+	}
+}
+
+template< typename T, typename... VariantTs >
+void register_variants( bool repeat, bool set_min_time )
+	{ (register_variant< T, VariantTs >( repeat, set_min_time ), ...); }
+
+
+/// Registers all the variants, which apply to arithmetic type 'T'.
+template< typename T >
+void register_arithmetic( bool repeat, bool set_min_time )
+{
+	register_variants< T,
+			std_variant,
+			q_ary_variant< 2, alg::q_ary_branchy_step >,
+			q_ary_variant< 3, alg::q_ary_branchy_step >,
+			q_ary_variant< 4, alg::q_ary_branchy_step >,
+			q_ary_variant< 5, alg::q_ary_branchy_step >,
+			q_ary_variant< 6, alg::q_ary_branchy_step >,
+			q_ary_variant< 8, alg::q_ary_branchy_step >,
+			q_ary_variant< 16, alg::q_ary_branchy_step >,
+			q_ary_variant< 2, alg::q_ary_branchless_step >,
+			q_ary_variant< 3, alg::q_ary_branchless_step >,
+			q_ary_variant< 4, alg::q_ary_branchless_step >,
+			q_ary_variant< 5, alg::q_ary_branchless_step >,
+			q_ary_variant< 6, alg::q_ary_branchless_step >,
+			q_ary_variant< 8, alg::q_ary_branchless_step >,
+			q_ary_variant< 16, alg::q_ary_branchless_step >,
+			q_ary_variant< 4, alg::q_ary_simd_step >,
+			q_ary_variant< 8, alg::q_ary_simd_step >,
+			q_ary_variant< 16, alg::q_ary_simd_step >,
+			q_ary_variant< 32, alg::q_ary_simd_step >,
+			q_ary_variant< 4, alg::q_ary_simd_tail_step<> >,
+			q_ary_variant< 8, alg::q_ary_simd_tail_step<> >,
+			dispatched_variant,
+			interpolation_variant< 4 >,
+			interpolation_variant< 8 >,
+			index_variant< eytzinger_index >,
+			index_variant< eytzinger_simd_index >,
+			index_variant< eytzinger_prefetching_index >,
+			index_variant< static_tree_index >,
+			index_variant< static_tree_prefetching_index >,
+			index_variant< learned_index > >( repeat, set_min_time );
+	if constexpr ( std::is_integral< T >::value )
+		register_variants< T,
+				index_variant< compressed_16_index >,
+				index_variant< compressed_32_index > >( repeat, set_min_time );
+}
+
+/// Registers all the variants, which apply to strings.
+void register_strings( bool repeat, bool set_min_time )
+{
+	register_variants< std::string,
+			std_variant,
+			q_ary_variant< 2, alg::q_ary_branchy_step >,
+			q_ary_variant< 4, alg::q_ary_branchy_step >,
+			q_ary_variant< 8, alg::q_ary_branchy_step >,
+			q_ary_variant< 16, alg::q_ary_branchy_step >,
+			q_ary_variant< 4, alg::q_ary_branchless_step >,
+			q_ary_variant< 8, alg::q_ary_branchless_step >,
+			index_variant< string_index >,
+			index_variant< string_simd_index > >( repeat, set_min_time );
+}
+
+/// Registers all the variants, which apply to records.
+void register_records( bool repeat, bool set_min_time )
+{
+	register_variants< bench_record,
+			std_variant,
+			q_ary_variant< 2, alg::q_ary_branchy_step >,
+			q_ary_variant< 4, alg::q_ary_branchy_step >,
+			q_ary_variant< 8, alg::q_ary_branchy_step >,
+			q_ary_variant< 4, alg::q_ary_branchless_step >,
+			q_ary_variant< 8, alg::q_ary_branchless_step >,
+			q_ary_variant< 16, alg::q_ary_branchless_step >,
+			q_ary_variant< 8, alg::q_ary_simd_step >,
+			q_ary_variant< 16, alg::q_ary_simd_step >,
+			key_column_variant< void, key_column_name >,
+			key_column_variant< alg::q_ary_eytzinger_index< std::int64_t >,
+					key_column_eytzinger_name >,
+			key_column_variant< alg::q_ary_static_tree< std::int64_t >,
+					key_column_static_tree_name > >( repeat, set_min_time );
+}
+
+/// Checks if flag 'flag' of Google Benchmark is given on command line.
+bool flag_given( int argc, char** argv, const char* flag )
+{
+	for ( int i = 1; i < argc; ++i )
+		if ( std::strncmp( argv[ i ], flag, std::strlen( flag ) ) == 0 )
+			return true;
+	return false;
+}
+
+} // namespace
+
+
+int main( int argc, char** argv )
+{
+	// Defaults of the suite, unless given on command line
+	const bool repeat = ! flag_given( argc, argv, "--benchmark_repetitions" );
+	const bool set_min_time = ! flag_given( argc, argv, "--benchmark_min_time" );
+	benchmark::Initialize( &argc, argv );
+	if ( benchmark::ReportUnrecognizedArguments( argc, argv ) )
+		return 1;
+	benchmark::AddCustomContext( "q_ary_isa",
+			alg::q_ary_isa_name( alg::q_ary_best_search_kernels()._isa ) );
+	register_arithmetic< std::int32_t >( repeat, set_min_time );
+	register_arithmetic< std::int64_t >( repeat, set_min_time );
+	register_arithmetic< float >( repeat, set_min_time );
+	register_arithmetic< double >( repeat, set_min_time );
+	register_strings( repeat, set_min_time );
+	register_records( repeat, set_min_time );
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
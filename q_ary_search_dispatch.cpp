@@ -0,0 +1,127 @@
+
+/// Dispatcher of the search kernels (see "q_ary_search_dispatch.hpp"):
+/// picks the kernels of the widest instruction set, which are built in
+/// (as 'ML__ALGORITHM__Q_ARY_KERNELS_HAVE_<ISA>' tells), and which the
+/// processor supports, by CPUID (on x86-64, by '__builtin_cpu_supports()'
+/// of GCC and Clang).
+
+#include "q_ary_search_dispatch.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace ml {
+namespace algorithm {
+
+#if defined( ML__ALGORITHM__Q_ARY_KERNELS_HAVE_GENERIC )
+extern const q_ary_search_kernels _q_ary_search_kernels_generic;
+#endif
+#if defined( ML__ALGORITHM__Q_ARY_KERNELS_HAVE_SSE4_2 )
+extern const q_ary_search_kernels _q_ary_search_kernels_sse4_2;
+#endif
+#if defined( ML__ALGORITHM__Q_ARY_KERNELS_HAVE_AVX2 )
+extern const q_ary_search_kernels _q_ary_search_kernels_avx2;
+#endif
+#if defined( ML__ALGORITHM__Q_ARY_KERNELS_HAVE_AVX512 )
+extern const q_ary_search_kernels _q_ary_search_kernels_avx512;
+#endif
+#if defined( ML__ALGORITHM__Q_ARY_KERNELS_HAVE_NEON )
+extern const q_ary_search_kernels _q_ary_search_kernels_neon;
+#endif
+
+
+const char* q_ary_isa_name( q_ary_isa isa )
+{
+	static const char* const names[ q_ary_isa_count ] = {
+			"generic", "sse4.2", "avx2", "avx512", "neon" };
+	return names[ (unsigned)isa ];
+}
+
+
+bool q_ary_isa_supported( q_ary_isa isa )
+{
+	switch ( isa ) {
+	case q_ary_isa::generic:
+		return true;
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && defined( __x86_64__ )
+	case q_ary_isa::sse4_2:
+		return __builtin_cpu_supports( "sse4.2" ) && __builtin_cpu_supports( "popcnt" );
+	case q_ary_isa::avx2:
+		return q_ary_isa_supported( q_ary_isa::sse4_2 )
+				&& __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" )
+				&& __builtin_cpu_supports( "bmi" ) && __builtin_cpu_supports( "bmi2" );
+	case q_ary_isa::avx512:
+		return q_ary_isa_supported( q_ary_isa::avx2 )
+				&& __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" )
+				&& __builtin_cpu_supports( "avx512dq" ) && __builtin_cpu_supports( "avx512vl" );
+#endif
+#if defined( __aarch64__ )
+	case q_ary_isa::neon:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+
+const q_ary_search_kernels* q_ary_search_kernels_of( q_ary_isa isa )
+{
+	if ( ! q_ary_isa_supported( isa ) )
+		return nullptr;
+	switch ( isa ) {
+#if defined( ML__ALGORITHM__Q_ARY_KERNELS_HAVE_GENERIC )
+	case q_ary_isa::generic:
+		return &_q_ary_search_kernels_generic;
+#endif
+#if defined( ML__ALGORITHM__Q_ARY_KERNELS_HAVE_SSE4_2 )
+	case q_ary_isa::sse4_2:
+		return &_q_ary_search_kernels_sse4_2;
+#endif
+#if defined( ML__ALGORITHM__Q_ARY_KERNELS_HAVE_AVX2 )
+	case q_ary_isa::avx2:
+		return &_q_ary_search_kernels_avx2;
+#endif
+#if defined( ML__ALGORITHM__Q_ARY_KERNELS_HAVE_AVX512 )
+	case q_ary_isa::avx512:
+		return &_q_ary_search_kernels_avx512;
+#endif
+#if defined( ML__ALGORITHM__Q_ARY_KERNELS_HAVE_NEON )
+	case q_ary_isa::neon:
+		return &_q_ary_search_kernels_neon;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+
+/// Picks the kernels for 'q_ary_best_search_kernels()'.
+static const q_ary_search_kernels& _q_ary_pick_search_kernels()
+{
+	// Named by the environment
+	if ( const char* name = std::getenv( "Q_ARY_SEARCH_ISA" ) )
+		for ( unsigned i = 0; i < q_ary_isa_count; ++i )
+			if ( std::strcmp( name, q_ary_isa_name( (q_ary_isa)i ) ) == 0 )
+				if ( const q_ary_search_kernels* kernels = q_ary_search_kernels_of( (q_ary_isa)i ) )
+					return *kernels;
+	// The widest one (the baseline one is always built in)
+	for ( unsigned i = q_ary_isa_count; i-- > 0; )
+		if ( const q_ary_search_kernels* kernels = q_ary_search_kernels_of( (q_ary_isa)i ) )
+			return *kernels;
+	std::abort();
+}
+
+const q_ary_search_kernels& q_ary_best_search_kernels()
+{
+	static const q_ary_search_kernels& kernels = _q_ary_pick_search_kernels();
+	return kernels;
+}
+
+/// Picks the kernels when the program is loaded (rather than on the first
+/// search), so the searches never wait for it.
+static const q_ary_search_kernels& _q_ary_search_kernels_at_load = q_ary_best_search_kernels();
+
+
+} // namespace algorithm
+} // namespace ml
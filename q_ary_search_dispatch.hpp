@@ -0,0 +1,129 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_SEARCH_DISPATCH_HPP
+#define ML__ALGORITHM__Q_ARY_SEARCH_DISPATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ml {
+namespace algorithm {
+
+
+/// Instruction sets, which the dispatched search kernels are built for:
+///  - 'generic' - the baseline of the target architecture (e.g. SSE2 on
+///        x86-64),
+///  - 'sse4_2', 'avx2' (with FMA and BMI2), 'avx512' (F, BW, DQ, VL) - of
+///        x86-64,
+///  - 'neon' - of AArch64 (its baseline).
+enum class q_ary_isa : unsigned {
+	generic,
+	sse4_2,
+	avx2,
+	avx512,
+	neon
+};
+
+constexpr unsigned q_ary_isa_count = 5;
+
+/// Name of 'isa' (e.g. "avx2"), as 'Q_ARY_SEARCH_ISA' environment
+/// variable gives it.
+const char* q_ary_isa_name( q_ary_isa isa );
+
+/// Checks if the processor (and the operating system) supports 'isa'.
+bool q_ary_isa_supported( q_ary_isa isa );
+
+
+/// Q of the dispatched kernels.
+constexpr unsigned q_ary_dispatched_q = 8;
+
+/// Dispatched kernels of values of type 'T': the lower and the upper
+/// bound in sorted range [begin, end), and the same for a batch of
+/// queries [queries_begin, queries_end), by 'q_ary_search< 8,
+/// q_ary_simd_step >()' and 'q_ary_search_batch< 8, q_ary_simd_step >()'.
+template< typename T >
+struct q_ary_search_kernel_set {
+	const T* (*_lower_bound)( const T* begin, const T* end, T q );
+	const T* (*_upper_bound)( const T* begin, const T* end, T q );
+	void (*_lower_bound_batch)( const T* begin, const T* end,
+			const T* queries_begin, const T* queries_end, const T** out );
+	void (*_upper_bound_batch)( const T* begin, const T* end,
+			const T* queries_begin, const T* queries_end, const T** out );
+};
+
+/// Search kernels, compiled for one instruction set, for the values of
+/// the SIMD kernels ('std::int32_t', 'std::int64_t', 'float', 'double').
+struct q_ary_search_kernels {
+	q_ary_isa _isa;
+	q_ary_search_kernel_set< std::int32_t > _int32;
+	q_ary_search_kernel_set< std::int64_t > _int64;
+	q_ary_search_kernel_set< float > _float;
+	q_ary_search_kernel_set< double > _double;
+
+	/// Kernels of values of type 'T'.
+	template< typename T >
+	const q_ary_search_kernel_set< T >& of() const
+	{
+		if constexpr ( std::is_same< T, std::int32_t >::value )
+			return _int32;
+		else if constexpr ( std::is_same< T, std::int64_t >::value )
+			return _int64;
+		else if constexpr ( std::is_same< T, float >::value )
+			return _float;
+		else {
+			static_assert( std::is_same< T, double >::value,
+					"Dispatched kernels are of 32 and 64-bit integers and floats." );
+			return _double;
+		}
+	}
+};
+
+/// Kernels of 'isa', or null, if they are not built in, or the
+/// processor doesn't support 'isa'.
+const q_ary_search_kernels* q_ary_search_kernels_of( q_ary_isa isa );
+
+/// Kernels of the widest instruction set, which are built in, and which
+/// the processor supports (or of the one, named by 'Q_ARY_SEARCH_ISA'
+/// environment variable, if it's one of them).
+/// They are picked once, when the program is loaded.
+const q_ary_search_kernels& q_ary_best_search_kernels();
+
+
+/// Searches by the kernels of 'q_ary_best_search_kernels()', so one binary
+/// runs the best kernels of any processor, it's run on (for the libraries
+/// of the 'q_ary_search_kernels' target).
+/// Other code can call the kernels of a given instruction set directly,
+/// e.g. 'q_ary_search_kernels_of( isa )->of< T >()._lower_bound'.
+template< typename T >
+inline const T* q_ary_dispatched_lower_bound(
+		const T* begin, const T* end,
+		T q )
+	{ return q_ary_best_search_kernels().of< T >()._lower_bound( begin, end, q ); }
+
+template< typename T >
+inline const T* q_ary_dispatched_upper_bound(
+		const T* begin, const T* end,
+		T q )
+	{ return q_ary_best_search_kernels().of< T >()._upper_bound( begin, end, q ); }
+
+template< typename T >
+inline void q_ary_dispatched_lower_bound_batch(
+		const T* begin, const T* end,
+		const T* queries_begin, const T* queries_end,
+		const T** out )
+	{ q_ary_best_search_kernels().of< T >()._lower_bound_batch(
+			begin, end, queries_begin, queries_end, out ); }
+
+template< typename T >
+inline void q_ary_dispatched_upper_bound_batch(
+		const T* begin, const T* end,
+		const T* queries_begin, const T* queries_end,
+		const T** out )
+	{ q_ary_best_search_kernels().of< T >()._upper_bound_batch(
+			begin, end, queries_begin, queries_end, out ); }
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_SEARCH_DISPATCH_HPP
@@ -0,0 +1,900 @@
+
+/// Randomized differential test of the Q-ary search algorithms.
+///
+/// Every case is decoded from a string of bytes: the element type (int8,
+/// int32, int64, uint64, float, double, string, or record, a 64-bit key
+/// with a payload, searched by projection to the key, of 16 bytes, or of
+/// 128 bytes, wider than a cache line), how its values are
+/// drawn ('random' over the full range of the type, 'dense' from a few
+/// values, so with long runs of duplicates, or 'boundary', mostly the
+/// extreme values of the type: its minimum and maximum, zeros, infinities,
+/// denormals, strings across the 8-byte prefix border), and the length of
+/// the sorted array (from 0 to 2048). The rest of the bytes (and, once
+/// they run out, a pseudo-random generator seeded by all of them) give the
+/// values.
+/// The queries are all the values of the array, their neighbours (the
+/// closest values of the type below and above them), the boundary values,
+/// and random values, and the results of every search variant of the
+/// library, which applies to the type, are compared with those of
+/// 'std::lower_bound()' and 'std::upper_bound()':
+///  - 'q_ary_lower_bound()', 'q_ary_upper_bound()', 'q_ary_binary_search()'
+///    for every Q with every step policy, with the default and with run
+///    time parameters, on pointers and on other iterators,
+///  - 'q_ary_equal_range()', 'q_ary_range_count()',
+///  - the batch searches (in groups, sorted, and parallel),
+///  - 'q_ary_auto_lower_bound()', the interpolation searches,
+///  - the dispatched kernels of every instruction set, which is built in,
+///    and which the processor supports,
+///  - the index layouts: Eytzinger, static tree, learned index,
+///    compressed blocks, key column, sorted vector, NUMA replicas, string
+///    index.
+/// The first mismatch is reported (type, length, variant, query, expected
+/// and found rank), and aborts the process.
+///
+/// Built with 'Q_ARY_SEARCH_LIBFUZZER' defined (and '-fsanitize=fuzzer'),
+/// this is a libFuzzer target, every input of which is one case.
+/// Otherwise it's a program, which checks random cases:
+///    q_ary_search_fuzz [<count of cases> [<seed>]]
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_search_simd.hpp"
+#include "q_ary_interpolation_search.hpp"
+#include "q_ary_range_search.hpp"
+#include "q_ary_autotune.hpp"
+#include "q_ary_eytzinger_index.hpp"
+#include "q_ary_static_tree.hpp"
+#include "q_ary_key_column.hpp"
+#include "q_ary_compressed_blocks.hpp"
+#include "q_ary_string_index.hpp"
+#include "q_ary_numa_replicas.hpp"
+#include "q_ary_sorted_vector.hpp"
+#include "q_ary_learned_index.hpp"
+#include "q_ary_search_batch.hpp"
+#include "q_ary_search_parallel.hpp"
+#include "q_ary_search_dispatch.hpp"
+
+namespace {
+
+namespace alg = ml::algorithm;
+
+
+/// Longest array of a case.
+constexpr std::size_t max_length = 2048;
+
+/// How the values of a case are drawn.
+enum class value_mode : unsigned { random, dense, boundary };
+
+constexpr unsigned value_mode_count = 3;
+
+const char* value_mode_name( value_mode mode )
+{
+	switch ( mode ) {
+	case value_mode::random: return "random";
+	case value_mode::dense: return "dense";
+	default: return "boundary";
+	}
+}
+
+
+/// Bytes of the input of a case, followed by pseudo-random ones (from a
+/// generator seeded by all the input), once the input runs out.
+class input_source
+{
+protected:
+	const std::uint8_t* _data;
+	std::size_t _size;
+	std::size_t _position = 0;
+	std::mt19937_64 _random;
+
+public:
+	input_source( const std::uint8_t* data, std::size_t size )
+		: _data( data ), _size( size ), _random( _hash( data, size ) )
+		{}
+
+	/// Next 'bytes' bytes, as an integer.
+	std::uint64_t next( unsigned bytes = 8 )
+	{
+		std::uint64_t value = 0;
+		for ( unsigned i = 0; i < bytes; ++i )
+			value = value << 8 | (_position < _size
+					? _data[ _position++ ]
+					: (std::uint8_t)_random());
+		return value;
+	}
+
+	/// Next integer in [0, n).
+	std::uint64_t below( std::uint64_t n )
+		{ return n ? next( n <= 256 ? 1 : n <= 65536 ? 2 : 8 ) % n : 0; }
+
+protected:
+	/// FNV-1a hash of the input.
+	static std::uint64_t _hash( const std::uint8_t* data, std::size_t size )
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		for ( std::size_t i = 0; i < size; ++i )
+			hash = (hash ^ data[ i ]) * 1099511628211ull;
+		return hash;
+	}
+};
+
+
+/// Record of 'Bytes' bytes, searched by projection to its key.
+template< std::size_t Bytes >
+struct fuzz_basic_record {
+	std::int64_t _key;
+	std::int64_t _payload;
+	char _padding[ Bytes - 16 ];
+};
+
+template<>
+struct fuzz_basic_record< 16 > {
+	std::int64_t _key;
+	std::int64_t _payload;
+};
+
+/// Record of a key with a payload, and one wider than a cache line (so
+/// one value spans several cache lines, e.g. for the prefetching step).
+typedef fuzz_basic_record< 16 > fuzz_record;
+typedef fuzz_basic_record< 128 > fuzz_wide_record;
+
+/// Checks if 'T' is a record.
+template< typename T >
+struct is_fuzz_record : std::false_type {};
+
+template< std::size_t Bytes >
+struct is_fuzz_record< fuzz_basic_record< Bytes > > : std::true_type {};
+
+
+/// How values of type 'T' are drawn, which values are its neighbours and
+/// boundaries, and how they are reported.
+template< typename T, typename Enable = void >
+struct fuzz_type;
+
+template< typename T >
+struct fuzz_type< T, typename std::enable_if< std::is_integral< T >::value >::type > {
+	typedef T query_type;
+
+	static std::vector< T > boundaries()
+	{
+		typedef std::numeric_limits< T > limits;
+		std::vector< T > values = { limits::min(), (T)(limits::min() + 1),
+				(T)-1, (T)0, (T)1, (T)(limits::max() - 1), limits::max() };
+		if constexpr ( std::is_signed< T >::value )
+			values.push_back( (T)(limits::min() / 2) );
+		values.push_back( (T)(limits::max() / 2) );
+		return values;
+	}
+
+	static T make( input_source& source, value_mode mode )
+	{
+		switch ( mode ) {
+		case value_mode::random:
+			return (T)source.next( sizeof(T) );
+		case value_mode::dense:
+			return (T)((int)source.below( 9 ) - 4);
+		default: {
+			const std::vector< T > values = boundaries();
+			const std::uint64_t i = source.below( values.size() + 2 );
+			return i < values.size()
+					? values[ i ]
+					: (T)((std::uint64_t)values[ source.below( values.size() ) ]
+							+ source.below( 5 ) - 2);
+		}
+		}
+	}
+
+	static void neighbours( const T& v, std::vector< T >& out )
+	{
+		if ( v != std::numeric_limits< T >::min() )
+			out.push_back( (T)(v - 1) );
+		if ( v != std::numeric_limits< T >::max() )
+			out.push_back( (T)(v + 1) );
+	}
+
+	static std::string describe( const T& v )
+		{ return std::to_string( (typename std::conditional< std::is_signed< T >::value,
+				long long, unsigned long long >::type)v ); }
+};
+
+template< typename T >
+struct fuzz_type< T, typename std::enable_if< std::is_floating_point< T >::value >::type > {
+	typedef T query_type;
+
+	static std::vector< T > boundaries()
+	{
+		typedef std::numeric_limits< T > limits;
+		return { -limits::infinity(), limits::lowest(), (T)-1, -limits::min(),
+				-limits::denorm_min(), (T)-0.0, (T)0.0, limits::denorm_min(),
+				limits::min(), (T)1, limits::max(), limits::infinity() };
+	}
+
+	static T make( input_source& source, value_mode mode )
+	{
+		switch ( mode ) {
+		case value_mode::random:
+			// Of any sign and magnitude (within 2^-64 .. 2^64)
+			return (T)std::ldexp( (double)(std::int64_t)source.next(),
+					(int)source.below( 129 ) - 64 - 63 );
+		case value_mode::dense:
+			return (T)((int)source.below( 9 ) - 4) / 2;
+		default: {
+			const std::vector< T > values = boundaries();
+			return values[ source.below( values.size() ) ];
+		}
+		}
+	}
+
+	static void neighbours( const T& v, std::vector< T >& out )
+	{
+		out.push_back( std::nextafter( v, -std::numeric_limits< T >::infinity() ) );
+		out.push_back( std::nextafter( v, std::numeric_limits< T >::infinity() ) );
+	}
+
+	static std::string describe( const T& v )
+		{ std::ostringstream s;
+		  s.precision( std::numeric_limits< T >::max_digits10 );
+		  s << v;
+		  return s.str(); }
+};
+
+template<>
+struct fuzz_type< std::string > {
+	typedef std::string query_type;
+
+	static std::vector< std::string > boundaries()
+	{
+		return { std::string(), std::string( 1, '\0' ), std::string( 8, '\0' ),
+				"abcdefg", "abcdefgh", std::string( "abcdefgh\0", 9 ), "abcdefgha",
+				"abcdefgi", std::string( 8, '\xff' ), std::string( 9, '\xff' ) };
+	}
+
+	static std::string make( input_source& source, value_mode mode )
+	{
+		switch ( mode ) {
+		case value_mode::random: {
+			std::string s( source.below( 13 ), '\0' );
+			for ( char& c : s )
+				c = (char)source.next( 1 );
+			return s;
+		}
+		case value_mode::dense: {
+			std::string s( source.below( 4 ), '\0' );
+			for ( char& c : s )
+				c = "ab"[ source.below( 2 ) ];
+			return s;
+		}
+		default: {
+			// Around the border of the 8-byte prefix
+			std::string s = std::string( "abcdefgh" ).substr( 0, 6 + source.below( 3 ) );
+			const std::size_t suffix = source.below( 4 );
+			for ( std::size_t i = 0; i < suffix; ++i )
+				s.push_back( "\0a\xff"[ source.below( 3 ) ] );
+			return s;
+		}
+		}
+	}
+
+	static void neighbours( const std::string& v, std::vector< std::string >& out )
+	{
+		out.push_back( v + '\0' );
+		if ( ! v.empty() ) {
+			out.push_back( v.substr( 0, v.size() - 1 ) );
+			if ( v.back() != '\xff' )
+				out.push_back( v.substr( 0, v.size() - 1 ) + (char)(v.back() + 1) );
+		}
+	}
+
+	static std::string describe( const std::string& v )
+	{
+		std::string s = "\"";
+		for ( char c : v ) {
+			char hex[ 8 ];
+			std::snprintf( hex, sizeof(hex), "\\x%02x", (unsigned)(unsigned char)c );
+			s += std::isprint( (unsigned char)c ) ? std::string( 1, c ) : std::string( hex );
+		}
+		return s + "\"";
+	}
+};
+
+template< std::size_t Bytes >
+struct fuzz_type< fuzz_basic_record< Bytes > > {
+	typedef std::int64_t query_type;
+
+	static std::vector< std::int64_t > boundaries()
+		{ return fuzz_type< std::int64_t >::boundaries(); }
+
+	static fuzz_basic_record< Bytes > make( input_source& source, value_mode mode )
+	{
+		fuzz_basic_record< Bytes > record = {};
+		record._key = fuzz_type< std::int64_t >::make( source, mode );
+		return record;
+	}
+
+	static void neighbours( const fuzz_basic_record< Bytes >& v, std::vector< std::int64_t >& out )
+		{ out.push_back( v._key ); fuzz_type< std::int64_t >::neighbours( v._key, out ); }
+
+	static std::string describe( const std::int64_t& v )
+		{ return fuzz_type< std::int64_t >::describe( v ); }
+};
+
+/// Key of a value (the value itself, but for records).
+template< typename T >
+const T& key_of( const T& value )
+	{ return value; }
+
+template< std::size_t Bytes >
+const std::int64_t& key_of( const fuzz_basic_record< Bytes >& value )
+	{ return value._key; }
+
+
+/// One case: a sorted array of values of type 'T', the queries, and their
+/// lower and upper bounds, found by 'std::lower_bound()' and
+/// 'std::upper_bound()'.
+template< typename T >
+struct fuzz_case {
+	typedef typename fuzz_type< T >::query_type query_t;
+
+	const char* _type;
+	value_mode _mode;
+	std::vector< T > _values;
+	std::vector< query_t > _queries;
+	std::vector< std::size_t > _lower, _upper;
+
+	fuzz_case( const char* type, input_source& source )
+		: _type( type ), _mode( (value_mode)source.below( value_mode_count ) )
+	{
+		const std::size_t length = source.below( 4 ) == 0
+				? source.below( 33 )
+				: source.below( max_length + 1 );
+		for ( std::size_t i = 0; i < length; ++i )
+			_values.push_back( fuzz_type< T >::make( source, _mode ) );
+		std::sort( _values.begin(), _values.end(), []( const T& a, const T& b ) {
+				return key_of( a ) < key_of( b ); } );
+		for ( std::size_t i = 0; i < _values.size(); ++i )
+			if constexpr ( is_fuzz_record< T >::value )
+				_values[ i ]._payload = (std::int64_t)i;
+		// Queries
+		for ( const T& value : _values )
+			_queries.push_back( key_of( value ) );
+		for ( const T& value : _values )
+			fuzz_type< T >::neighbours( value, _queries );
+		for ( const query_t& q : fuzz_type< T >::boundaries() )
+			_queries.push_back( q );
+		for ( unsigned i = 0; i < 16; ++i ) {
+			_queries.push_back( key_of( fuzz_type< T >::make( source, _mode ) ) );
+			_queries.push_back( key_of( fuzz_type< T >::make( source, value_mode::random ) ) );
+		}
+		std::shuffle( _queries.begin(), _queries.end(), std::mt19937_64( source.next() ) );
+		// Expected results
+		for ( const query_t& q : _queries ) {
+			_lower.push_back( (std::size_t)(std::lower_bound( _values.begin(), _values.end(), q,
+					[]( const T& v, const query_t& q ) { return key_of( v ) < q; } ) - _values.begin()) );
+			_upper.push_back( (std::size_t)(std::upper_bound( _values.begin(), _values.end(), q,
+					[]( const query_t& q, const T& v ) { return q < key_of( v ); } ) - _values.begin()) );
+		}
+	}
+
+	std::size_t size() const
+		{ return _values.size(); }
+
+	const T* begin() const
+		{ return _values.data(); }
+
+	const T* end() const
+		{ return _values.data() + _values.size(); }
+
+	/// Rank of the lower (or upper) bound of query 'i'.
+	std::size_t expected( std::size_t i, bool upper ) const
+		{ return upper ? _upper[ i ] : _lower[ i ]; }
+
+	/// Checks 'found' rank of the lower (or upper) bound of query 'i' by
+	/// 'variant'.
+	template< typename NameT >
+	void expect( const NameT& variant, std::size_t i, bool upper,
+			std::size_t found ) const
+	{
+		if ( found != expected( i, upper ) )
+			fail( std::string( variant ) + (upper ? " (upper bound)" : " (lower bound)"),
+					i, expected( i, upper ), found );
+	}
+
+	/// Checks if query 'i' is 'found' by 'variant'.
+	template< typename NameT >
+	void expect_found( const NameT& variant, std::size_t i, bool found ) const
+	{
+		const bool present = _lower[ i ] != _upper[ i ];
+		if ( found != present )
+			fail( std::string( variant ), i, present, found );
+	}
+
+	/// Reports mismatch of 'variant' for query 'i', and aborts.
+	[[noreturn]] void fail( const std::string& variant, std::size_t i,
+			std::size_t expected, std::size_t found ) const
+	{
+		std::cerr << "Mismatch of " << variant << ":" << std::endl
+				<< "\t type: " << _type << ", values: " << value_mode_name( _mode )
+				<< ", length: " << _values.size() << std::endl
+				<< "\t query #" << i << ": " << fuzz_type< T >::describe( _queries[ i ] ) << std::endl
+				<< "\t expected: " << expected << ", found: " << found << std::endl;
+		if ( ! _values.empty() ) {
+			std::cerr << "\t values around expected:";
+			const std::size_t from = expected >= 2 ? expected - 2 : 0;
+			for ( std::size_t k = from; k < _values.size() && k < expected + 2; ++k )
+				std::cerr << " [" << k << "] " << fuzz_type< T >::describe( key_of( _values[ k ] ) );
+			std::cerr << std::endl;
+		}
+		std::abort();
+	}
+};
+
+
+/// Names of the step policies, for the reports.
+template< typename StepT >
+struct step_name;
+
+template<>
+struct step_name< alg::q_ary_branchy_step > {
+	static constexpr const char* value = "branchy";
+};
+
+template<>
+struct step_name< alg::q_ary_branchless_step > {
+	static constexpr const char* value = "branchless";
+};
+
+template<>
+struct step_name< alg::q_ary_simd_step > {
+	static constexpr const char* value = "simd";
+};
+
+template<>
+struct step_name< alg::q_ary_simd_tail_step<> > {
+	static constexpr const char* value = "simd_tail";
+};
+
+template<>
+struct step_name< alg::q_ary_prefetching_step< alg::q_ary_branchless_step > > {
+	static constexpr const char* value = "prefetching";
+};
+
+/// Name of a variant, e.g. "q_ary_lower_bound< 4, branchy >" (spelled out
+/// only when a mismatch is reported).
+template< unsigned Q, typename StepT >
+struct variant_name {
+	const char* _function;
+
+	explicit variant_name( const char* function )
+		: _function( function )
+		{}
+
+	operator std::string() const
+		{ return std::string( _function ) + "< " + std::to_string( Q ) + ", "
+				+ step_name< StepT >::value + " >"; }
+};
+
+
+/// Checks the flat searches of step 'StepT' (by Q 'Q').
+template< unsigned Q, typename StepT, typename T >
+void check_flat( const fuzz_case< T >& c )
+{
+	typedef typename fuzz_case< T >::query_t query_t;
+	const T* const begin = c.begin();
+	const T* const end = c.end();
+	const std::size_t count = c._queries.size();
+	for ( std::size_t i = 0; i < count; ++i ) {
+		const query_t& q = c._queries[ i ];
+		if constexpr ( is_fuzz_record< T >::value ) {
+			const auto comp = std::less< std::int64_t >();
+			const auto proj = &T::_key;
+			c.expect( variant_name< Q, StepT >( "q_ary_lower_bound (projected)" ), i, false,
+					(std::size_t)(alg::q_ary_lower_bound< Q, StepT >( begin, end, q, comp, proj ) - begin) );
+			c.expect( variant_name< Q, StepT >( "q_ary_upper_bound (projected)" ), i, true,
+					(std::size_t)(alg::q_ary_upper_bound< Q, StepT >( begin, end, q, comp, proj ) - begin) );
+			const std::pair< const T*, const T* > range =
+					alg::q_ary_equal_range< Q, StepT >( begin, end, q, comp, proj );
+			c.expect( variant_name< Q, StepT >( "q_ary_equal_range (projected)" ), i, false,
+					(std::size_t)(range.first - begin) );
+			c.expect( variant_name< Q, StepT >( "q_ary_equal_range (projected)" ), i, true,
+					(std::size_t)(range.second - begin) );
+		}
+		else {
+			c.expect( variant_name< Q, StepT >( "q_ary_lower_bound" ), i, false,
+					(std::size_t)(alg::q_ary_lower_bound< Q, StepT >( begin, end, q ) - begin) );
+			c.expect( variant_name< Q, StepT >( "q_ary_upper_bound" ), i, true,
+					(std::size_t)(alg::q_ary_upper_bound< Q, StepT >( begin, end, q ) - begin) );
+			// Shortest and an odd threshold, given at run time
+			for ( const alg::length_t threshold : { (alg::length_t)Q, (alg::length_t)(3 * Q + 1) } ) {
+				const alg::q_ary_runtime_parameters params = { threshold };
+				c.expect( variant_name< Q, StepT >( "q_ary_lower_bound (run time threshold)" ), i, false,
+						(std::size_t)(alg::q_ary_lower_bound< Q, StepT >( begin, end, q, params ) - begin) );
+				c.expect( variant_name< Q, StepT >( "q_ary_upper_bound (run time threshold)" ), i, true,
+						(std::size_t)(alg::q_ary_upper_bound< Q, StepT >( begin, end, q, params ) - begin) );
+			}
+			const std::pair< const T*, const T* > range =
+					alg::q_ary_equal_range< Q, StepT >( begin, end, q );
+			c.expect( variant_name< Q, StepT >( "q_ary_equal_range" ), i, false,
+					(std::size_t)(range.first - begin) );
+			c.expect( variant_name< Q, StepT >( "q_ary_equal_range" ), i, true,
+					(std::size_t)(range.second - begin) );
+			c.expect_found( variant_name< Q, StepT >( "q_ary_binary_search" ), i,
+					alg::q_ary_binary_search< Q, StepT >( begin, end, q ) );
+		}
+		// Count in [q, next query)
+		const std::size_t j = (i + 1) % count;
+		const query_t& hi = c._queries[ j ];
+		std::size_t range_count;
+		if constexpr ( is_fuzz_record< T >::value )
+			range_count = (std::size_t)alg::q_ary_range_count< Q, StepT >( begin, end, q, hi,
+					std::less< std::int64_t >(), &T::_key );
+		else
+			range_count = (std::size_t)alg::q_ary_range_count< Q, StepT >( begin, end, q, hi );
+		const std::size_t expected_count = q < hi ? c._lower[ j ] - c._lower[ i ] : 0;
+		if ( range_count != expected_count )
+			c.fail( variant_name< Q, StepT >( "q_ary_range_count" ), i, expected_count, range_count );
+	}
+	// Batches
+	std::vector< const T* > out( count );
+	for ( const bool upper : { false, true } ) {
+		if constexpr ( is_fuzz_record< T >::value ) {
+			if ( upper )
+				alg::q_ary_search_batch< Q, StepT >( begin, end,
+						c._queries.begin(), c._queries.end(), out.begin(),
+						alg::q_ary_projected_pred< std::less< std::int64_t >,
+								std::int64_t T::*, true >{ {}, &T::_key } );
+			else
+				alg::q_ary_search_batch< Q, StepT >( begin, end,
+						c._queries.begin(), c._queries.end(), out.begin(),
+						alg::q_ary_projected_pred< std::less< std::int64_t >,
+								std::int64_t T::* >{ {}, &T::_key } );
+		}
+		else if ( upper )
+			alg::q_ary_upper_bound_batch< Q, StepT >( begin, end,
+					c._queries.begin(), c._queries.end(), out.begin() );
+		else
+			alg::q_ary_lower_bound_batch< Q, StepT >( begin, end,
+					c._queries.begin(), c._queries.end(), out.begin() );
+		for ( std::size_t i = 0; i < count; ++i )
+			c.expect( variant_name< Q, StepT >( "q_ary_search_batch" ), i, upper,
+					(std::size_t)(out[ i ] - begin) );
+	}
+}
+
+/// Checks the flat searches of all the steps 'StepsT' by Q 'Q'.
+template< unsigned Q, typename... StepsT, typename T >
+void check_flat_steps( const fuzz_case< T >& c )
+	{ ( check_flat< Q, StepsT >( c ), ... ); }
+
+/// Checks the flat searches of all the steps 'StepsT' by all the 'Qs'.
+template< typename... StepsT, typename T, unsigned... Qs >
+void check_flat_all( const fuzz_case< T >& c, std::integer_sequence< unsigned, Qs... > )
+	{ ( check_flat_steps< Qs, StepsT... >( c ), ... ); }
+
+/// Values of Q, which are checked.
+typedef std::integer_sequence< unsigned, 2, 3, 4, 5, 6, 7, 8, 16, 32 > fuzz_qs;
+
+
+/// Checks the searches of sorted batches of queries, of a vector's
+/// iterators, and the parallel batches.
+template< typename T >
+void check_batches( const fuzz_case< T >& c )
+{
+	typedef typename fuzz_case< T >::query_t query_t;
+	const std::size_t count = c._queries.size();
+	// Order of the queries
+	std::vector< std::size_t > order( count );
+	std::iota( order.begin(), order.end(), (std::size_t)0 );
+	std::stable_sort( order.begin(), order.end(), [&c]( std::size_t a, std::size_t b ) {
+			return c._queries[ a ] < c._queries[ b ]; } );
+	std::vector< query_t > sorted;
+	for ( std::size_t i : order )
+		sorted.push_back( c._queries[ i ] );
+	typedef typename std::vector< T >::const_iterator it_t;
+	std::vector< it_t > out( count );
+	for ( const bool upper : { false, true } ) {
+		if constexpr ( is_fuzz_record< T >::value ) {
+			if ( upper )
+				alg::q_ary_search_sorted_batch< 4 >( c._values.begin(), c._values.end(),
+						sorted.begin(), sorted.end(), out.begin(),
+						alg::q_ary_projected_pred< std::less< std::int64_t >,
+								std::int64_t T::*, true >{ {}, &T::_key } );
+			else
+				alg::q_ary_search_sorted_batch< 4 >( c._values.begin(), c._values.end(),
+						sorted.begin(), sorted.end(), out.begin(),
+						alg::q_ary_projected_pred< std::less< std::int64_t >,
+								std::int64_t T::* >{ {}, &T::_key } );
+		}
+		else if ( upper )
+			alg::q_ary_upper_bound_sorted_batch< 4 >( c._values.begin(), c._values.end(),
+					sorted.begin(), sorted.end(), out.begin() );
+		else
+			alg::q_ary_lower_bound_sorted_batch< 4 >( c._values.begin(), c._values.end(),
+					sorted.begin(), sorted.end(), out.begin() );
+		for ( std::size_t k = 0; k < count; ++k )
+			c.expect( "q_ary_search_sorted_batch< 4 >", order[ k ], upper,
+					(std::size_t)(out[ k ] - c._values.begin()) );
+	}
+	if constexpr ( ! is_fuzz_record< T >::value ) {
+		// Iterators of a vector (not pointers)
+		for ( std::size_t i = 0; i < count; ++i ) {
+			const query_t& q = c._queries[ i ];
+			c.expect( "q_ary_lower_bound< 5, branchless > (vector iterators)", i, false,
+					(std::size_t)(alg::q_ary_lower_bound< 5, alg::q_ary_branchless_step >(
+							c._values.begin(), c._values.end(), q ) - c._values.begin()) );
+			c.expect( "q_ary_upper_bound< 5, branchless > (vector iterators)", i, true,
+					(std::size_t)(alg::q_ary_upper_bound< 5, alg::q_ary_branchless_step >(
+							c._values.begin(), c._values.end(), q ) - c._values.begin()) );
+		}
+		// Parallel, by short chunks
+		const alg::q_ary_parallel_executor executor( alg::q_ary_default_thread_pool(), 64 );
+		std::vector< const T* > ptrs( count );
+		alg::q_ary_lower_bound_batch< 8 >( executor, c.begin(), c.end(),
+				c._queries.begin(), c._queries.end(), ptrs.begin() );
+		for ( std::size_t i = 0; i < count; ++i )
+			c.expect( "q_ary_lower_bound_batch< 8 > (parallel)", i, false,
+					(std::size_t)(ptrs[ i ] - c.begin()) );
+		alg::q_ary_upper_bound_batch< 8 >( executor, c.begin(), c.end(),
+				c._queries.begin(), c._queries.end(), ptrs.begin() );
+		for ( std::size_t i = 0; i < count; ++i )
+			c.expect( "q_ary_upper_bound_batch< 8 > (parallel)", i, true,
+					(std::size_t)(ptrs[ i ] - c.begin()) );
+	}
+}
+
+
+/// Checks the automatically tuned searches of step 'StepT'.
+template< typename StepT, typename T >
+void check_auto( const fuzz_case< T >& c )
+{
+	const std::string name = std::string( "q_ary_auto_search< " ) + step_name< StepT >::value + " >";
+	for ( std::size_t i = 0; i < c._queries.size(); ++i ) {
+		c.expect( name, i, false, (std::size_t)(alg::q_ary_auto_lower_bound< StepT >(
+				c.begin(), c.end(), c._queries[ i ] ) - c.begin()) );
+		c.expect( name, i, true, (std::size_t)(alg::q_ary_auto_upper_bound< StepT >(
+				c.begin(), c.end(), c._queries[ i ] ) - c.begin()) );
+	}
+}
+
+/// Checks the interpolation searches by Q 'Q'.
+template< unsigned Q, typename StepT, typename T >
+void check_interpolation( const fuzz_case< T >& c )
+{
+	for ( std::size_t i = 0; i < c._queries.size(); ++i ) {
+		c.expect( variant_name< Q, StepT >( "q_ary_interpolation_search" ), i, false,
+				(std::size_t)(alg::q_ary_interpolation_lower_bound< Q, StepT >(
+						c.begin(), c.end(), c._queries[ i ] ) - c.begin()) );
+		c.expect( variant_name< Q, StepT >( "q_ary_interpolation_search" ), i, true,
+				(std::size_t)(alg::q_ary_interpolation_upper_bound< Q, StepT >(
+						c.begin(), c.end(), c._queries[ i ] ) - c.begin()) );
+	}
+}
+
+/// Checks index 'index' (of ranks), named 'name'.
+template< typename IndexT, typename T >
+void check_index( const std::string& name, const IndexT& index, const fuzz_case< T >& c )
+{
+	if ( index.size() != c.size() )
+		c.fail( name + " (size)", 0, c.size(), (std::size_t)index.size() );
+	const std::string contains_name = name + " (contains)";
+	for ( std::size_t i = 0; i < c._queries.size(); ++i ) {
+		const auto& q = c._queries[ i ];
+		c.expect( name, i, false, (std::size_t)index.lower_bound( q ) );
+		c.expect( name, i, true, (std::size_t)index.upper_bound( q ) );
+		c.expect_found( contains_name, i, index.contains( q ) );
+	}
+}
+
+/// Checks the indexes over array of arithmetic values.
+template< typename T >
+void check_indexes( const fuzz_case< T >& c )
+{
+	check_index( "q_ary_eytzinger_index< default Q >",
+			alg::q_ary_eytzinger_index< T >( c.begin(), c.end() ), c );
+	check_index( "q_ary_eytzinger_index< 2, branchy >",
+			alg::q_ary_eytzinger_index< T, 2, alg::q_ary_branchy_step >( c.begin(), c.end() ), c );
+	check_index( "q_ary_eytzinger_index< 5, simd >",
+			alg::q_ary_eytzinger_index< T, 5, alg::q_ary_simd_step >( c.begin(), c.end() ), c );
+	check_index( "q_ary_eytzinger_index< 16, prefetching >",
+			alg::q_ary_eytzinger_index< T, 16,
+					alg::q_ary_prefetching_step< alg::q_ary_branchless_step > >( c.begin(), c.end() ), c );
+	check_index( "q_ary_static_tree< default B >",
+			alg::q_ary_static_tree< T >( c.begin(), c.end() ), c );
+	check_index( "q_ary_static_tree< 2, branchy >",
+			alg::q_ary_static_tree< T, 2, alg::q_ary_branchy_step >( c.begin(), c.end() ), c );
+	check_index( "q_ary_static_tree< 7, branchless >",
+			alg::q_ary_static_tree< T, 7, alg::q_ary_branchless_step >( c.begin(), c.end() ), c );
+	check_index( "q_ary_learned_index< default epsilon >",
+			alg::q_ary_learned_index< T >( c.begin(), c.end() ), c );
+	check_index( "q_ary_learned_index< 1 >",
+			alg::q_ary_learned_index< T, 1 >( c.begin(), c.end() ), c );
+	check_index( "q_ary_key_column",
+			alg::q_ary_key_column< T >( c.begin(), c.end() ), c );
+	{
+		// Appended in pieces, so a part is left out of the index
+		alg::q_ary_key_column< T, 8, alg::q_ary_simd_step, alg::q_ary_eytzinger_index< T > > column;
+		const std::size_t half = c.size() / 2, three_quarters = c.size() * 3 / 4;
+		column.build( c.begin(), c.begin() + half );
+		column.append( c.begin() + half, c.begin() + three_quarters );
+		column.append( c.begin() + three_quarters, c.end() );
+		check_index( "q_ary_key_column< eytzinger > (appended)", column, c );
+	}
+	{
+		// Half of the values inserted in batches, into the delta and
+		// through rebuilds of the base
+		const std::size_t half = c.size() / 2;
+		alg::q_ary_sorted_vector< T, alg::q_ary_eytzinger_index< T > > vector(
+				c.begin(), c.begin() + half, 7, false );
+		for ( std::size_t k = c.size(); k-- > half; )
+			vector.insert( c._values[ k ] );
+		vector.flush();
+		vector.wait();
+		check_index( "q_ary_sorted_vector< eytzinger >", vector, c );
+		alg::q_ary_sorted_vector< T > plain( c.begin() + half, c.end(), 5, false );
+		plain.insert( c.begin(), c.begin() + half );
+		plain.flush();
+		plain.wait();
+		check_index( "q_ary_sorted_vector", plain, c );
+	}
+	check_index( "q_ary_numa_replicas< static_tree >",
+			alg::q_ary_numa_replicas< alg::q_ary_static_tree< T > >( c.begin(), c.end() ), c );
+	if constexpr ( std::is_integral< T >::value ) {
+		check_index( "q_ary_compressed_blocks< int8 >",
+				alg::q_ary_compressed_blocks< T, std::int8_t >( c.begin(), c.end() ), c );
+		check_index( "q_ary_compressed_blocks< int8, 5 keys, 3, branchy >",
+				alg::q_ary_compressed_blocks< T, std::int8_t, 5, 3,
+						alg::q_ary_branchy_step >( c.begin(), c.end() ), c );
+		if constexpr ( sizeof(T) >= 2 )
+			check_index( "q_ary_compressed_blocks< int16 >",
+					alg::q_ary_compressed_blocks< T, std::int16_t >( c.begin(), c.end() ), c );
+		if constexpr ( sizeof(T) >= 4 )
+			check_index( "q_ary_compressed_blocks< int32, 16, simd >",
+					alg::q_ary_compressed_blocks< T, std::int32_t,
+							alg::q_ary_compressed_block_keys< std::int32_t >(), 16,
+							alg::q_ary_simd_step >( c.begin(), c.end() ), c );
+	}
+}
+
+
+/// Checks the dispatched kernels of every instruction set, which is built
+/// in, and which the processor supports.
+template< typename T >
+void check_dispatched( const fuzz_case< T >& c )
+{
+	const std::size_t count = c._queries.size();
+	std::vector< const T* > out( count );
+	for ( unsigned i = 0; i < alg::q_ary_isa_count; ++i ) {
+		const alg::q_ary_search_kernels* kernels = alg::q_ary_search_kernels_of( (alg::q_ary_isa)i );
+		if ( kernels == nullptr )
+			continue;
+		const alg::q_ary_search_kernel_set< T >& set = kernels->of< T >();
+		const std::string name = std::string( "q_ary_search_kernels< " ) 
+				+ alg::q_ary_isa_name( (alg::q_ary_isa)i ) + " >";
+		for ( std::size_t k = 0; k < count; ++k ) {
+			c.expect( name, k, false, (std::size_t)(set._lower_bound( 
+					c.begin(), c.end(), c._queries[ k ] ) - c.begin()) );
+			c.expect( name, k, true, (std::size_t)(set._upper_bound( 
+					c.begin(), c.end(), c._queries[ k ] ) - c.begin()) );
+		}
+		set._lower_bound_batch( c.begin(), c.end(), 
+				c._queries.data(), c._queries.data() + count, out.data() );
+		for ( std::size_t k = 0; k < count; ++k )
+			c.expect( name + " (batch)", k, false, (std::size_t)(out[ k ] - c.begin()) );
+		set._upper_bound_batch( c.begin(), c.end(), 
+				c._queries.data(), c._queries.data() + count, out.data() );
+		for ( std::size_t k = 0; k < count; ++k )
+			c.expect( name + " (batch)", k, true, (std::size_t)(out[ k ] - c.begin()) );
+	}
+}
+
+
+/// Runs the checks, which apply to type 'T', on the case from 'source'.
+template< typename T >
+void check( const char* type, input_source& source )
+{
+	const fuzz_case< T > c( type, source );
+	check_flat_all<
+			alg::q_ary_branchy_step,
+			alg::q_ary_branchless_step,
+			alg::q_ary_simd_step,
+			alg::q_ary_simd_tail_step<>,
+			alg::q_ary_prefetching_step< alg::q_ary_branchless_step > >( c, fuzz_qs() );
+	check_batches( c );
+	if constexpr ( std::is_same< T, std::string >::value ) {
+		const std::vector< std::string_view > keys( c._values.begin(), c._values.end() );
+		check_index( "q_ary_string_index< default Q >",
+				alg::q_ary_string_index<>( keys.begin(), keys.end() ), c );
+		check_index( "q_ary_string_index< 3, branchy >",
+				alg::q_ary_string_index< 3, alg::q_ary_branchy_step >( c._values.begin(), c._values.end() ), c );
+		check_index( "q_ary_string_index< 16, simd >",
+				alg::q_ary_string_index< 16, alg::q_ary_simd_step >( c._values.begin(), c._values.end() ), c );
+		check_index( "q_ary_key_column< std::string >",
+				alg::q_ary_key_column< std::string >( c.begin(), c.end() ), c );
+	}
+	else if constexpr ( is_fuzz_record< T >::value ) {
+		check_index( "q_ary_key_column< record key >",
+				alg::q_ary_key_column< std::int64_t, 8, alg::q_ary_simd_step >(
+						c.begin(), c.end(), &T::_key ), c );
+	}
+	else {
+		check_auto< alg::q_ary_branchy_step >( c );
+		check_auto< alg::q_ary_branchless_step >( c );
+		check_auto< alg::q_ary_simd_step >( c );
+		check_interpolation< 2, alg::q_ary_branchy_step >( c );
+		check_interpolation< 4, alg::q_ary_branchless_step >( c );
+		check_interpolation< 8, alg::q_ary_simd_step >( c );
+		if constexpr ( std::is_same< T, std::int32_t >::value || std::is_same< T, std::int64_t >::value
+				|| std::is_same< T, float >::value || std::is_same< T, double >::value )
+			check_dispatched( c );
+		check_indexes( c );
+	}
+}
+
+/// Checks the case, given by 'data'.
+void check_input( const std::uint8_t* data, std::size_t size )
+{
+	input_source source( data, size );
+	switch ( source.below( 9 ) ) {
+	case 0: check< std::int8_t >( "int8", source ); break;
+	case 1: check< std::int32_t >( "int32", source ); break;
+	case 2: check< std::int64_t >( "int64", source ); break;
+	case 3: check< std::uint64_t >( "uint64", source ); break;
+	case 4: check< float >( "float", source ); break;
+	case 5: check< double >( "double", source ); break;
+	case 6: check< std::string >( "string", source ); break;
+	case 7: check< fuzz_record >( "record", source ); break;
+	default: check< fuzz_wide_record >( "wide record", source ); break;
+	}
+}
+
+
+} // namespace
+
+
+#if defined( Q_ARY_SEARCH_LIBFUZZER )
+
+extern "C" int LLVMFuzzerTestOneInput( const std::uint8_t* data, std::size_t size )
+{
+	check_input( data, size );
+	return 0;
+}
+
+#else
+
+int main( int argc, char* argv[] )
+{
+	const unsigned long cases = argc > 1 ? std::strtoul( argv[ 1 ], nullptr, 10 ) : 1000;
+	const unsigned long seed = argc > 2
+			? std::strtoul( argv[ 2 ], nullptr, 10 )
+			: (unsigned long)std::random_device()();
+	std::cout << "Checking " << cases << " random cases (seed " << seed << ") ..." << std::endl;
+	std::mt19937_64 random( seed );
+	for ( unsigned long i = 0; i < cases; ++i ) {
+		// Type, values and length of the case, and the seed of the rest
+		std::uint8_t input[ 16 ];
+		for ( std::uint8_t& byte : input )
+			byte = (std::uint8_t)random();
+		// Every type in turn
+		input[ 0 ] = (std::uint8_t)(i % 8);
+		check_input( input, sizeof(input) );
+	}
+	std::cout << "All the cases match." << std::endl;
+	return 0;
+}
+
+#endif
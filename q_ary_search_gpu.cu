@@ -0,0 +1,318 @@
+
+/// CUDA backend of the batch search (see "q_ary_search_gpu.hpp"):
+/// the warp-cooperative search kernel over the uploaded static tree, and
+/// the pipeline of the chunks of a batch over the streams.
+
+#include "q_ary_search_gpu.hpp"
+#include "q_ary_static_tree.hpp"
+
+#include <cuda_runtime.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace ml {
+namespace algorithm {
+
+namespace {
+
+constexpr unsigned warp_size = 32;
+constexpr unsigned full_warp_mask = 0xffffffffu;
+
+/// Threads of one block of the kernel (8 warps).
+constexpr unsigned block_size = 256;
+
+/// Most levels of the uploaded tree (with 33 children per node, enough
+/// for any array, which fits in a device).
+constexpr unsigned max_levels = 16;
+
+/// The uploaded static tree, as the kernel sees it (passed by value, so
+/// the levels are in the constant bank). Levels are counted from the
+/// bottom, as in 'q_ary_static_tree'.
+template< typename T >
+struct gpu_tree {
+	const T* _nodes;
+	std::size_t _size;
+	unsigned _height;
+	std::size_t _offsets[ max_levels ];
+	std::size_t _counts[ max_levels ];
+};
+
+/// Predicate of the lower ('key < q') or of the upper ('key <= q') bound.
+template< bool Upper, typename T >
+__device__ __forceinline__ bool satisfies( const T& key, const T& q )
+	{ return Upper ? key <= q : key < q; }
+
+/// Searches queries [queries, queries + count) in 'tree', and writes
+/// their ranks to 'ranks'.
+/// Every warp loads 32 consecutive queries (one per lane), then searches
+/// them one by one, all the lanes together: on every level, lane 'j' loads
+/// key 'j' of the node, and the count of the keys, which satisfy the
+/// predicate, chooses the child. So the loop is uniform across the warp,
+/// and the ballots are of full warps. The ranks are stored by one
+/// coalesced write per 32 queries.
+template< bool Upper, typename T, typename RankT >
+__global__ void search_kernel( const gpu_tree< T > tree,
+		const T* __restrict__ queries, const std::size_t count,
+		RankT* __restrict__ ranks )
+{
+	const unsigned lane = threadIdx.x % warp_size;
+	const std::size_t stride = (std::size_t)gridDim.x * blockDim.x;
+	for ( std::size_t base = ((std::size_t)blockIdx.x * blockDim.x + threadIdx.x) - lane;
+			base < count; base += stride ) {
+		const std::size_t own = base + lane;
+		const T own_q = queries[ own < count ? own : base ];
+		const unsigned n = count - base < warp_size ? (unsigned)(count - base) : warp_size;
+		RankT own_rank = 0;
+		for ( unsigned j = 0; j < n; ++j ) {
+			const T q = __shfl_sync( full_warp_mask, own_q, j );
+			std::size_t k = 0;  // Node in the current level
+			for ( unsigned l = tree._height - 1; l > 0; --l ) {
+				const T key = tree._nodes[ tree._offsets[ l ] + k * warp_size + lane ];
+				const unsigned i = __popc( __ballot_sync( full_warp_mask, satisfies< Upper >( key, q ) ) );
+				// Children past the end have only padding keys (see
+				// 'q_ary_static_tree::search()')
+				k = k * (warp_size + 1) + i;
+				const std::size_t last = tree._counts[ l - 1 ] - 1;
+				k = k < last ? k : last;
+			}
+			const T key = tree._nodes[ tree._offsets[ 0 ] + k * warp_size + lane ];
+			const std::size_t rank = k * warp_size
+					+ __popc( __ballot_sync( full_warp_mask, satisfies< Upper >( key, q ) ) );
+			if ( lane == j )
+				own_rank = (RankT)(rank < tree._size ? rank : tree._size);
+		}
+		if ( own < count )
+			ranks[ own ] = own_rank;
+	}
+}
+
+} // namespace
+
+
+bool q_ary_gpu_available()
+{
+	int count = 0;
+	return cudaGetDeviceCount( &count ) == cudaSuccess && count > 0;
+}
+
+
+template< typename T >
+struct q_ary_gpu_searcher< T >::state {
+	/// Buffers and the stream of one chunk in flight.
+	struct slot {
+		cudaStream_t _stream = nullptr;
+		T* _host_queries = nullptr;
+		void* _host_ranks = nullptr;
+		T* _device_queries = nullptr;
+		void* _device_ranks = nullptr;
+		/// The chunk in flight, if any: its first query, and its count of
+		/// queries.
+		bool _pending = false;
+		size_type _first = 0;
+		size_type _count = 0;
+	};
+
+	int _device = 0;
+	gpu_tree< T > _tree = {};
+	T* _device_nodes = nullptr;
+	size_type _nodes_size = 0;
+	size_type _chunk_size = 0;
+	/// If the ranks are transferred as 32-bit numbers.
+	bool _narrow_ranks = false;
+	/// Count of blocks of the kernel, which keep all the multiprocessors
+	/// busy.
+	unsigned _grid_size = 1;
+	std::vector< slot > _slots;
+
+	~state()
+	{
+		cudaSetDevice( _device );
+		for ( slot& s : _slots ) {
+			if ( s._stream != nullptr ) {
+				cudaStreamSynchronize( s._stream );
+				cudaStreamDestroy( s._stream );
+			}
+			cudaFreeHost( s._host_queries );
+			cudaFreeHost( s._host_ranks );
+			cudaFree( s._device_queries );
+			cudaFree( s._device_ranks );
+		}
+		cudaFree( _device_nodes );
+	}
+
+	size_type rank_bytes() const
+		{ return _narrow_ranks ? sizeof(std::uint32_t) : sizeof(std::uint64_t); }
+
+	/// Copies the results of the chunk of 's', if any, to 'out', once they
+	/// arrive.
+	bool drain( slot& s, size_type* out )
+	{
+		if ( ! s._pending )
+			return true;
+		s._pending = false;
+		if ( cudaStreamSynchronize( s._stream ) != cudaSuccess )
+			return false;
+		size_type* const chunk_out = out + s._first;
+		if ( _narrow_ranks ) {
+			const std::uint32_t* const ranks = static_cast< const std::uint32_t* >( s._host_ranks );
+			for ( size_type i = 0; i < s._count; ++i )
+				chunk_out[ i ] = ranks[ i ];
+		}
+		else {
+			const std::uint64_t* const ranks = static_cast< const std::uint64_t* >( s._host_ranks );
+			for ( size_type i = 0; i < s._count; ++i )
+				chunk_out[ i ] = (size_type)ranks[ i ];
+		}
+		return true;
+	}
+};
+
+
+template< typename T >
+q_ary_gpu_searcher< T >::q_ary_gpu_searcher() = default;
+
+template< typename T >
+q_ary_gpu_searcher< T >::~q_ary_gpu_searcher() = default;
+
+template< typename T >
+bool q_ary_gpu_searcher< T >::open( const T* begin, const T* end,
+		int device,
+		size_type chunk_size,
+		unsigned stream_count )
+{
+	static_assert( keys_per_node == warp_size,
+			"A node of the uploaded tree must be as wide as a warp." );
+	close();
+	std::unique_ptr< state > st( new state );
+	st->_device = device;
+	st->_chunk_size = chunk_size > 0 ? chunk_size : 1;
+	const size_type size = (size_type)(end - begin);
+	st->_narrow_ranks = size <= (size_type)UINT32_MAX;
+	if ( cudaSetDevice( device ) != cudaSuccess )
+		return false;
+	int multiprocessors = 1;
+	if ( cudaDeviceGetAttribute( &multiprocessors, cudaDevAttrMultiProcessorCount, device ) != cudaSuccess )
+		return false;
+	st->_grid_size = (unsigned)multiprocessors * (2048 / block_size);
+	// The tree, built on the host, and uploaded once
+	if ( size > 0 ) {
+		const q_ary_static_tree< T, keys_per_node, q_ary_branchless_step > tree( begin, end );
+		if ( tree.height() > max_levels )
+			return false;
+		st->_nodes_size = tree.nodes_size();
+		if ( cudaMalloc( &st->_device_nodes, st->_nodes_size * sizeof(T) ) != cudaSuccess
+				|| cudaMemcpy( st->_device_nodes, tree.nodes(), st->_nodes_size * sizeof(T),
+						cudaMemcpyHostToDevice ) != cudaSuccess )
+			return false;
+		st->_tree._nodes = st->_device_nodes;
+		st->_tree._size = size;
+		st->_tree._height = (unsigned)tree.height();
+		for ( unsigned l = 0; l < st->_tree._height; ++l ) {
+			st->_tree._offsets[ l ] = tree.level_offset( l );
+			st->_tree._counts[ l ] = tree.level_count( l );
+		}
+	}
+	// Buffers of the chunks
+	st->_slots.resize( stream_count > 0 ? stream_count : 1 );
+	for ( typename state::slot& s : st->_slots )
+		if ( cudaStreamCreateWithFlags( &s._stream, cudaStreamNonBlocking ) != cudaSuccess
+				|| cudaMallocHost( &s._host_queries, st->_chunk_size * sizeof(T) ) != cudaSuccess
+				|| cudaMallocHost( &s._host_ranks, st->_chunk_size * st->rank_bytes() ) != cudaSuccess
+				|| cudaMalloc( &s._device_queries, st->_chunk_size * sizeof(T) ) != cudaSuccess
+				|| cudaMalloc( &s._device_ranks, st->_chunk_size * st->rank_bytes() ) != cudaSuccess )
+			return false;
+	_state = std::move( st );
+	_size = size;
+	return true;
+}
+
+template< typename T >
+void q_ary_gpu_searcher< T >::close()
+{
+	_state.reset();
+	_size = 0;
+}
+
+template< typename T >
+bool q_ary_gpu_searcher< T >::lower_bound_batch( const T* queries_begin, const T* queries_end,
+		size_type* out )
+	{ return _search_batch< false >( queries_begin, queries_end, out ); }
+
+template< typename T >
+bool q_ary_gpu_searcher< T >::upper_bound_batch( const T* queries_begin, const T* queries_end,
+		size_type* out )
+	{ return _search_batch< true >( queries_begin, queries_end, out ); }
+
+template< typename T >
+typename q_ary_gpu_searcher< T >::size_type q_ary_gpu_searcher< T >::device_memory_footprint() const
+{
+	if ( _state == nullptr )
+		return 0;
+	return _state->_nodes_size * sizeof(T) + _state->_slots.size()
+			* _state->_chunk_size * (sizeof(T) + _state->rank_bytes());
+}
+
+template< typename T >
+template< bool Upper >
+bool q_ary_gpu_searcher< T >::_search_batch( const T* queries_begin, const T* queries_end,
+		size_type* out )
+{
+	if ( _state == nullptr )
+		return false;
+	const size_type count = (size_type)(queries_end - queries_begin);
+	if ( _size == 0 ) {
+		std::fill( out, out + count, (size_type)0 );
+		return true;
+	}
+	state& st = *_state;
+	if ( cudaSetDevice( st._device ) != cudaSuccess )
+		return false;
+	bool ok = true;
+	size_type chunk = 0;
+	for ( size_type first = 0; ok && first < count; first += st._chunk_size, ++chunk ) {
+		typename state::slot& s = st._slots[ chunk % st._slots.size() ];
+		// The slot's previous chunk is done by now, most probably, as all
+		// the other slots have been issued since
+		if ( ! st.drain( s, out ) ) {
+			ok = false;
+			break;
+		}
+		s._first = first;
+		s._count = count - first < st._chunk_size ? count - first : st._chunk_size;
+		std::memcpy( s._host_queries, queries_begin + first, s._count * sizeof(T) );
+		ok = cudaMemcpyAsync( s._device_queries, s._host_queries, s._count * sizeof(T),
+				cudaMemcpyHostToDevice, s._stream ) == cudaSuccess;
+		if ( ! ok )
+			break;
+		const size_type blocks = (s._count + block_size - 1) / block_size;
+		const unsigned grid_size = blocks < st._grid_size ? (unsigned)blocks : st._grid_size;
+		if ( st._narrow_ranks )
+			search_kernel< Upper ><<< grid_size, block_size, 0, s._stream >>>( st._tree,
+					s._device_queries, s._count, static_cast< std::uint32_t* >( s._device_ranks ) );
+		else
+			search_kernel< Upper ><<< grid_size, block_size, 0, s._stream >>>( st._tree,
+					s._device_queries, s._count, static_cast< std::uint64_t* >( s._device_ranks ) );
+		ok = cudaGetLastError() == cudaSuccess
+				&& cudaMemcpyAsync( s._host_ranks, s._device_ranks, s._count * st.rank_bytes(),
+						cudaMemcpyDeviceToHost, s._stream ) == cudaSuccess;
+		s._pending = true;
+	}
+	// The last chunks (and, on an error, the ones still in flight)
+	for ( typename state::slot& s : st._slots )
+		ok = st.drain( s, out ) && ok;
+	return ok;
+}
+
+
+template class q_ary_gpu_searcher< std::int32_t >;
+template class q_ary_gpu_searcher< std::uint32_t >;
+template class q_ary_gpu_searcher< std::int64_t >;
+template class q_ary_gpu_searcher< std::uint64_t >;
+template class q_ary_gpu_searcher< float >;
+template class q_ary_gpu_searcher< double >;
+
+
+} // namespace algorithm
+} // namespace ml
@@ -0,0 +1,130 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_SEARCH_GPU_HPP
+#define ML__ALGORITHM__Q_ARY_SEARCH_GPU_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ml {
+namespace algorithm {
+
+
+/// Default count of queries of one chunk of a batch, which
+/// 'q_ary_gpu_searcher' transfers to the GPU, searches, and transfers
+/// back at once.
+constexpr std::size_t q_ary_gpu_chunk_size = std::size_t( 1 ) << 22;
+
+/// Default count of chunks of 'q_ary_gpu_searcher', which are in flight at
+/// once (one per CUDA stream): while one is searched, the queries of the
+/// next one are transferred to the GPU, and the results of the previous
+/// one are transferred back.
+constexpr unsigned q_ary_gpu_stream_count = 3;
+
+/// Checks if a CUDA device is available to 'q_ary_gpu_searcher'.
+bool q_ary_gpu_available();
+
+
+/// Searcher of batches of queries on a GPU (by CUDA), for query sets far
+/// larger than the searched array, which are searched offline.
+/// The sorted array is uploaded once, as a static tree ('q_ary_static_tree')
+/// of nodes of 32 keys, so one node is as wide as a warp: every warp
+/// searches one query at a time, and one visit of a node is one Q-ary step
+/// with Q=33, whose 32 pivots are loaded by the lanes of the warp in one
+/// coalesced transaction, and compared with the query in parallel (the
+/// count of the lanes, whose pivot satisfies the predicate, by a ballot,
+/// is the child to descend to).
+/// A batch is split into chunks of 'chunk_size' queries, which are in
+/// flight on 'stream_count' streams at once, so the transfers of the
+/// queries and of the results overlap with the searches (the queries, and
+/// the results, are staged in page-locked buffers of the searcher).
+/// Results are ranks in the original sorted array. They are transferred
+/// back as 32-bit numbers, if the array is short enough.
+/// Searches of one searcher must not be run by several threads at once.
+/// Available when the library is built with 'Q_ARY_SEARCH_GPU' CMake option
+/// (which defines 'Q_ARY_SEARCH_HAVE_GPU'), for 'std::int32_t',
+/// 'std::uint32_t', 'std::int64_t', 'std::uint64_t', 'float' and 'double'
+/// keys (see "q_ary_search_gpu.cu").
+template< typename T >
+class q_ary_gpu_searcher
+{
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+
+	/// Count of keys, stored in one node of the uploaded tree: one per lane
+	/// of a warp.
+	static constexpr unsigned keys_per_node = 32;
+
+protected:
+	/// The uploaded tree, and the buffers and the streams of the chunks
+	/// (of the CUDA runtime, so defined in "q_ary_search_gpu.cu").
+	struct state;
+	std::unique_ptr< state > _state;
+	/// Length of the original array.
+	size_type _size = 0;
+
+public:
+	q_ary_gpu_searcher();
+
+	q_ary_gpu_searcher( const q_ary_gpu_searcher& ) = delete;
+	q_ary_gpu_searcher& operator=( const q_ary_gpu_searcher& ) = delete;
+
+	~q_ary_gpu_searcher();
+
+	/// Uploads sorted range [begin, end) to CUDA device 'device', and
+	/// allocates buffers of 'stream_count' chunks of 'chunk_size' queries.
+	/// Returns 'false', if the device can't be used, or has too little
+	/// memory.
+	bool open( const T* begin, const T* end,
+			int device = 0,
+			size_type chunk_size = q_ary_gpu_chunk_size,
+			unsigned stream_count = q_ary_gpu_stream_count );
+
+	/// Releases the device memory.
+	void close();
+
+	bool is_open() const
+		{ return _state != nullptr; }
+
+	/// Length of the original array.
+	size_type size() const
+		{ return _size; }
+
+	bool empty() const
+		{ return _size == 0; }
+
+	/// For every query 'q' of [queries_begin, queries_end), writes to 'out'
+	/// the rank of the first value, which is not less than 'q'.
+	/// Returns 'false' on an error of the device (then 'out' is
+	/// undefined).
+	bool lower_bound_batch( const T* queries_begin, const T* queries_end,
+			size_type* out );
+
+	/// The same, for the first value, which is greater than 'q'.
+	bool upper_bound_batch( const T* queries_begin, const T* queries_end,
+			size_type* out );
+
+	/// Returns the count of bytes of device memory, occupied by the
+	/// searcher (the tree, and the buffers of the chunks).
+	size_type device_memory_footprint() const;
+
+protected:
+	/// Searches the batch by chunks, by pipelining them over the streams.
+	template< bool Upper >
+	bool _search_batch( const T* queries_begin, const T* queries_end,
+			size_type* out );
+};
+
+extern template class q_ary_gpu_searcher< std::int32_t >;
+extern template class q_ary_gpu_searcher< std::uint32_t >;
+extern template class q_ary_gpu_searcher< std::int64_t >;
+extern template class q_ary_gpu_searcher< std::uint64_t >;
+extern template class q_ary_gpu_searcher< float >;
+extern template class q_ary_gpu_searcher< double >;
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_SEARCH_GPU_HPP
@@ -0,0 +1,70 @@
+
+/// Search kernels of one instruction set, for the dispatcher of
+/// "q_ary_search_dispatch.hpp".
+/// The build compiles this file once for every instruction set (see
+/// CMakeLists.txt), with:
+///  - the compiler flags, which enable the instruction set (e.g.
+///    '-mavx2 -mfma'), so "q_ary_search_simd.hpp" picks its kernels,
+///  - 'ML__ALGORITHM__Q_ARY_ISA_NAMESPACE' - the namespace of the
+///    algorithms, compiled for it (e.g. 'isa_avx2'),
+///  - 'ML__ALGORITHM__Q_ARY_KERNELS_ISA' - its name in 'q_ary_isa' (e.g.
+///    'avx2'), which also names the table of its kernels
+///    ('_q_ary_search_kernels_avx2').
+/// Only the kernels are exported, so nothing else of this file is called
+/// on a processor, which doesn't support its instruction set.
+
+#include "q_ary_search_dispatch.hpp"
+#include "q_ary_search.hpp"
+#include "q_ary_search_simd.hpp"
+#include "q_ary_search_batch.hpp"
+
+#if ! defined( ML__ALGORITHM__Q_ARY_KERNELS_ISA )
+#error "The instruction set of the kernels is not given."
+#endif
+
+#define _ML__ALGORITHM__Q_ARY_KERNELS_TABLE( isa ) _q_ary_search_kernels_ ## isa
+#define ML__ALGORITHM__Q_ARY_KERNELS_TABLE( isa ) _ML__ALGORITHM__Q_ARY_KERNELS_TABLE( isa )
+
+namespace ml {
+namespace algorithm {
+
+namespace {
+
+template< typename T >
+const T* _lower_bound( const T* begin, const T* end, T q )
+	{ return q_ary_lower_bound< q_ary_dispatched_q, q_ary_simd_step >( begin, end, q ); }
+
+template< typename T >
+const T* _upper_bound( const T* begin, const T* end, T q )
+	{ return q_ary_upper_bound< q_ary_dispatched_q, q_ary_simd_step >( begin, end, q ); }
+
+template< typename T >
+void _lower_bound_batch( const T* begin, const T* end,
+		const T* queries_begin, const T* queries_end, const T** out )
+	{ q_ary_lower_bound_batch< q_ary_dispatched_q, q_ary_simd_step >( begin, end,
+			queries_begin, queries_end, out ); }
+
+template< typename T >
+void _upper_bound_batch( const T* begin, const T* end,
+		const T* queries_begin, const T* queries_end, const T** out )
+	{ q_ary_upper_bound_batch< q_ary_dispatched_q, q_ary_simd_step >( begin, end,
+			queries_begin, queries_end, out ); }
+
+template< typename T >
+constexpr q_ary_search_kernel_set< T > _kernel_set()
+	{ return { &_lower_bound< T >, &_upper_bound< T >,
+			&_lower_bound_batch< T >, &_upper_bound_batch< T > }; }
+
+} // namespace
+
+extern const q_ary_search_kernels ML__ALGORITHM__Q_ARY_KERNELS_TABLE( ML__ALGORITHM__Q_ARY_KERNELS_ISA );
+
+const q_ary_search_kernels ML__ALGORITHM__Q_ARY_KERNELS_TABLE( ML__ALGORITHM__Q_ARY_KERNELS_ISA ) = {
+		q_ary_isa::ML__ALGORITHM__Q_ARY_KERNELS_ISA,
+		_kernel_set< std::int32_t >(),
+		_kernel_set< std::int64_t >(),
+		_kernel_set< float >(),
+		_kernel_set< double >() };
+
+} // namespace algorithm
+} // namespace ml
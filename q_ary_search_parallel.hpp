@@ -0,0 +1,321 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_SEARCH_PARALLEL_HPP
+#define ML__ALGORITHM__Q_ARY_SEARCH_PARALLEL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_search_batch.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Pool of threads, which runs bulks of independent tasks, with work
+/// stealing.
+/// Every thread owns a range of task indexes, packed in one atomic word:
+/// the owner takes tasks from its front, while a thread which ran out of
+/// tasks steals the back half of another's range. Both are single
+/// compare-and-swap operations, so no locks are taken while tasks run.
+/// The thread calling 'run()' participates as well.
+class q_ary_thread_pool
+{
+protected:
+	/// Range of task indexes [lo, hi), owned by one thread: 'lo' in the
+	/// lower half of the word, 'hi' in the upper one.
+	/// Every range is on its own cache line.
+	struct alignas( 64 ) range_t {
+		std::atomic< std::uint64_t > _range;
+	};
+
+	static std::uint64_t _pack( std::uint32_t lo, std::uint32_t hi )
+		{ return ((std::uint64_t)hi << 32) | lo; }
+	static std::uint32_t _lo( std::uint64_t range )
+		{ return (std::uint32_t)range; }
+	static std::uint32_t _hi( std::uint64_t range )
+		{ return (std::uint32_t)(range >> 32); }
+
+	std::vector< std::thread > _threads;
+	std::unique_ptr< range_t[] > _ranges;  // One per thread, plus the caller's one
+	std::function< void( std::size_t ) > _task;
+	// Synchronization of runs
+	std::mutex _run_mutex;  // Serializes concurrent calls of 'run()'
+	std::mutex _mutex;
+	std::condition_variable _start_cv, _done_cv;
+	std::size_t _generation = 0;
+	unsigned _active = 0;
+	bool _stop = false;
+
+public:
+	/// Starts the pool, so that 'run()' executes tasks on
+	/// 'concurrency' threads (including the calling one).
+	explicit q_ary_thread_pool(
+			unsigned concurrency = std::thread::hardware_concurrency() )
+	{
+		if ( concurrency == 0 )
+			concurrency = 1;
+		_ranges.reset( new range_t[ concurrency ] );
+		for ( unsigned w = 0; w < concurrency; ++w )
+			_ranges[ w ]._range.store( 0, std::memory_order_relaxed );
+		for ( unsigned w = 1; w < concurrency; ++w )
+			_threads.emplace_back( [this, w]() { _worker_loop( w ); } );
+	}
+
+	q_ary_thread_pool( const q_ary_thread_pool& ) = delete;
+	q_ary_thread_pool& operator=( const q_ary_thread_pool& ) = delete;
+
+	~q_ary_thread_pool()
+	{
+		{
+			std::lock_guard< std::mutex > lock( _mutex );
+			_stop = true;
+		}
+		_start_cv.notify_all();
+		for ( std::thread& thread : _threads )
+			thread.join();
+	}
+
+	/// Count of threads, on which tasks are run (including the caller).
+	unsigned concurrency() const
+		{ return (unsigned)_threads.size() + 1; }
+
+	/// Calls 'task(i)' for every 'i' in [0, count), distributed over
+	/// all the threads, and returns once all of them are finished.
+	/// Tasks must not throw.
+	template< typename TaskT >
+	void run( std::size_t count, TaskT task )
+	{
+		if ( count == 0 )
+			return;
+		assert( count <= UINT32_MAX );
+		std::lock_guard< std::mutex > run_lock( _run_mutex );
+		// Initial, even distribution of the tasks
+		const unsigned n = concurrency();
+		for ( unsigned w = 0; w < n; ++w )
+			_ranges[ w ]._range.store( _pack(
+					(std::uint32_t)(count * w / n),
+					(std::uint32_t)(count * (w + 1) / n) ),
+				std::memory_order_relaxed );
+		_task = std::ref( task );
+		{
+			std::lock_guard< std::mutex > lock( _mutex );
+			++_generation;
+			_active = n - 1;
+		}
+		_start_cv.notify_all();
+		_work( 0 );
+		std::unique_lock< std::mutex > lock( _mutex );
+		_done_cv.wait( lock, [this]() { return _active == 0; } );
+		_task = nullptr;
+	}
+
+protected:
+	void _worker_loop( unsigned w )
+	{
+		std::size_t generation = 0;
+		for ( ;; ) {
+			{
+				std::unique_lock< std::mutex > lock( _mutex );
+				_start_cv.wait( lock, [&]() { return _stop || _generation != generation; } );
+				if ( _stop )
+					return;
+				generation = _generation;
+			}
+			_work( w );
+			{
+				std::lock_guard< std::mutex > lock( _mutex );
+				--_active;
+			}
+			_done_cv.notify_one();
+		}
+	}
+
+	/// Runs tasks of thread 'w', and the stolen ones, while there are any.
+	void _work( unsigned w )
+	{
+		std::uint32_t i;
+		do {
+			while ( _pop( w, i ) )
+				_task( i );
+		} while ( _steal( w ) );
+	}
+
+	/// Takes the first task of thread 'w'.
+	bool _pop( unsigned w, std::uint32_t& i )
+	{
+		std::atomic< std::uint64_t >& range = _ranges[ w ]._range;
+		std::uint64_t current = range.load( std::memory_order_acquire );
+		while ( _lo( current ) < _hi( current ) ) {
+			if ( range.compare_exchange_weak( current,
+					_pack( _lo( current ) + 1, _hi( current ) ),
+					std::memory_order_acq_rel, std::memory_order_acquire ) ) {
+				i = _lo( current );
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// Moves the back half of some other thread's tasks to thread 'w'
+	/// (whose own range is empty).
+	bool _steal( unsigned w )
+	{
+		const unsigned n = concurrency();
+		for ( unsigned d = 1; d < n; ++d ) {
+			std::atomic< std::uint64_t >& victim = _ranges[ (w + d) % n ]._range;
+			std::uint64_t current = victim.load( std::memory_order_acquire );
+			while ( _lo( current ) < _hi( current ) ) {
+				const std::uint32_t half = (_hi( current ) - _lo( current ) + 1) / 2;
+				const std::uint32_t middle = _hi( current ) - half;
+				if ( victim.compare_exchange_weak( current,
+						_pack( _lo( current ), middle ),
+						std::memory_order_acq_rel, std::memory_order_acquire ) ) {
+					_ranges[ w ]._range.store( _pack( middle, _hi( current ) ),
+							std::memory_order_release );
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+};
+
+
+/// The pool, used by default-constructed 'q_ary_parallel_executor',
+/// with 'std::thread::hardware_concurrency()' threads.
+inline q_ary_thread_pool& q_ary_default_thread_pool()
+{
+	static q_ary_thread_pool pool;
+	return pool;
+}
+
+
+/// Executor, which runs all the chunks of a batch on the calling thread,
+/// one after another.
+struct q_ary_sequential_executor {
+	template< typename TaskT >
+	void bulk( std::size_t count, TaskT task ) const
+		{ for ( std::size_t i = 0; i < count; ++i )
+			task( i ); }
+};
+
+/// Executor, which runs chunks of a batch on a 'q_ary_thread_pool'.
+struct q_ary_parallel_executor {
+	q_ary_thread_pool* _pool;
+	/// Count of queries in one chunk.
+	std::size_t _chunk_size;
+
+	explicit q_ary_parallel_executor(
+			q_ary_thread_pool& pool = q_ary_default_thread_pool(),
+			std::size_t chunk_size = 16 * 1024 )
+		: _pool( &pool ), _chunk_size( chunk_size )
+		{}
+
+	template< typename TaskT >
+	void bulk( std::size_t count, TaskT task ) const
+		{ _pool->run( count, task ); }
+};
+
+/// Count of queries in one chunk, which executor 'ExecutorT' prefers.
+template< typename ExecutorT >
+inline std::size_t _q_ary_chunk_size( const ExecutorT& )
+	{ return 16 * 1024; }
+
+inline std::size_t _q_ary_chunk_size( const q_ary_parallel_executor& executor )
+	{ return executor._chunk_size; }
+
+
+/// Q-ary search of a batch of queries [queries_begin, queries_end) in
+/// sorted range [begin, end), split into chunks, which are run by
+/// 'executor' (e.g. in parallel, by 'q_ary_parallel_executor').
+/// Every chunk is searched by 'q_ary_search_batch< Q, StepT, G >()', and
+/// writes its results directly to its part of the output 'out' (a random
+/// access iterator, e.g. pointer to the caller's array). Borders of
+/// chunks are aligned to cache lines of the output, so that threads
+/// never write to the same cache line.
+/// Returns the end of the output.
+template< unsigned Q, typename StepT = q_ary_branchless_step,
+		unsigned G = q_ary_batch_group_size,
+		typename ExecutorT, typename RanIt, typename QueryIt, typename OutIt,
+		typename PredT >
+inline OutIt q_ary_search_batch(
+		const ExecutorT& executor,
+		RanIt begin, RanIt end,
+		QueryIt queries_begin, QueryIt queries_end,
+		OutIt out,
+		PredT pred )
+{
+	const std::size_t count = (std::size_t)(queries_end - queries_begin);
+	if ( count == 0 )
+		return out;
+	// Chunks, whose borders are at cache line borders of the output
+	typedef typename std::remove_reference< decltype( *out ) >::type out_t;
+	const std::size_t line = 64 / sizeof(out_t) ? 64 / sizeof(out_t) : 1;
+	std::size_t chunk_size = _q_ary_chunk_size( executor );
+	chunk_size = (chunk_size + line - 1) / line * line;
+	std::size_t head = 0;  // Length of the first chunk, up to the first line border
+	if constexpr ( std::is_lvalue_reference< decltype( *out ) >::value ) {
+		const std::uintptr_t address = (std::uintptr_t)std::addressof( *out );
+		if ( 64 % sizeof(out_t) == 0 && address % sizeof(out_t) == 0 )
+			head = (64 - address % 64) % 64 / sizeof(out_t);
+	}
+	if ( head > count )
+		head = count;
+	const std::size_t chunk_count = (head > 0 ? 1 : 0)
+			+ (count - head + chunk_size - 1) / chunk_size;
+	executor.bulk( chunk_count, [&]( std::size_t i ) {
+		std::size_t first = 0, last = head;
+		if ( head == 0 || i > 0 ) {
+			first = head + (head > 0 ? i - 1 : i) * chunk_size;
+			last = first + chunk_size < count ? first + chunk_size : count;
+		}
+		q_ary_search_batch< Q, StepT, G >( begin, end,
+				queries_begin + first, queries_begin + last,
+				out + first, pred );
+	} );
+	return out + count;
+}
+
+template< unsigned Q, typename StepT = q_ary_branchless_step,
+		unsigned G = q_ary_batch_group_size,
+		typename ExecutorT, typename RanIt, typename QueryIt, typename OutIt >
+inline OutIt q_ary_lower_bound_batch(
+		const ExecutorT& executor,
+		RanIt begin, RanIt end,
+		QueryIt queries_begin, QueryIt queries_end,
+		OutIt out )
+{
+	typedef typename std::iterator_traits< QueryIt >::value_type query_t;
+	return q_ary_search_batch< Q, StepT, G >( executor, begin, end,
+			queries_begin, queries_end, out, std::less< query_t >() );
+}
+
+template< unsigned Q, typename StepT = q_ary_branchless_step,
+		unsigned G = q_ary_batch_group_size,
+		typename ExecutorT, typename RanIt, typename QueryIt, typename OutIt >
+inline OutIt q_ary_upper_bound_batch(
+		const ExecutorT& executor,
+		RanIt begin, RanIt end,
+		QueryIt queries_begin, QueryIt queries_end,
+		OutIt out )
+{
+	typedef typename std::iterator_traits< QueryIt >::value_type query_t;
+	return q_ary_search_batch< Q, StepT, G >( executor, begin, end,
+			queries_begin, queries_end, out, std::less_equal< query_t >() );
+}
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_SEARCH_PARALLEL_HPP
@@ -0,0 +1,239 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_SEARCH_SCHEDULE_HPP
+#define ML__ALGORITHM__Q_ARY_SEARCH_SCHEDULE_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+#include "q_ary_search.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Divider of 32-bit lengths by a divisor, which is known only at run
+/// time, by a multiplication and a shift, instead of a 'div' instruction
+/// (as libdivide does): 'n / d == (n * m) >> 64', where 'm = ceil(2^64 / d)',
+/// for all the 32-bit 'n', and 'd >= 2'.
+class q_ary_divider
+{
+protected:
+	std::uint64_t _multiplier;
+	length_t _divisor;
+
+public:
+	explicit q_ary_divider( length_t divisor )
+		: _multiplier( std::numeric_limits< std::uint64_t >::max() / divisor + 1 ),
+		  _divisor( divisor )
+		{ assert( divisor >= 2 ); }
+
+	length_t divisor() const
+		{ return _divisor; }
+
+	/// Returns 'n / divisor()'.
+	length_t divide( length_t n ) const
+	{
+#if defined( __SIZEOF_INT128__ )
+		return (length_t)(((unsigned __int128)_multiplier * n) >> 64);
+#else
+		// High half of the 96-bit product, by 32-bit halves of the multiplier
+		const std::uint64_t low = (_multiplier & 0xFFFFFFFFu) * n;
+		const std::uint64_t high = (_multiplier >> 32) * n + (low >> 32);
+		return (length_t)(high >> 32);
+#endif
+	}
+};
+
+
+/// Precomputed schedule of a Q-ary search over ranges of (fixed) length
+/// 'length': the range length and the fragment length of every step, and
+/// the length of the final linear search.
+/// Every step dives into a range as long as the last (the longest)
+/// fragment, which contains the searched position in whichever fragment
+/// it is, so the lengths don't depend on the query, and the search becomes
+/// a loop with fixed trip count, whose divisions are all done up front,
+/// and no longer are on the critical path of the loop.
+/// It also serves searches with 'Q' known only at run time
+/// ('q_ary_dynamic_search()').
+class q_ary_search_schedule
+{
+public:
+	/// Maximal count of steps (enough for any 32-bit length).
+	static constexpr unsigned max_levels = 64;
+
+protected:
+	length_t _q = 0;
+	length_t _length = 0;
+	unsigned _levels = 0;
+	length_t _lengths[ max_levels ] = {};
+	length_t _fragment_lengths[ max_levels ] = {};
+	length_t _final_length = 0;
+
+public:
+	q_ary_search_schedule() = default;
+
+	/// Schedule of a search with partitioning into 'q' fragments, over
+	/// ranges of 'length' values, which switches to linear search below
+	/// 'to_linear_threshold' values.
+	q_ary_search_schedule( length_t q, length_t length, length_t to_linear_threshold )
+		: _q( q ), _length( length )
+	{
+		assert( q >= 2 );
+		const q_ary_divider divider( q );
+		while ( length >= to_linear_threshold ) {
+			const length_t fragment_length = divider.divide( length );
+			if ( fragment_length == 0 )
+				break;
+			assert( _levels < max_levels );
+			_lengths[ _levels ] = length;
+			_fragment_lengths[ _levels ] = fragment_length;
+			++_levels;
+			length -= (q - 1) * fragment_length;
+		}
+		_final_length = length;
+	}
+
+	/// Schedule of 'q_ary_search< Q >()' over ranges of 'length' values,
+	/// with parameters 'params'.
+	template< unsigned Q, typename ParamsT = q_ary_default_parameters< Q > >
+	static q_ary_search_schedule make( length_t length, const ParamsT& params = ParamsT() )
+		{ return q_ary_search_schedule( Q, length, params.to_linear_threshold() ); }
+
+	/// Count of fragments of every step.
+	length_t q() const
+		{ return _q; }
+
+	/// Length of the ranges, this schedule is for.
+	length_t length() const
+		{ return _length; }
+
+	/// Count of steps.
+	unsigned levels() const
+		{ return _levels; }
+
+	/// Range length of step 'level'.
+	length_t length( unsigned level ) const
+		{ return _lengths[ level ]; }
+
+	/// Fragment length of step 'level'.
+	length_t fragment_length( unsigned level ) const
+		{ return _fragment_lengths[ level ]; }
+
+	/// Length of the final linear search.
+	length_t final_length() const
+		{ return _final_length; }
+};
+
+
+/// Q-ary search in range [begin, begin + schedule.length()), by steps
+/// of precomputed 'schedule' (see 'q_ary_search_schedule'), which must
+/// have been made for 'Q'.
+/// Returns the first position 'it' in that range, on which 'pred(*it, q)'
+/// is not satisfied.
+template< unsigned Q, typename StepT = q_ary_branchy_step,
+		typename RanIt, typename ValueT, typename PredT >
+inline RanIt q_ary_search(
+		const q_ary_search_schedule& schedule,
+		RanIt begin,
+		const ValueT& q,
+		PredT pred )
+{
+	assert( schedule.q() == Q );
+	const unsigned levels = schedule.levels();
+	for ( unsigned level = 0; level < levels; ++level ) {
+		// The resulting length is the one of the next level
+		length_t length = schedule.length( level );
+		StepT::template step< Q >(
+				begin, length, schedule.fragment_length( level ), q, pred );
+	}
+	return StepT::finish( begin, schedule.final_length(), q, pred );
+}
+
+
+/// Evaluates one step of Q-ary search with 'Q' known only at run time:
+/// counts the satisfied pivots among all the Q-1 ones, and advances
+/// 'begin' by that count of fragments.
+template< typename RanIt, typename ValueT, typename PredT >
+inline void _q_ary_dynamic_step(
+		RanIt& begin, length_t& length,
+		length_t fragment_length,
+		length_t q_count,
+		const ValueT& q,
+		PredT& pred )
+{
+	length_t count = 0;
+	for ( length_t k = 1; k < q_count; ++k )
+		count += (length_t)pred( *(begin + k * fragment_length), q );
+	begin += count * fragment_length;
+	// The last fragment is longer than the others
+	length = (count == q_count - 1)
+			? length - (q_count - 1) * fragment_length
+			: fragment_length;
+}
+
+/// Q-ary search with 'Q' known only at run time (e.g. chosen by a
+/// profile), given by 'divider', so fragment lengths are computed by
+/// multiplications instead of divisions.
+/// Switches to linear search below 'to_linear_threshold' values.
+/// Returns the first position 'it' in the range [begin, end),
+/// on which 'pred(*it, q)' is not satisfied.
+template< typename RanIt, typename ValueT, typename PredT >
+inline RanIt q_ary_dynamic_search(
+		const q_ary_divider& divider,
+		length_t to_linear_threshold,
+		RanIt begin, RanIt end,
+		const ValueT& q,
+		PredT pred )
+{
+	typedef q_ary_length_t< RanIt > wide_length_t;
+	const length_t q_count = divider.divisor();
+	if ( to_linear_threshold < q_count )
+		to_linear_threshold = q_count;  // So fragments are never empty
+	// Work with {begin, length}, not with [begin, end)
+	wide_length_t wide_length = (wide_length_t)(end - begin);
+	if constexpr ( sizeof(wide_length_t) > sizeof(length_t) ) {
+		// Ranges which don't fit in 32 bits, by ordinary divisions
+		while ( wide_length > std::numeric_limits< length_t >::max() ) {
+			const wide_length_t fragment_length = wide_length / q_count;
+			wide_length_t count = 0;
+			for ( length_t k = 1; k < q_count; ++k )
+				count += (wide_length_t)pred( *(begin + k * fragment_length), q );
+			begin += count * fragment_length;
+			wide_length = (count == q_count - 1)
+					? wide_length - (q_count - 1) * fragment_length
+					: fragment_length;
+		}
+	}
+	length_t length = (length_t)wide_length;
+	while ( length >= to_linear_threshold )
+		_q_ary_dynamic_step( begin, length, divider.divide( length ), q_count, q, pred );
+	return _q_ary_linear_search( begin, length, q, pred );
+}
+
+/// Q-ary search with 'Q' known only at run time, in range
+/// [begin, begin + schedule.length()), by steps of precomputed 'schedule'.
+/// Returns the first position 'it' in that range, on which 'pred(*it, q)'
+/// is not satisfied.
+template< typename RanIt, typename ValueT, typename PredT >
+inline RanIt q_ary_dynamic_search(
+		const q_ary_search_schedule& schedule,
+		RanIt begin,
+		const ValueT& q,
+		PredT pred )
+{
+	const length_t q_count = schedule.q();
+	const unsigned levels = schedule.levels();
+	for ( unsigned level = 0; level < levels; ++level ) {
+		length_t length = schedule.length( level );
+		_q_ary_dynamic_step( begin, length, schedule.fragment_length( level ),
+				q_count, q, pred );
+	}
+	return _q_ary_linear_search( begin, schedule.final_length(), q, pred );
+}
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_SEARCH_SCHEDULE_HPP
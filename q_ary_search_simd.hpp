@@ -0,0 +1,911 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_SEARCH_SIMD_HPP
+#define ML__ALGORITHM__Q_ARY_SEARCH_SIMD_HPP
+
+#include <cstdint>
+#include <climits>
+#include <type_traits>
+
+#if defined( __AVX512F__ ) || defined( __AVX2__ ) || defined( __SSE2__ )
+#include <immintrin.h>
+#elif defined( __ARM_NEON ) && defined( __aarch64__ )
+#include <arm_neon.h>
+#endif
+
+#include "q_ary_search.hpp"
+
+namespace ml {
+namespace algorithm {
+inline namespace ML__ALGORITHM__Q_ARY_ISA_NAMESPACE {
+
+
+/// Vector operations on values of type 'V', for the widest instruction
+/// set enabled by the compiler flags (AVX-512, AVX2, SSE2/SSE4.2 or NEON).
+/// Types for which there is no such set have 'enabled' equal to false,
+/// and SIMD kernels fall back to the generic code for them.
+/// Every specialization provides:
+///  - 'lanes' - count of values in one vector,
+///  - 'broadcast(q)' - vector with all the lanes equal to 'q',
+///  - 'load(p)' - unaligned load of 'lanes' consecutive values,
+///  - 'load_partial(p, n)' - load of the first 'n' (in [1, lanes))
+///        consecutive values, which doesn't touch memory past 'p + n';
+///        the remaining lanes are unspecified,
+///  - 'gather(p, stride, n)' - load of values 'p[k*stride]', for 'k' in
+///        [0, n); the remaining lanes repeat the last one,
+///  - 'mask< Strict >(x, q)' - bitmask of lanes where 'x < q'
+///        (or 'x <= q', when not 'Strict').
+template< typename V >
+struct _q_ary_simd_ops {
+	static constexpr bool enabled = false;
+};
+
+
+/// Scalar gather into a temporary buffer, for instruction sets
+/// having no gather instruction (or when indexes don't fit in 32 bits).
+template< typename Ops, typename V >
+inline typename Ops::vec_t _q_ary_simd_scalar_gather(
+		const V* p, length_t stride, unsigned n )
+{
+	alignas( 64 ) V buffer[ Ops::lanes ];
+	for ( unsigned k = 0; k < Ops::lanes; ++k )
+		buffer[ k ] = p[ (k < n ? k : n - 1) * stride ];
+	return Ops::load( buffer );
+}
+
+
+/// Scalar partial load into a temporary buffer, for instruction sets
+/// having no masked load instruction.
+template< typename Ops, typename V >
+inline typename Ops::vec_t _q_ary_simd_scalar_load_partial(
+		const V* p, unsigned n )
+{
+	alignas( 64 ) V buffer[ Ops::lanes ];
+	for ( unsigned k = 0; k < Ops::lanes; ++k )
+		buffer[ k ] = p[ k < n ? k : n - 1 ];
+	return Ops::load( buffer );
+}
+
+
+#if defined( __AVX512F__ )
+
+template<>
+struct _q_ary_simd_ops< std::int32_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 16;
+	typedef __m512i vec_t;
+	static inline vec_t broadcast( std::int32_t q )
+		{ return _mm512_set1_epi32( q ); }
+	static inline vec_t load( const std::int32_t* p )
+		{ return _mm512_loadu_si512( p ); }
+	static inline vec_t load_partial( const std::int32_t* p, unsigned n )
+		{ return _mm512_maskz_loadu_epi32( (__mmask16)((1u << n) - 1), p ); }
+	static inline vec_t gather( const std::int32_t* p, length_t stride, unsigned n ) {
+		if ( stride > INT_MAX / lanes )
+			return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n );
+		const __m512i k = _mm512_min_epi32(
+				_mm512_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ),
+				_mm512_set1_epi32( (int)n - 1 ) );
+		return _mm512_i32gather_epi32(
+				_mm512_mullo_epi32( k, _mm512_set1_epi32( (int)stride ) ), p, 4 );
+	}
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		return Strict ? _mm512_cmplt_epi32_mask( x, q )
+				: _mm512_cmple_epi32_mask( x, q );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< std::int64_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 8;
+	typedef __m512i vec_t;
+	static inline vec_t broadcast( std::int64_t q )
+		{ return _mm512_set1_epi64( q ); }
+	static inline vec_t load( const std::int64_t* p )
+		{ return _mm512_loadu_si512( p ); }
+	static inline vec_t load_partial( const std::int64_t* p, unsigned n )
+		{ return _mm512_maskz_loadu_epi64( (__mmask8)((1u << n) - 1), p ); }
+	static inline vec_t gather( const std::int64_t* p, length_t stride, unsigned n ) {
+		const __m512i k = _mm512_min_epi64(
+				_mm512_setr_epi64( 0, 1, 2, 3, 4, 5, 6, 7 ),
+				_mm512_set1_epi64( (long long)n - 1 ) );
+		return _mm512_i64gather_epi64(
+				_mm512_mullox_epi64( k, _mm512_set1_epi64( stride ) ), p, 8 );
+	}
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		return Strict ? _mm512_cmplt_epi64_mask( x, q )
+				: _mm512_cmple_epi64_mask( x, q );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< float > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 16;
+	typedef __m512 vec_t;
+	static inline vec_t broadcast( float q )
+		{ return _mm512_set1_ps( q ); }
+	static inline vec_t load( const float* p )
+		{ return _mm512_loadu_ps( p ); }
+	static inline vec_t load_partial( const float* p, unsigned n )
+		{ return _mm512_maskz_loadu_ps( (__mmask16)((1u << n) - 1), p ); }
+	static inline vec_t gather( const float* p, length_t stride, unsigned n ) {
+		if ( stride > INT_MAX / lanes )
+			return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n );
+		const __m512i k = _mm512_min_epi32(
+				_mm512_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ),
+				_mm512_set1_epi32( (int)n - 1 ) );
+		return _mm512_i32gather_ps(
+				_mm512_mullo_epi32( k, _mm512_set1_epi32( (int)stride ) ), p, 4 );
+	}
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		return Strict ? _mm512_cmp_ps_mask( x, q, _CMP_LT_OQ )
+				: _mm512_cmp_ps_mask( x, q, _CMP_LE_OQ );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< double > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 8;
+	typedef __m512d vec_t;
+	static inline vec_t broadcast( double q )
+		{ return _mm512_set1_pd( q ); }
+	static inline vec_t load( const double* p )
+		{ return _mm512_loadu_pd( p ); }
+	static inline vec_t load_partial( const double* p, unsigned n )
+		{ return _mm512_maskz_loadu_pd( (__mmask8)((1u << n) - 1), p ); }
+	static inline vec_t gather( const double* p, length_t stride, unsigned n ) {
+		const __m512i k = _mm512_min_epi64(
+				_mm512_setr_epi64( 0, 1, 2, 3, 4, 5, 6, 7 ),
+				_mm512_set1_epi64( (long long)n - 1 ) );
+		return _mm512_i64gather_pd(
+				_mm512_mullox_epi64( k, _mm512_set1_epi64( stride ) ), p, 8 );
+	}
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		return Strict ? _mm512_cmp_pd_mask( x, q, _CMP_LT_OQ )
+				: _mm512_cmp_pd_mask( x, q, _CMP_LE_OQ );
+	}
+};
+
+#elif defined( __AVX2__ )
+
+template<>
+struct _q_ary_simd_ops< std::int32_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 8;
+	typedef __m256i vec_t;
+	static inline vec_t broadcast( std::int32_t q )
+		{ return _mm256_set1_epi32( q ); }
+	static inline vec_t load( const std::int32_t* p )
+		{ return _mm256_loadu_si256( (const __m256i*)p ); }
+	static inline vec_t load_partial( const std::int32_t* p, unsigned n )
+		{ return _mm256_maskload_epi32( (const int*)p, _mm256_cmpgt_epi32(
+				_mm256_set1_epi32( (int)n ), _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ) ) ); }
+	static inline vec_t gather( const std::int32_t* p, length_t stride, unsigned n ) {
+		if ( stride > INT_MAX / lanes )
+			return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n );
+		const __m256i k = _mm256_min_epi32(
+				_mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ),
+				_mm256_set1_epi32( (int)n - 1 ) );
+		return _mm256_i32gather_epi32( (const int*)p,
+				_mm256_mullo_epi32( k, _mm256_set1_epi32( (int)stride ) ), 4 );
+	}
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		const __m256i result = Strict ? _mm256_cmpgt_epi32( q, x )
+				: _mm256_xor_si256( _mm256_cmpgt_epi32( x, q ), _mm256_set1_epi32( -1 ) );
+		return (unsigned)_mm256_movemask_ps( _mm256_castsi256_ps( result ) );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< std::int64_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 4;
+	typedef __m256i vec_t;
+	static inline vec_t broadcast( std::int64_t q )
+		{ return _mm256_set1_epi64x( q ); }
+	static inline vec_t load( const std::int64_t* p )
+		{ return _mm256_loadu_si256( (const __m256i*)p ); }
+	static inline vec_t load_partial( const std::int64_t* p, unsigned n )
+		{ return _mm256_maskload_epi64( (const long long*)p, _mm256_cmpgt_epi64(
+				_mm256_set1_epi64x( n ), _mm256_setr_epi64x( 0, 1, 2, 3 ) ) ); }
+	static inline vec_t gather( const std::int64_t* p, length_t stride, unsigned n ) {
+		const long long s = stride;
+		return _mm256_i64gather_epi64( (const long long*)p, _mm256_setr_epi64x(
+				0, (n > 1 ? 1 : n - 1) * s, (n > 2 ? 2 : n - 1) * s, (n > 3 ? 3 : n - 1) * s ), 8 );
+	}
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		const __m256i result = Strict ? _mm256_cmpgt_epi64( q, x )
+				: _mm256_xor_si256( _mm256_cmpgt_epi64( x, q ), _mm256_set1_epi64x( -1 ) );
+		return (unsigned)_mm256_movemask_pd( _mm256_castsi256_pd( result ) );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< float > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 8;
+	typedef __m256 vec_t;
+	static inline vec_t broadcast( float q )
+		{ return _mm256_set1_ps( q ); }
+	static inline vec_t load( const float* p )
+		{ return _mm256_loadu_ps( p ); }
+	static inline vec_t load_partial( const float* p, unsigned n )
+		{ return _mm256_maskload_ps( p, _mm256_cmpgt_epi32(
+				_mm256_set1_epi32( (int)n ), _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ) ) ); }
+	static inline vec_t gather( const float* p, length_t stride, unsigned n ) {
+		if ( stride > INT_MAX / lanes )
+			return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n );
+		const __m256i k = _mm256_min_epi32(
+				_mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ),
+				_mm256_set1_epi32( (int)n - 1 ) );
+		return _mm256_i32gather_ps( p,
+				_mm256_mullo_epi32( k, _mm256_set1_epi32( (int)stride ) ), 4 );
+	}
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		return (unsigned)_mm256_movemask_ps( Strict ? _mm256_cmp_ps( x, q, _CMP_LT_OQ )
+				: _mm256_cmp_ps( x, q, _CMP_LE_OQ ) );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< double > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 4;
+	typedef __m256d vec_t;
+	static inline vec_t broadcast( double q )
+		{ return _mm256_set1_pd( q ); }
+	static inline vec_t load( const double* p )
+		{ return _mm256_loadu_pd( p ); }
+	static inline vec_t load_partial( const double* p, unsigned n )
+		{ return _mm256_maskload_pd( p, _mm256_cmpgt_epi64(
+				_mm256_set1_epi64x( n ), _mm256_setr_epi64x( 0, 1, 2, 3 ) ) ); }
+	static inline vec_t gather( const double* p, length_t stride, unsigned n ) {
+		const long long s = stride;
+		return _mm256_i64gather_pd( p, _mm256_setr_epi64x(
+				0, (n > 1 ? 1 : n - 1) * s, (n > 2 ? 2 : n - 1) * s, (n > 3 ? 3 : n - 1) * s ), 8 );
+	}
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		return (unsigned)_mm256_movemask_pd( Strict ? _mm256_cmp_pd( x, q, _CMP_LT_OQ )
+				: _mm256_cmp_pd( x, q, _CMP_LE_OQ ) );
+	}
+};
+
+#elif defined( __SSE2__ )
+
+template<>
+struct _q_ary_simd_ops< std::int32_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 4;
+	typedef __m128i vec_t;
+	static inline vec_t broadcast( std::int32_t q )
+		{ return _mm_set1_epi32( q ); }
+	static inline vec_t load( const std::int32_t* p )
+		{ return _mm_loadu_si128( (const __m128i*)p ); }
+	static inline vec_t load_partial( const std::int32_t* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const std::int32_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		const __m128i result = Strict ? _mm_cmpgt_epi32( q, x )
+				: _mm_xor_si128( _mm_cmpgt_epi32( x, q ), _mm_set1_epi32( -1 ) );
+		return (unsigned)_mm_movemask_ps( _mm_castsi128_ps( result ) );
+	}
+};
+
+#if defined( __SSE4_2__ )
+template<>
+struct _q_ary_simd_ops< std::int64_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 2;
+	typedef __m128i vec_t;
+	static inline vec_t broadcast( std::int64_t q )
+		{ return _mm_set1_epi64x( q ); }
+	static inline vec_t load( const std::int64_t* p )
+		{ return _mm_loadu_si128( (const __m128i*)p ); }
+	static inline vec_t load_partial( const std::int64_t* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const std::int64_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		const __m128i result = Strict ? _mm_cmpgt_epi64( q, x )
+				: _mm_xor_si128( _mm_cmpgt_epi64( x, q ), _mm_set1_epi32( -1 ) );
+		return (unsigned)_mm_movemask_pd( _mm_castsi128_pd( result ) );
+	}
+};
+#endif
+
+template<>
+struct _q_ary_simd_ops< float > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 4;
+	typedef __m128 vec_t;
+	static inline vec_t broadcast( float q )
+		{ return _mm_set1_ps( q ); }
+	static inline vec_t load( const float* p )
+		{ return _mm_loadu_ps( p ); }
+	static inline vec_t load_partial( const float* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const float* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		return (unsigned)_mm_movemask_ps( Strict ? _mm_cmplt_ps( x, q )
+				: _mm_cmple_ps( x, q ) );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< double > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 2;
+	typedef __m128d vec_t;
+	static inline vec_t broadcast( double q )
+		{ return _mm_set1_pd( q ); }
+	static inline vec_t load( const double* p )
+		{ return _mm_loadu_pd( p ); }
+	static inline vec_t load_partial( const double* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const double* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		return (unsigned)_mm_movemask_pd( Strict ? _mm_cmplt_pd( x, q )
+				: _mm_cmple_pd( x, q ) );
+	}
+};
+
+#elif defined( __ARM_NEON ) && defined( __aarch64__ )
+
+template<>
+struct _q_ary_simd_ops< std::int32_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 4;
+	typedef int32x4_t vec_t;
+	static inline vec_t broadcast( std::int32_t q )
+		{ return vdupq_n_s32( q ); }
+	static inline vec_t load( const std::int32_t* p )
+		{ return vld1q_s32( p ); }
+	static inline vec_t load_partial( const std::int32_t* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const std::int32_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		static const uint32_t bits[ 4 ] = { 1, 2, 4, 8 };
+		const uint32x4_t result = Strict ? vcltq_s32( x, q ) : vcleq_s32( x, q );
+		return vaddvq_u32( vandq_u32( result, vld1q_u32( bits ) ) );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< std::int64_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 2;
+	typedef int64x2_t vec_t;
+	static inline vec_t broadcast( std::int64_t q )
+		{ return vdupq_n_s64( q ); }
+	static inline vec_t load( const std::int64_t* p )
+		{ return vld1q_s64( p ); }
+	static inline vec_t load_partial( const std::int64_t* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const std::int64_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		static const uint64_t bits[ 2 ] = { 1, 2 };
+		const uint64x2_t result = Strict ? vcltq_s64( x, q ) : vcleq_s64( x, q );
+		return (unsigned)vaddvq_u64( vandq_u64( result, vld1q_u64( bits ) ) );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< float > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 4;
+	typedef float32x4_t vec_t;
+	static inline vec_t broadcast( float q )
+		{ return vdupq_n_f32( q ); }
+	static inline vec_t load( const float* p )
+		{ return vld1q_f32( p ); }
+	static inline vec_t load_partial( const float* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const float* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		static const uint32_t bits[ 4 ] = { 1, 2, 4, 8 };
+		const uint32x4_t result = Strict ? vcltq_f32( x, q ) : vcleq_f32( x, q );
+		return vaddvq_u32( vandq_u32( result, vld1q_u32( bits ) ) );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< double > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 2;
+	typedef float64x2_t vec_t;
+	static inline vec_t broadcast( double q )
+		{ return vdupq_n_f64( q ); }
+	static inline vec_t load( const double* p )
+		{ return vld1q_f64( p ); }
+	static inline vec_t load_partial( const double* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const double* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		static const uint64_t bits[ 2 ] = { 1, 2 };
+		const uint64x2_t result = Strict ? vcltq_f64( x, q ) : vcleq_f64( x, q );
+		return (unsigned)vaddvq_u64( vandq_u64( result, vld1q_u64( bits ) ) );
+	}
+};
+
+#endif
+
+
+/// Narrow integers (e.g. the deltas of 'q_ary_compressed_blocks'), of at
+/// most 32 lanes per vector, so their masks fit in 'unsigned' (AVX-512
+/// needs BW and VL for them, otherwise they use AVX2). Their gathers are
+/// scalar, as there are no 8-bit or 16-bit gather instructions.
+#if defined( __AVX512BW__ ) && defined( __AVX512VL__ )
+
+template<>
+struct _q_ary_simd_ops< std::int16_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 32;
+	typedef __m512i vec_t;
+	static inline vec_t broadcast( std::int16_t q )
+		{ return _mm512_set1_epi16( q ); }
+	static inline vec_t load( const std::int16_t* p )
+		{ return _mm512_loadu_si512( p ); }
+	static inline vec_t load_partial( const std::int16_t* p, unsigned n )
+		{ return _mm512_maskz_loadu_epi16( (__mmask32)((1ull << n) - 1), p ); }
+	static inline vec_t gather( const std::int16_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		return Strict ? _mm512_cmplt_epi16_mask( x, q )
+				: _mm512_cmple_epi16_mask( x, q );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< std::int8_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 32;
+	typedef __m256i vec_t;
+	static inline vec_t broadcast( std::int8_t q )
+		{ return _mm256_set1_epi8( q ); }
+	static inline vec_t load( const std::int8_t* p )
+		{ return _mm256_loadu_si256( (const __m256i*)p ); }
+	static inline vec_t load_partial( const std::int8_t* p, unsigned n )
+		{ return _mm256_maskz_loadu_epi8( (__mmask32)((1ull << n) - 1), p ); }
+	static inline vec_t gather( const std::int8_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		return Strict ? _mm256_cmplt_epi8_mask( x, q )
+				: _mm256_cmple_epi8_mask( x, q );
+	}
+};
+
+#elif defined( __AVX2__ )
+
+template<>
+struct _q_ary_simd_ops< std::int16_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 16;
+	typedef __m256i vec_t;
+	static inline vec_t broadcast( std::int16_t q )
+		{ return _mm256_set1_epi16( q ); }
+	static inline vec_t load( const std::int16_t* p )
+		{ return _mm256_loadu_si256( (const __m256i*)p ); }
+	static inline vec_t load_partial( const std::int16_t* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const std::int16_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		const __m256i result = Strict ? _mm256_cmpgt_epi16( q, x )
+				: _mm256_xor_si256( _mm256_cmpgt_epi16( x, q ), _mm256_set1_epi16( -1 ) );
+		// Packed to bytes within each 128-bit half, so lanes 0-7 are bits
+		// 0-7 of the byte mask, and lanes 8-15 are bits 16-23
+		const unsigned bytes = (unsigned)_mm256_movemask_epi8( _mm256_packs_epi16( result, result ) );
+		return (bytes & 0xFFu) | ((bytes >> 8) & 0xFF00u);
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< std::int8_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 32;
+	typedef __m256i vec_t;
+	static inline vec_t broadcast( std::int8_t q )
+		{ return _mm256_set1_epi8( q ); }
+	static inline vec_t load( const std::int8_t* p )
+		{ return _mm256_loadu_si256( (const __m256i*)p ); }
+	static inline vec_t load_partial( const std::int8_t* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const std::int8_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		const __m256i result = Strict ? _mm256_cmpgt_epi8( q, x )
+				: _mm256_xor_si256( _mm256_cmpgt_epi8( x, q ), _mm256_set1_epi8( -1 ) );
+		return (unsigned)_mm256_movemask_epi8( result );
+	}
+};
+
+#elif defined( __SSE2__ )
+
+template<>
+struct _q_ary_simd_ops< std::int16_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 8;
+	typedef __m128i vec_t;
+	static inline vec_t broadcast( std::int16_t q )
+		{ return _mm_set1_epi16( q ); }
+	static inline vec_t load( const std::int16_t* p )
+		{ return _mm_loadu_si128( (const __m128i*)p ); }
+	static inline vec_t load_partial( const std::int16_t* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const std::int16_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		const __m128i result = Strict ? _mm_cmpgt_epi16( q, x )
+				: _mm_xor_si128( _mm_cmpgt_epi16( x, q ), _mm_set1_epi16( -1 ) );
+		return (unsigned)_mm_movemask_epi8( _mm_packs_epi16( result, result ) ) & 0xFFu;
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< std::int8_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 16;
+	typedef __m128i vec_t;
+	static inline vec_t broadcast( std::int8_t q )
+		{ return _mm_set1_epi8( q ); }
+	static inline vec_t load( const std::int8_t* p )
+		{ return _mm_loadu_si128( (const __m128i*)p ); }
+	static inline vec_t load_partial( const std::int8_t* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const std::int8_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		const __m128i result = Strict ? _mm_cmpgt_epi8( q, x )
+				: _mm_xor_si128( _mm_cmpgt_epi8( x, q ), _mm_set1_epi8( -1 ) );
+		return (unsigned)_mm_movemask_epi8( result );
+	}
+};
+
+#elif defined( __ARM_NEON ) && defined( __aarch64__ )
+
+template<>
+struct _q_ary_simd_ops< std::int16_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 8;
+	typedef int16x8_t vec_t;
+	static inline vec_t broadcast( std::int16_t q )
+		{ return vdupq_n_s16( q ); }
+	static inline vec_t load( const std::int16_t* p )
+		{ return vld1q_s16( p ); }
+	static inline vec_t load_partial( const std::int16_t* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const std::int16_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		static const uint16_t bits[ 8 ] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+		const uint16x8_t result = Strict ? vcltq_s16( x, q ) : vcleq_s16( x, q );
+		return vaddvq_u16( vandq_u16( result, vld1q_u16( bits ) ) );
+	}
+};
+
+template<>
+struct _q_ary_simd_ops< std::int8_t > {
+	static constexpr bool enabled = true;
+	static constexpr unsigned lanes = 16;
+	typedef int8x16_t vec_t;
+	static inline vec_t broadcast( std::int8_t q )
+		{ return vdupq_n_s8( q ); }
+	static inline vec_t load( const std::int8_t* p )
+		{ return vld1q_s8( p ); }
+	static inline vec_t load_partial( const std::int8_t* p, unsigned n )
+		{ return _q_ary_simd_scalar_load_partial< _q_ary_simd_ops >( p, n ); }
+	static inline vec_t gather( const std::int8_t* p, length_t stride, unsigned n )
+		{ return _q_ary_simd_scalar_gather< _q_ary_simd_ops >( p, stride, n ); }
+	template< bool Strict >
+	static inline unsigned mask( vec_t x, vec_t q ) {
+		static const uint8_t bits[ 16 ] = {
+				1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+		const uint8x16_t result = vandq_u8(
+				Strict ? vcltq_s8( x, q ) : vcleq_s8( x, q ), vld1q_u8( bits ) );
+		return vaddv_u8( vget_low_u8( result ) )
+				| ((unsigned)vaddv_u8( vget_high_u8( result ) ) << 8);
+	}
+};
+
+#endif
+
+
+/// Tells whether predicate 'PredT' can be evaluated by vector
+/// comparisons. Only 'std::less' (for lower bound) and 'std::less_equal'
+/// (for upper bound) can, as those are the ones we know the meaning of.
+template< typename PredT, typename ValueT >
+struct _q_ary_simd_predicate {
+	static constexpr bool enabled = false;
+};
+
+template< typename ValueT >
+struct _q_ary_simd_predicate< std::less< ValueT >, ValueT > {
+	static constexpr bool enabled = true;
+	static constexpr bool strict = true;
+};
+
+template< typename ValueT >
+struct _q_ary_simd_predicate< std::less_equal< ValueT >, ValueT > {
+	static constexpr bool enabled = true;
+	static constexpr bool strict = false;
+};
+
+
+/// Tells whether the SIMD kernel can be used for searching 'q' of type
+/// 'ValueT' by 'pred' of type 'PredT' in the range given by iterators
+/// of type 'RanIt'.
+/// That requires the range to be contiguous, so 'RanIt' must be a plain
+/// pointer to 'ValueT'.
+template< typename RanIt, typename ValueT, typename PredT >
+struct _q_ary_simd_applicable {
+	static constexpr bool value =
+			std::is_pointer< RanIt >::value
+			&& std::is_same<
+					typename std::remove_cv<
+							typename std::remove_pointer< RanIt >::type >::type,
+					ValueT >::value
+			&& _q_ary_simd_ops< ValueT >::enabled
+			&& _q_ary_simd_predicate< PredT, ValueT >::enabled;
+};
+
+
+/// Where the SIMD kernels find the keys, when searching 'q' of type
+/// 'ValueT' by 'pred' of type 'PredT' in the range given by iterators of
+/// type 'RanIt': key of the value at 'it' is at 'keys(it, pred)', and
+/// keys of consecutive values are 'scale' keys apart.
+/// These are the values themselves for the ranges, the SIMD kernel is
+/// applicable to (see '_q_ary_simd_applicable').
+template< typename RanIt, typename ValueT, typename PredT >
+struct _q_ary_simd_keys {
+	static constexpr bool enabled = _q_ary_simd_applicable< RanIt, ValueT, PredT >::value;
+	static constexpr bool strict = _q_ary_simd_predicate< PredT, ValueT >::strict;
+	static constexpr length_t scale = 1;
+	static const ValueT* keys( RanIt it, const PredT& )
+		{ return it; }
+};
+
+/// Keys of contiguous records, searched by projection to a data member
+/// of type 'ValueT', with 'std::less' (both for lower and upper bound),
+/// are the data members themselves, so they are gathered from the records
+/// in place, whenever record size is a multiple of the key size.
+template< typename RecordT, typename ValueT, typename MemberT, typename ClassT, bool Upper >
+struct _q_ary_simd_keys< RecordT*, ValueT,
+		q_ary_projected_pred< std::less< ValueT >, MemberT ClassT::*, Upper > > {
+	typedef q_ary_projected_pred< std::less< ValueT >, MemberT ClassT::*, Upper > pred_t;
+	static constexpr bool enabled =
+			std::is_same< typename std::remove_cv< RecordT >::type, ClassT >::value
+			&& std::is_same< typename std::remove_cv< MemberT >::type, ValueT >::value
+			&& _q_ary_simd_ops< ValueT >::enabled
+			&& sizeof(RecordT) % sizeof(ValueT) == 0;
+	static constexpr bool strict = ! Upper;
+	static constexpr length_t scale = (length_t)(sizeof(RecordT) / sizeof(ValueT));
+	static const ValueT* keys( RecordT* it, const pred_t& pred )
+		{ return std::addressof( it->*pred._proj ); }
+};
+
+
+/// Counts how many of the 'n' values 'p[k*stride]', for 'k' in [0, n),
+/// are less than (or less-or-equal to, when not 'Strict') 'q'.
+template< bool Strict, unsigned N, typename V >
+inline length_t _q_ary_simd_count_strided(
+		const V* p, length_t stride, const V& q )
+{
+	typedef _q_ary_simd_ops< V > ops;
+	const typename ops::vec_t q_vec = ops::broadcast( q );
+	length_t count = 0;
+	for ( unsigned k = 0; k < N; k += ops::lanes ) {
+		const unsigned n = (N - k < ops::lanes) ? (N - k) : ops::lanes;
+		const unsigned mask = ops::template mask< Strict >(
+				ops::gather( p + k * stride, stride, n ), q_vec );
+		count += __builtin_popcount( mask & (unsigned)((1ull << n) - 1) );
+	}
+	return count;
+}
+
+/// Counts how many of the 'length' consecutive values, starting
+/// from 'p', are less than (or less-or-equal to, when not 'Strict') 'q'.
+/// As the values are sorted, that is the position of the first one,
+/// which is not.
+template< bool Strict, typename V, typename LengthT >
+inline LengthT _q_ary_simd_count_contiguous(
+		const V* p, LengthT length, const V& q )
+{
+	typedef _q_ary_simd_ops< V > ops;
+	const typename ops::vec_t q_vec = ops::broadcast( q );
+	LengthT count = 0;
+	LengthT i = 0;
+	for ( ; i + ops::lanes <= length; i += ops::lanes )
+		count += __builtin_popcount(
+				ops::template mask< Strict >( ops::load( p + i ), q_vec ) );
+	// The remainder, by one masked vector
+	if ( i < length ) {
+		const unsigned n = (unsigned)(length - i);
+		count += __builtin_popcount( (unsigned)((1ull << n) - 1) &
+				ops::template mask< Strict >( ops::load_partial( p + i, n ), q_vec ) );
+	}
+	return count;
+}
+
+
+/// Counts how many of the 'length' values 'p[k*stride]', for 'k' in
+/// [0, length), are less than (or less-or-equal to, when not 'Strict') 'q'.
+template< bool Strict, typename V, typename LengthT >
+inline LengthT _q_ary_simd_count_strided(
+		const V* p, length_t stride, LengthT length, const V& q )
+{
+	typedef _q_ary_simd_ops< V > ops;
+	const typename ops::vec_t q_vec = ops::broadcast( q );
+	LengthT count = 0;
+	for ( LengthT k = 0; k < length; k += ops::lanes ) {
+		const unsigned n = (length - k < ops::lanes) ? (unsigned)(length - k) : ops::lanes;
+		const unsigned mask = ops::template mask< Strict >(
+				ops::gather( p + k * stride, stride, n ), q_vec );
+		count += __builtin_popcount( mask & (unsigned)((1ull << n) - 1) );
+	}
+	return count;
+}
+
+/// Linear search of the SIMD kernels, in range {begin, length}, whose
+/// keys are given by 'KeysT' (see '_q_ary_simd_keys').
+template< typename KeysT, typename RanIt, typename LengthT, typename ValueT, typename PredT >
+inline RanIt _q_ary_simd_finish(
+		RanIt begin, LengthT length,
+		const ValueT& q,
+		const PredT& pred )
+{
+	if ( length == 0 )
+		return begin;
+	if constexpr ( KeysT::scale == 1 )
+		return begin + _q_ary_simd_count_contiguous< KeysT::strict >(
+				KeysT::keys( begin, pred ), length, q );
+	else
+		return begin + _q_ary_simd_count_strided< KeysT::strict >(
+				KeysT::keys( begin, pred ), KeysT::scale, length, q );
+}
+
+
+/// Policy of a Q-ary step, which compares the query with all the Q-1
+/// pivots by vector instructions (a gather and a compare), and takes
+/// the popcount of the resulting mask as index of the fragment, into
+/// which we dive. The linear search at the end is vectorized as well.
+/// It is applicable to contiguous ranges of 'int8_t', 'int16_t', 'int32_t',
+/// 'int64_t', 'float' and 'double' searched with 'std::less' or
+/// 'std::less_equal' (i.e. by lower bound and upper bound), and to contiguous records of such keys,
+/// searched by projection to the key data member (e.g. by
+/// 'q_ary_lower_bound< Q >( begin, end, q, std::less< V >(), &record_t::key )'),
+/// whose keys are gathered in place; for everything else it falls back to
+/// 'q_ary_branchless_step'. So do the steps on ranges, longer than
+/// 'length_t' can represent, whose pivots are too far apart for gathers.
+struct q_ary_simd_step {
+	template< unsigned Q, typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline void step(
+			RanIt& begin, LengthT& length,
+			LengthT fragment_length,
+			const ValueT& q,
+			PredT& pred )
+	{
+		typedef _q_ary_simd_keys< RanIt, ValueT, PredT > keys_t;
+		if constexpr ( keys_t::enabled && sizeof(LengthT) <= sizeof(length_t) ) {
+			// Key offsets of all the pivots must fit in 'length_t'
+			if ( length <= std::numeric_limits< length_t >::max() / keys_t::scale ) {
+				const length_t count = _q_ary_simd_count_strided< keys_t::strict, Q - 1 >(
+						keys_t::keys( begin + fragment_length, pred ),
+						fragment_length * keys_t::scale, q );
+				begin += count * fragment_length;
+				// The last fragment is longer than the others
+				length = (count == Q - 1)
+						? length - (Q - 1) * fragment_length
+						: fragment_length;
+				return;
+			}
+		}
+		q_ary_branchless_step::step< Q >( begin, length, fragment_length, q, pred );
+	}
+
+	template< typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline RanIt finish(
+			RanIt begin, LengthT length,
+			const ValueT& q,
+			PredT& pred )
+	{
+		typedef _q_ary_simd_keys< RanIt, ValueT, PredT > keys_t;
+		if constexpr ( keys_t::enabled )
+			return _q_ary_simd_finish< keys_t >( begin, length, q, pred );
+		else
+			return q_ary_branchless_step::finish( begin, length, q, pred );
+	}
+};
+
+
+/// Policy of a Q-ary step, which wraps another policy 'StepT' (whose
+/// steps it evaluates), and vectorizes the linear search at the end, as
+/// 'q_ary_simd_step' does, for the same types and predicates.
+/// One vector compare, over a window of 'Width' values (by default, one
+/// cache line), costs about as much as one more Q-ary step, so the
+/// default parameters with this policy (and with 'q_ary_simd_step')
+/// switch to linear search at that width, rather than at '2*Q'.
+template< typename StepT = q_ary_branchless_step, unsigned Width = 0 >
+struct q_ary_simd_tail_step {
+	template< unsigned Q, typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline void step(
+			RanIt& begin, LengthT& length,
+			LengthT fragment_length,
+			const ValueT& q,
+			PredT& pred )
+		{ StepT::template step< Q >( begin, length, fragment_length, q, pred ); }
+
+	template< typename RanIt, typename LengthT, typename ValueT, typename PredT >
+	static inline RanIt finish(
+			RanIt begin, LengthT length,
+			const ValueT& q,
+			PredT& pred )
+	{
+		typedef _q_ary_simd_keys< RanIt, ValueT, PredT > keys_t;
+		if constexpr ( keys_t::enabled )
+			return _q_ary_simd_finish< keys_t >( begin, length, q, pred );
+		else
+			return StepT::finish( begin, length, q, pred );
+	}
+};
+
+
+/// Default parameters of Q-ary search with vectorized linear search over
+/// 'Width' values (or one cache line, if 0): linear search starts once
+/// the range fits in that width (but not below 'Q').
+template< unsigned Q, unsigned Width,
+		typename RanIt, typename ValueT, typename PredT >
+struct _q_ary_simd_tail_parameters {
+	static constexpr length_t width = Width ? Width : (length_t)(64 / sizeof(ValueT));
+	typedef typename std::conditional<
+			_q_ary_simd_applicable< RanIt, ValueT, PredT >::value,
+			q_ary_static_parameters< (width + 1 > Q ? width + 1 : Q) >,
+			q_ary_default_parameters< Q > >::type type;
+};
+
+template< unsigned Q, typename RanIt, typename ValueT, typename PredT >
+struct q_ary_step_parameters< Q, q_ary_simd_step, RanIt, ValueT, PredT >
+	: _q_ary_simd_tail_parameters< Q, 0, RanIt, ValueT, PredT > {};
+
+template< unsigned Q, typename StepT, unsigned Width,
+		typename RanIt, typename ValueT, typename PredT >
+struct q_ary_step_parameters< Q, q_ary_simd_tail_step< StepT, Width >, RanIt, ValueT, PredT >
+	: _q_ary_simd_tail_parameters< Q, Width, RanIt, ValueT, PredT > {};
+
+
+} // inline namespace ML__ALGORITHM__Q_ARY_ISA_NAMESPACE
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_SEARCH_SIMD_HPP
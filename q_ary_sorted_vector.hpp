@@ -0,0 +1,320 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_SORTED_VECTOR_HPP
+#define ML__ALGORITHM__Q_ARY_SORTED_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_allocator.hpp"
+#include "q_ary_rcu.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Default count of inserted values, which 'q_ary_sorted_vector' buffers
+/// before it merges them into the delta.
+constexpr std::size_t q_ary_sorted_vector_batch_size = 256;
+
+
+/// Sorted container of values of type 'T', for tables which change slowly:
+/// a sorted base array (with an index over it, if 'IndexT' is given, e.g.
+/// 'q_ary_eytzinger_index< T >', 'q_ary_static_tree< T >' or
+/// 'q_ary_learned_index< T >'), plus a small sorted delta array of the
+/// values inserted since the base was built.
+/// The visible state is an immutable 'version', which readers take by
+/// 'snapshot()' and search without any lock: the base by the index (or by
+/// 'q_ary_search< Q, StepT >()'), and the delta by 'q_ary_search()', and
+/// their ranks are added up.
+/// Inserted values are buffered, and merged into the delta (as a new
+/// version, in O(delta) time) by batches of 'batch_size', or by
+/// 'flush()'; they are visible only after that.
+/// Once the delta grows longer than '1 / RebuildRatio' of the base, the
+/// base is merged with it, and its index is rebuilt, on a background
+/// thread (unless 'background' is off), while readers keep searching the
+/// old versions, and writers keep merging into the delta. The rebuilt
+/// base is published with the values, inserted meanwhile, as the delta.
+/// Versions are published by 'q_ary_rcu_pointer', so taking a snapshot is
+/// a compare and swap on a reader slot of its own, and a replaced version
+/// is freed once its last reader has left. Versions share their base (by
+/// 'std::shared_ptr', whose counter only the writers touch).
+template< typename T,
+		typename IndexT = void,
+		unsigned Q = 4,
+		typename StepT = q_ary_branchy_step,
+		unsigned RebuildRatio = 16,
+		typename Alloc = q_ary_aligned_allocator< T > >
+class q_ary_sorted_vector
+{
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+
+	/// If the base is searched by an index.
+	static constexpr bool indexed = ! std::is_void< IndexT >::value;
+
+protected:
+	/// Stand-in for the index type, when there is none.
+	struct no_index_t {
+		template< typename RanIt >
+		void build( RanIt, RanIt )
+			{}
+	};
+	typedef typename std::conditional< indexed, IndexT, no_index_t >::type index_t;
+
+	/// The sorted base array, and the index over it (which may refer to
+	/// the array, so it is never moved after the index is built).
+	struct base_t {
+		std::vector< T, Alloc > _values;
+		index_t _index;
+
+		template< typename PredT >
+		size_type search( const T& q, PredT pred ) const
+		{
+			if constexpr ( indexed )
+				return _index.search( q, pred );
+			else
+				return (size_type)(q_ary_search< Q, StepT >(
+						_values.data(), _values.data() + _values.size(), q, pred )
+						- _values.data());
+		}
+	};
+
+public:
+	/// Immutable state of the container.
+	class version
+	{
+		friend class q_ary_sorted_vector;
+
+	protected:
+		std::shared_ptr< const base_t > _base;
+		std::vector< T, Alloc > _delta;
+
+	public:
+		/// Count of the values.
+		size_type size() const
+			{ return _base->_values.size() + _delta.size(); }
+
+		bool empty() const
+			{ return size() == 0; }
+
+		/// Count of the values in the base.
+		size_type base_size() const
+			{ return _base->_values.size(); }
+
+		/// Count of the values in the delta.
+		size_type delta_size() const
+			{ return _delta.size(); }
+
+		/// Returns rank of the first value 'v' in the sorted order of all
+		/// the values, for which 'pred(v, q)' is not satisfied.
+		template< typename PredT >
+		size_type search( const T& q, PredT pred ) const
+			{ return _base->search( q, pred )
+					+ (size_type)(q_ary_search< Q, StepT >(
+							_delta.data(), _delta.data() + _delta.size(), q, pred )
+							- _delta.data()); }
+
+		/// Returns rank of the first value, which is not less than 'q'.
+		size_type lower_bound( const T& q ) const
+			{ return search( q, std::less< T >() ); }
+
+		/// Returns rank of the first value, which is greater than 'q'.
+		size_type upper_bound( const T& q ) const
+			{ return search( q, std::less_equal< T >() ); }
+
+		/// Returns the count of values, equal to 'q'.
+		size_type count( const T& q ) const
+			{ return upper_bound( q ) - lower_bound( q ); }
+
+		/// Checks if 'q' is present.
+		bool contains( const T& q ) const
+			{ return count( q ) != 0; }
+	};
+
+	/// Snapshot of a version, which stays valid (and unchanged) while it
+	/// is held (see 'q_ary_rcu_snapshot').
+	typedef typename q_ary_rcu_pointer< version >::snapshot_type snapshot_type;
+
+protected:
+	/// The current version.
+	q_ary_rcu_pointer< version > _current;
+	/// State of the writers.
+	std::mutex _write_mutex;
+	std::vector< T > _pending;
+	size_type _batch_size;
+	bool _background;
+	std::thread _rebuild_thread;
+	bool _rebuilding = false;
+
+public:
+	/// Empty container.
+	explicit q_ary_sorted_vector(
+			size_type batch_size = q_ary_sorted_vector_batch_size,
+			bool background = true )
+		: _batch_size( batch_size ), _background( background )
+		{ _publish( _make_base( nullptr, nullptr ), {} ); }
+
+	/// Container of the values [begin, end) (in any order).
+	template< typename InIt >
+	q_ary_sorted_vector( InIt begin, InIt end,
+			size_type batch_size = q_ary_sorted_vector_batch_size,
+			bool background = true )
+		: _batch_size( batch_size ), _background( background )
+	{
+		std::vector< T > values( begin, end );
+		std::sort( values.begin(), values.end() );
+		_publish( _make_base( values.data(), values.data() + values.size() ), {} );
+	}
+
+	q_ary_sorted_vector( const q_ary_sorted_vector& ) = delete;
+	q_ary_sorted_vector& operator=( const q_ary_sorted_vector& ) = delete;
+
+	~q_ary_sorted_vector()
+		{ wait(); }
+
+	/// Takes a snapshot of the current version.
+	snapshot_type snapshot() const
+		{ return _current.snapshot(); }
+
+	/// Shortcuts, which search the current version.
+	size_type size() const
+		{ return snapshot()->size(); }
+	size_type lower_bound( const T& q ) const
+		{ return snapshot()->lower_bound( q ); }
+	size_type upper_bound( const T& q ) const
+		{ return snapshot()->upper_bound( q ); }
+	size_type count( const T& q ) const
+		{ return snapshot()->count( q ); }
+	bool contains( const T& q ) const
+		{ return snapshot()->contains( q ); }
+
+	/// Inserts 'value' (visible once its batch is merged).
+	void insert( const T& value )
+	{
+		std::lock_guard< std::mutex > lock( _write_mutex );
+		_pending.push_back( value );
+		if ( _pending.size() >= _batch_size )
+			_flush();
+	}
+
+	/// Inserts the values [begin, end).
+	template< typename InIt >
+	void insert( InIt begin, InIt end )
+	{
+		std::lock_guard< std::mutex > lock( _write_mutex );
+		_pending.insert( _pending.end(), begin, end );
+		if ( _pending.size() >= _batch_size )
+			_flush();
+	}
+
+	/// Merges the buffered values into the delta, so they become visible.
+	void flush()
+	{
+		std::lock_guard< std::mutex > lock( _write_mutex );
+		_flush();
+	}
+
+	/// Waits for the background rebuild (if any) to be published.
+	void wait()
+	{
+		std::thread rebuild_thread;
+		{
+			std::lock_guard< std::mutex > lock( _write_mutex );
+			rebuild_thread.swap( _rebuild_thread );
+		}
+		if ( rebuild_thread.joinable() )
+			rebuild_thread.join();
+	}
+
+protected:
+	/// Makes a base of the sorted values [begin, end).
+	static std::shared_ptr< base_t > _make_base( const T* begin, const T* end )
+	{
+		const std::shared_ptr< base_t > base = std::make_shared< base_t >();
+		base->_values.assign( begin, end );
+		base->_index.build( base->_values.data(), base->_values.data() + base->_values.size() );
+		return base;
+	}
+
+	/// Makes the version of 'base' and sorted 'delta' current.
+	void _publish( std::shared_ptr< const base_t > base, std::vector< T, Alloc > delta )
+	{
+		std::unique_ptr< version > next( new version );
+		next->_base = std::move( base );
+		next->_delta = std::move( delta );
+		_current.publish( std::move( next ) );
+	}
+
+	/// Merges the buffered values into the delta (under '_write_mutex').
+	void _flush()
+	{
+		if ( _pending.empty() )
+			return;
+		std::sort( _pending.begin(), _pending.end() );
+		const version* current = _current.get();
+		std::vector< T, Alloc > delta( current->_delta.size() + _pending.size() );
+		std::merge( current->_delta.begin(), current->_delta.end(),
+				_pending.begin(), _pending.end(), delta.begin() );
+		_pending.clear();
+		_publish( current->_base, std::move( delta ) );
+		// Rebuild the base, if the delta is too long
+		current = _current.get();
+		if ( ! _rebuilding && _delta_too_long( *current ) ) {
+			_rebuilding = true;
+			if ( _rebuild_thread.joinable() )
+				_rebuild_thread.join();  // Finished already
+			// So the rebuild doesn't hold the version itself
+			std::shared_ptr< const base_t > from_base = current->_base;
+			std::vector< T, Alloc > from_delta = current->_delta;
+			if ( _background )
+				_rebuild_thread = std::thread(
+						[this, from_base = std::move( from_base ), from_delta = std::move( from_delta )]()
+						{ _rebuild( *from_base, from_delta ); } );
+			else
+				_rebuild( *from_base, from_delta, false );
+		}
+	}
+
+	static bool _delta_too_long( const version& v )
+		{ return v._delta.size() * RebuildRatio > v._base->_values.size(); }
+
+	/// Merges base 'from_base' with delta 'from_delta' (of a version), and
+	/// publishes the result, with the values merged into the delta since
+	/// then.
+	void _rebuild( const base_t& from_base, const std::vector< T, Alloc >& from_delta,
+			bool lock_writers = true )
+	{
+		std::vector< T > values( from_base._values.size() + from_delta.size() );
+		std::merge( from_base._values.begin(), from_base._values.end(),
+				from_delta.begin(), from_delta.end(), values.begin() );
+		std::shared_ptr< const base_t > base =
+				_make_base( values.data(), values.data() + values.size() );
+		std::unique_lock< std::mutex > lock( _write_mutex, std::defer_lock );
+		if ( lock_writers )
+			lock.lock();
+		// 'from_delta' is a part of the current one
+		const version* current = _current.get();
+		std::vector< T, Alloc > delta;
+		delta.reserve( current->_delta.size() - from_delta.size() );
+		std::set_difference( current->_delta.begin(), current->_delta.end(),
+				from_delta.begin(), from_delta.end(), std::back_inserter( delta ) );
+		_publish( std::move( base ), std::move( delta ) );
+		_rebuilding = false;
+	}
+};
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_SORTED_VECTOR_HPP
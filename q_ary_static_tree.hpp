@@ -0,0 +1,243 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_STATIC_TREE_HPP
+#define ML__ALGORITHM__Q_ARY_STATIC_TREE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_search_simd.hpp"
+#include "q_ary_allocator.hpp"
+
+namespace ml {
+namespace algorithm {
+inline namespace ML__ALGORITHM__Q_ARY_ISA_NAMESPACE {
+
+
+/// Size of one node of 'q_ary_static_tree', in bytes: one cache line,
+/// or two of them when AVX-512 is enabled (as a node is compared with
+/// the query by a couple of vector instructions anyway).
+#if defined( __AVX512F__ )
+constexpr std::size_t q_ary_static_tree_node_size = 2 * q_ary_cache_line_size;
+#else
+constexpr std::size_t q_ary_static_tree_node_size = q_ary_cache_line_size;
+#endif
+
+/// Default count of keys in one node of 'q_ary_static_tree' over values
+/// of type 'T': as many, as fit in 'q_ary_static_tree_node_size' bytes
+/// (e.g. 16 'int32_t' keys in 64 bytes).
+template< typename T >
+constexpr unsigned q_ary_static_tree_fan_out()
+	{ return sizeof(T) * 2 <= q_ary_static_tree_node_size
+			? (unsigned)(q_ary_static_tree_node_size / sizeof(T))
+			: 2; }
+
+
+/// Read-only static B+-tree (S+-tree) over a sorted array, with
+/// nodes of 'B' keys and 'B+1' children, laid out implicitly: child 'j' of
+/// node 'k' is node 'k*(B+1) + j' of the level below, so no pointers are
+/// stored.
+/// The bottom level is a copy of the sorted array itself, while every
+/// key of upper levels is the smallest key of the subtree to its right.
+/// One visit of a node is one Q-ary step with Q=B+1, whose pivots are
+/// contiguous, and are compared with the query by 'StepT::finish()'
+/// (by the vector kernel, by default); wrapping it by
+/// 'q_ary_prefetching_step' enables prefetching of the next levels.
+/// Search results are ranks in the original sorted array.
+template< typename T,
+		unsigned B = q_ary_static_tree_fan_out< T >(),
+		typename StepT = q_ary_simd_step,
+		typename Alloc = q_ary_aligned_allocator< T > >
+class q_ary_static_tree
+{
+	static_assert( B >= 2, "Static tree needs at least 2 keys per node." );
+
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+
+	/// Count of keys, stored in one node.
+	static constexpr unsigned keys_per_node = B;
+	/// How many levels ahead nodes are prefetched (see 'q_ary_prefetching_step').
+	static constexpr unsigned prefetch_distance = q_ary_prefetch_distance< StepT >::value;
+
+protected:
+	/// Length of the original array.
+	size_type _size = 0;
+	/// Nodes of all the levels, the root level first.
+	std::vector< T, Alloc > _nodes;
+	/// For every level, from the bottom (leaves) up: the offset of its
+	/// first node in '_nodes', and the count of its nodes.
+	struct level_t {
+		size_type _offset;
+		size_type _count;
+	};
+	std::vector< level_t > _levels;
+
+public:
+	q_ary_static_tree() = default;
+
+	/// Builds the tree over sorted range [begin, end).
+	template< typename RanIt >
+	q_ary_static_tree( RanIt begin, RanIt end )
+		{ build( begin, end ); }
+
+	/// Rebuilds the tree over sorted range [begin, end).
+	template< typename RanIt >
+	void build( RanIt begin, RanIt end )
+	{
+		_size = (size_type)(end - begin);
+		_nodes.clear();
+		_levels.clear();
+		if ( _size == 0 )
+			return;
+		// Shape of the tree
+		size_type total_count = 0;
+		size_type count = (_size + B - 1) / B;
+		for ( ;; ) {
+			_levels.push_back( { 0, count } );
+			total_count += count;
+			if ( count == 1 )
+				break;
+			count = (count + B) / (B + 1);
+		}
+		size_type offset = 0;
+		for ( size_type l = _levels.size(); l-- > 0; ) {
+			_levels[ l ]._offset = offset;
+			offset += _levels[ l ]._count * B;
+		}
+		_nodes.resize( total_count * B );
+		// Leaves, padded by the last key
+		T* leaves = _nodes.data() + _levels[ 0 ]._offset;
+		for ( size_type i = 0; i < _levels[ 0 ]._count * B; ++i )
+			leaves[ i ] = *(begin + (i < _size ? i : _size - 1));
+		// Upper levels: key 'j' of a node is the first key of its child 'j+1'
+		size_type leaves_per_child = 1;  // Count of leaves in subtree of a level's child
+		for ( size_type l = 1; l < _levels.size(); ++l ) {
+			T* node = _nodes.data() + _levels[ l ]._offset;
+			for ( size_type k = 0; k < _levels[ l ]._count; ++k )
+				for ( unsigned j = 0; j < B; ++j, ++node ) {
+					const size_type leaf = (k * (B + 1) + j + 1) * leaves_per_child;
+					*node = leaf < _levels[ 0 ]._count
+							? leaves[ leaf * B ]
+							: leaves[ _size - 1 ];
+				}
+			leaves_per_child *= B + 1;
+		}
+	}
+
+	/// Length of the original array.
+	size_type size() const
+		{ return _size; }
+
+	bool empty() const
+		{ return _size == 0; }
+
+	/// Count of levels of the tree.
+	size_type height() const
+		{ return _levels.size(); }
+
+	/// Nodes of all the levels, the root level first (for copying the
+	/// tree elsewhere, e.g. to a GPU).
+	const T* nodes() const
+		{ return _nodes.data(); }
+
+	/// Count of keys in all the nodes.
+	size_type nodes_size() const
+		{ return _nodes.size(); }
+
+	/// Offset in 'nodes()' of the first key of level 'l' (counted from
+	/// the bottom, the leaves being level 0).
+	size_type level_offset( size_type l ) const
+		{ return _levels[ l ]._offset; }
+
+	/// Count of nodes of level 'l'.
+	size_type level_count( size_type l ) const
+		{ return _levels[ l ]._count; }
+
+	/// Returns rank of the first value 'v' of the original array,
+	/// for which 'pred(v, q)' is not satisfied.
+	template< typename PredT >
+	size_type search( const T& q, PredT pred ) const
+	{
+		if ( _size == 0 )
+			return 0;
+		const T* nodes = _nodes.data();
+		size_type k = 0;  // Node in the current level
+		for ( size_type l = _levels.size() - 1; l > 0; --l ) {
+			const T* node = nodes + _levels[ l ]._offset + k * B;
+			if constexpr ( prefetch_distance > 0 ) {
+				// Descendants of the node at 'prefetch_distance' levels below
+				// are contiguous
+				if ( l >= prefetch_distance ) {
+					const level_t& target = _levels[ l - prefetch_distance ];
+					size_type first = k, count = 1;
+					for ( unsigned j = 0; j < prefetch_distance; ++j ) {
+						first *= B + 1;
+						count *= B + 1;
+					}
+					if ( first < target._count ) {
+						if ( count > target._count - first )
+							count = target._count - first;
+						_q_ary_prefetch_range( nodes + target._offset + first * B,
+								count * B * sizeof(T) );
+					}
+				}
+			}
+			const size_type i = (size_type)(
+					StepT::finish( node, (length_t)B, q, pred ) - node );
+			// Children past the end have only padding keys, which are
+			// satisfied only if all the values are, so the last child
+			// gives the same result
+			k = k * (B + 1) + i;
+			const size_type last = _levels[ l - 1 ]._count - 1;
+			k = k < last ? k : last;
+		}
+		const T* leaf = nodes + _levels[ 0 ]._offset + k * B;
+		const size_type rank = k * B + (size_type)(
+				StepT::finish( leaf, (length_t)B, q, pred ) - leaf );
+		return rank < _size ? rank : _size;
+	}
+
+	/// Returns rank of the first value, which is not less than 'q'.
+	size_type lower_bound( const T& q ) const
+		{ return search( q, std::less< T >() ); }
+
+	/// Returns rank of the first value, which is greater than 'q'.
+	size_type upper_bound( const T& q ) const
+		{ return search( q, std::less_equal< T >() ); }
+
+	/// Checks if 'q' is present in the original array.
+	bool contains( const T& q ) const
+		{ const size_type rank = lower_bound( q );
+		  return rank != _size && ! (q < _nodes[ _levels[ 0 ]._offset + rank ]); }
+
+	/// Returns the count of bytes, occupied by the tree.
+	size_type memory_footprint() const
+		{ return sizeof(*this) + _nodes.capacity() * sizeof(T)
+				+ _levels.capacity() * sizeof(level_t); }
+
+	/// Estimates the count of bytes, which a tree over 'n' values would
+	/// occupy (for sizing it in advance, without building).
+	static size_type memory_footprint( size_type n )
+	{
+		size_type total_count = 0, levels = 0;
+		for ( size_type count = (n + B - 1) / B; count > 0; ) {
+			total_count += count;
+			++levels;
+			if ( count == 1 )
+				break;
+			count = (count + B) / (B + 1);
+		}
+		return sizeof(q_ary_static_tree) + total_count * B * sizeof(T)
+				+ levels * sizeof(level_t);
+	}
+};
+
+
+} // inline namespace ML__ALGORITHM__Q_ARY_ISA_NAMESPACE
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_STATIC_TREE_HPP
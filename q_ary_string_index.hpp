@@ -0,0 +1,170 @@
+
+#ifndef ML__ALGORITHM__Q_ARY_STRING_INDEX_HPP
+#define ML__ALGORITHM__Q_ARY_STRING_INDEX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "q_ary_search.hpp"
+#include "q_ary_range_search.hpp"
+#include "q_ary_allocator.hpp"
+
+namespace ml {
+namespace algorithm {
+
+
+/// Count of leading bytes of a string key, which 'q_ary_string_index'
+/// keeps in its prefix array.
+constexpr std::size_t q_ary_string_prefix_bytes = sizeof(std::uint64_t);
+
+
+/// Index over a sorted range of string keys (of 'std::string',
+/// 'std::string_view', or anything convertible to the latter), which
+/// searches a parallel array of their first 8 bytes, packed big-endian
+/// into 64-bit integers (so the integer order is the order of the bytes),
+/// in place of the strings, so that a Q-ary step over it is a few integer
+/// (or vector, by 'q_ary_simd_step') compares, rather than a pointer chase
+/// and a 'memcmp()' per pivot.
+/// The lower and upper bounds of the query's prefix are found by one
+/// descent over the prefix array ('q_ary_search_pair()'); only the keys
+/// between them (with the same prefix as the query) are compared in full,
+/// by a binary search, which tracks the common prefix of the query with
+/// both its bounds, and skips the bytes, which all the keys between them
+/// are known to share with it.
+/// The index refers to the original keys, which must outlive it.
+/// Search results are ranks in the original range, compared as by
+/// 'std::string_view::compare()'.
+template< unsigned Q = 8,
+		typename StepT = q_ary_branchless_step >
+class q_ary_string_index
+{
+public:
+	typedef std::string_view value_type;
+	typedef std::size_t size_type;
+
+protected:
+	/// Prefixes of the keys, with the sign bit flipped, so the signed
+	/// order (of the vector kernels) is the order of the bytes.
+	std::vector< std::int64_t, q_ary_aligned_allocator< std::int64_t > > _prefixes;
+	/// The keys.
+	std::vector< std::string_view > _keys;
+
+public:
+	q_ary_string_index() = default;
+
+	/// Builds the index over sorted range [begin, end).
+	template< typename RanIt >
+	q_ary_string_index( RanIt begin, RanIt end )
+		{ build( begin, end ); }
+
+	/// Rebuilds the index over sorted range [begin, end).
+	template< typename RanIt >
+	void build( RanIt begin, RanIt end )
+	{
+		_keys.assign( begin, end );
+		_prefixes.resize( _keys.size() );
+		for ( size_type i = 0; i < _keys.size(); ++i )
+			_prefixes[ i ] = prefix( _keys[ i ] );
+	}
+
+	/// Length of the original range.
+	size_type size() const
+		{ return _keys.size(); }
+
+	bool empty() const
+		{ return _keys.empty(); }
+
+	/// Returns rank of the first key, which is not less than 'q'.
+	size_type lower_bound( std::string_view q ) const
+		{ return _search< true >( q ); }
+
+	/// Returns rank of the first key, which is greater than 'q'.
+	size_type upper_bound( std::string_view q ) const
+		{ return _search< false >( q ); }
+
+	/// Returns the ranks of the keys, which are equal to 'q'.
+	std::pair< size_type, size_type > equal_range( std::string_view q ) const
+		{ return { lower_bound( q ), upper_bound( q ) }; }
+
+	/// Checks if 'q' is present in the original range.
+	bool contains( std::string_view q ) const
+		{ const size_type rank = lower_bound( q );
+		  return rank != _keys.size() && _keys[ rank ] == q; }
+
+	/// Returns the count of bytes, occupied by the index (without the
+	/// original keys).
+	size_type memory_footprint() const
+		{ return sizeof(*this)
+				+ _prefixes.capacity() * sizeof(std::int64_t)
+				+ _keys.capacity() * sizeof(std::string_view); }
+
+	/// First 8 bytes of 's' (padded by zeros), packed big-endian, with the
+	/// sign bit flipped.
+	static std::int64_t prefix( std::string_view s )
+	{
+		std::uint64_t packed = 0;
+		for ( std::size_t i = 0; i < q_ary_string_prefix_bytes; ++i )
+			packed = packed << 8
+					| (i < s.size() ? (std::uint64_t)(unsigned char)s[ i ] : 0);
+		return (std::int64_t)(packed ^ (std::uint64_t( 1 ) << 63));
+	}
+
+protected:
+	/// Returns rank of the first key, which is not less than 'q' (or not
+	/// less or equal to it, when not 'Strict').
+	template< bool Strict >
+	size_type _search( std::string_view q ) const
+	{
+		const std::int64_t* const prefixes = _prefixes.data();
+		const std::int64_t q_prefix = prefix( q );
+		// Keys [lo, hi) have the prefix of 'q'
+		const std::pair< const std::int64_t*, const std::int64_t* > ties =
+				q_ary_search_pair< Q, StepT >( prefixes, prefixes + _prefixes.size(),
+						q_prefix, std::less< std::int64_t >(),
+						q_prefix, std::less_equal< std::int64_t >() );
+		size_type lo = (size_type)(ties.first - prefixes);
+		size_type hi = (size_type)(ties.second - prefixes);
+		// Common prefixes of 'q' with the bounds: the keys of the same
+		// prefix share at least its bytes, which both have
+		size_type lo_common = std::min( q.size(), q_ary_string_prefix_bytes );
+		size_type hi_common = lo_common;
+		while ( lo < hi ) {
+			const size_type mid = lo + (hi - lo) / 2;
+			const std::string_view key = _keys[ mid ];
+			size_type common = std::min( std::min( lo_common, hi_common ), key.size() );
+			const int order = _compare( key, q, common );
+			if ( Strict ? order < 0 : order <= 0 ) {
+				lo = mid + 1;
+				lo_common = common;
+			}
+			else {
+				hi = mid;
+				hi_common = common;
+			}
+		}
+		return lo;
+	}
+
+	/// Compares 'key' with 'q', whose first 'common' bytes are equal, and
+	/// advances 'common' to the length of their common prefix.
+	static int _compare( std::string_view key, std::string_view q, size_type& common )
+	{
+		const size_type length = std::min( key.size(), q.size() );
+		while ( common < length && key[ common ] == q[ common ] )
+			++common;
+		if ( common < length )
+			return (unsigned char)key[ common ] < (unsigned char)q[ common ] ? -1 : 1;
+		return key.size() < q.size() ? -1 : (key.size() == q.size() ? 0 : 1);
+	}
+};
+
+
+} // namespace algorithm
+} // namespace ml
+
+#endif // ML__ALGORITHM__Q_ARY_STRING_INDEX_HPP